@@ -27,11 +27,23 @@
 
 #define configUSE_TICK_HOOK 0
 
+#define configUSE_TICKLESS_IDLE 1 // Stop the tick and sleep while every task is blocked
+
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2 // Shorter idle periods just WFI with the tick running
+
+// Sleep timing and wake latency, see lowPower.h
+extern void lowPowerPreSleep(uint32_t *expectedIdle);
+extern void lowPowerPostSleep(uint32_t expectedIdle);
+extern void lowPowerTicksStepped(uint32_t ticks);
+#define configPRE_SLEEP_PROCESSING(x) lowPowerPreSleep(&(x))
+#define configPOST_SLEEP_PROCESSING(x) lowPowerPostSleep(x)
+#define traceINCREASE_TICK_COUNT(x) lowPowerTicksStepped(x)
+
 #define configSUPPORT_DYNAMIC_ALLOCATION 1
 
-#define INCLUDE_vTaskPrioritySet 0
+#define INCLUDE_vTaskPrioritySet 1
 
-#define INCLUDE_uxTaskPriorityGet 0
+#define INCLUDE_uxTaskPriorityGet 1
 
 #define INCLUDE_vTaskDelete 1
 
@@ -43,9 +55,9 @@
 
 #define configUSE_TIMERS 1
 
-#define configTIMER_TASK_PRIORITY 1
+#define configTIMER_TASK_PRIORITY (configMAX_PRIORITIES - 1) // Debounce and mode timers run ahead of the tasks
 
-#define configTIMER_QUEUE_LENGTH 5
+#define configTIMER_QUEUE_LENGTH 10 // Room for every input to start its debounce at once
 
 #define configTIMER_TASK_STACK_DEPTH 128
 
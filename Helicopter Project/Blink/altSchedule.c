@@ -0,0 +1,48 @@
+//*****************************************************************************
+//
+// altSchedule - Altitude dependent hover duty and PID gains. Ground effect
+//               and the rig geometry change the duty needed to hover with
+//               height, so the altitude controller looks up its feedforward
+//               duty and gains in a table indexed by altitude. The table in
+//               altScheduleTable.c is generated from logged hover data by
+//               host/genSchedule.
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "altSchedule.h"
+
+
+// *******************************************************
+// altScheduleLookup:   Interpolates the table at an altitude. Altitudes
+//                      outside 0 to 100% use the end entries.
+// TAKES:               altHundredths, the altitude in 0.01%
+//                      schedule, filled with the hover duty and gains
+void altScheduleLookup (int32_t altHundredths, altSchedule_t *schedule)
+{
+    const altSchedulePoint_t *low, *high;
+    uint32_t index;
+    float frac;
+
+    if (altHundredths < 0)
+    {
+        altHundredths = 0;
+    } else if (altHundredths > (ALT_SCHED_POINTS - 1) * ALT_SCHED_STEP) {
+        altHundredths = (ALT_SCHED_POINTS - 1) * ALT_SCHED_STEP;
+    }
+
+    index = altHundredths / ALT_SCHED_STEP;
+    if (index >= ALT_SCHED_POINTS - 1)
+    {
+        index = ALT_SCHED_POINTS - 2;
+    }
+    frac = (altHundredths - (int32_t)index * ALT_SCHED_STEP) * (1.0f / ALT_SCHED_STEP);
+
+    low = &altScheduleTable[index];
+    high = &altScheduleTable[index + 1];
+    schedule->hover = (low->hoverPermille +
+                      (high->hoverPermille - low->hoverPermille) * frac) * 0.1f;
+    schedule->kp = low->kp + (high->kp - low->kp) * frac;
+    schedule->ki = low->ki + (high->ki - low->ki) * frac;
+    schedule->kd = low->kd + (high->kd - low->kd) * frac;
+}
@@ -0,0 +1,52 @@
+#ifndef ALTSCHEDULE_H_
+#define ALTSCHEDULE_H_
+
+//*****************************************************************************
+//
+// altSchedule - Altitude dependent hover duty and PID gains. Ground effect
+//               and the rig geometry change the duty needed to hover with
+//               height, so the altitude controller looks up its feedforward
+//               duty and gains in a table indexed by altitude. The table in
+//               altScheduleTable.c is generated from logged hover data by
+//               host/genSchedule.
+//*****************************************************************************
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define ALT_SCHED_POINTS    11          // Table entries, 0 to 100% altitude
+#define ALT_SCHED_STEP      1000        // Altitude between entries (0.01%)
+
+// *******************************************************
+// One table entry
+typedef struct {
+    int16_t hoverPermille;      // Main duty that holds this altitude
+    float kp;                   // PID gains at this altitude
+    float ki;
+    float kd;
+} altSchedulePoint_t;
+
+// *******************************************************
+// An interpolated schedule, duty in percent
+typedef struct {
+    double hover;
+    double kp;
+    double ki;
+    double kd;
+} altSchedule_t;
+
+// Generated by host/genSchedule
+extern const altSchedulePoint_t altScheduleTable[ALT_SCHED_POINTS];
+
+
+// *******************************************************
+// altScheduleLookup:   Interpolates the table at an altitude. Altitudes
+//                      outside 0 to 100% use the end entries.
+// TAKES:               altHundredths, the altitude in 0.01%
+//                      schedule, filled with the hover duty and gains
+void
+altScheduleLookup (int32_t altHundredths, altSchedule_t *schedule);
+
+#endif /* ALTSCHEDULE_H_ */
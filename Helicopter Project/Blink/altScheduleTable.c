@@ -0,0 +1,27 @@
+//*****************************************************************************
+//
+// altScheduleTable - Altitude schedule used by PIDControlAlt.
+//                    GENERATED by host/genSchedule, do not edit.
+//
+// Source:          hover.log (69 samples)
+// Reference hover: 45.0%, gains 0.500 0.030 0.200
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "altSchedule.h"
+
+const altSchedulePoint_t altScheduleTable[ALT_SCHED_POINTS] = {
+//   hover    kp        ki        kd             altitude
+    { 443, 0.5073f, 0.0304f, 0.2029f},   //   0% (interpolated)
+    { 443, 0.5073f, 0.0304f, 0.2029f},   //  10%
+    { 444, 0.5068f, 0.0304f, 0.2027f},   //  20%
+    { 444, 0.5068f, 0.0304f, 0.2027f},   //  30%
+    { 447, 0.5034f, 0.0302f, 0.2013f},   //  40%
+    { 441, 0.5108f, 0.0306f, 0.2043f},   //  50%
+    { 444, 0.5068f, 0.0304f, 0.2027f},   //  60%
+    { 442, 0.5096f, 0.0306f, 0.2039f},   //  70%
+    { 449, 0.5011f, 0.0301f, 0.2004f},   //  80%
+    { 459, 0.4902f, 0.0294f, 0.1961f},   //  90% (interpolated)
+    { 469, 0.4797f, 0.0288f, 0.1919f},   // 100%
+};
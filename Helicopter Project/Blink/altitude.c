@@ -1,11 +1,12 @@
-#define RANGE_ALTITUDE      (1000*4095/3300)
+#define RANGE_ALTITUDE      (1000*4095*ADC_SAMPLE_SCALE/3300)
+#define ALT_RECIP           FIXED_RECIP(100 * FIXED_SCALE, RANGE_ALTITUDE)
 #define BUF_SIZE            10
 #define TASK_STACK_DEPTH    50
 #define QUEUE_ITEM_SIZE     15
-#define QUEUE_SIZE          15
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
@@ -28,15 +29,20 @@
 #include "altitude.h"
 #include "uart.h"
 #include "queue.h"
+#include "blackBox.h"
+#include "groundCal.h"
+#include "lowPower.h"
+#include "perf.h"
+#include "ramfunc.h"
+#include "vectors.h"
+#include "fastIO.h"
+#include "bootProfile.h"
+#include "fixedPoint.h"
+#include "heliContext.h"
 
-static uint32_t refAltitude = 1000;       //Reference Altitude
 //static circBuf_t g_inBuffer;        // Buffer of size BUF_SIZE integers (sample values)
 uint32_t ulValue;
-int calibrate_flag =    0;
-int calibrate_counter = 0;
-static int32_t percentAlt =    0;
 //int32_t percentAlt =    0;
-static int32_t meanVal =0;
 
 
 // Queue for ADC sample from pin to calculation
@@ -51,19 +57,35 @@ extern xSemaphoreHandle g_pADCSemaphore;
 //  ADCIntHandler: The handler for the ADC conversion complete interrupt.
 //                 Writes to the circular buffer.
 //  Taken from:    Week4Lab ADCDemo1.c
-void ADCIntHandler(void)
+RAMFUNC void ADCIntHandler(void)
 {
-//    uint32_t ulValue;
-    // Get the single sample from ADC0.  ADC_BASE is defined in inc/hw_memmap.h
-    ADCSequenceDataGet(ADC0_BASE, 3, &ulValue);
+    uint32_t start = PERF_CYCLES();
+    uint32_t steps[ADC_STEPS];
+    int32_t count;
+    int i;
 
-    // Place it in the circular buffer (advancing write index)
-    //writeCircBuf (&g_inBuffer, ulValue);
+    // Get the sequence results from ADC0.  ADC_BASE is defined in inc/hw_memmap.h
+    count = fastADCSequenceDataGet(ADC0_BASE, ADC_SEQUENCE, steps);
 
-    xQueueSendFromISR( xADCQueue, &ulValue, NULL);
+    // Only a complete sequence makes a sample; the sum keeps the extra bits
+    if (count == ADC_STEPS)
+    {
+        ulValue = 0;
+        for (i = 0; i < ADC_STEPS; i++)
+        {
+            ulValue += steps[i];
+        }
+        blackBoxRecord(BB_ADC, 0, ulValue, 0);
+
+        // Place it in the circular buffer (advancing write index)
+        //writeCircBuf (&g_inBuffer, ulValue);
+
+        xQueueSendFromISR( xADCQueue, &ulValue, NULL);
+    }
 
     // Clean up, clearing the interrupt
-    ADCIntClear(ADC0_BASE, 3);
+    fastADCIntClear(ADC0_BASE, ADC_SEQUENCE);
+    perfRecord(PERF_ADC_ISR, PERF_CYCLES() - start);
 }
 
 
@@ -73,15 +95,33 @@ void ADCIntHandler(void)
 void initADC (void)
 {
     char statusStr[MAX_STR_LEN + 1];
+    uint32_t step;
     //
     // The ADC0 peripheral must be enabled for configuration and use.
     SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
     while(!SysCtlPeripheralReady(SYSCTL_PERIPH_ADC0));
 
+#if ADC_ACQ_MODE == ADC_ACQ_OVERSAMPLE
+    //
+    // Average 16 conversions in hardware for every step
+    ADCHardwareOversampleConfigure(ADC0_BASE, ADC_HW_AVERAGE);
+
+    // Enable sample sequence 0 with a processor signal trigger.  All 8 steps
+    // sample channel 9 (ADC_CTL_CH9) in single-ended mode, and the last step
+    // sets the interrupt flag and ends the sequence.
+    ADCSequenceConfigure(ADC0_BASE, ADC_SEQUENCE, ADC_TRIGGER_PROCESSOR, 0);
+
+    for (step = 0; step < ADC_STEPS - 1; step++)
+    {
+        ADCSequenceStepConfigure(ADC0_BASE, ADC_SEQUENCE, step, ADC_CTL_CH9);
+    }
+    ADCSequenceStepConfigure(ADC0_BASE, ADC_SEQUENCE, ADC_STEPS - 1,
+                             ADC_CTL_CH9 | ADC_CTL_IE | ADC_CTL_END);
+#else
     // Enable sample sequence 3 with a processor signal trigger.  Sequence 3
     // will do a single sample when the processor sends a signal to start the
     // conversion.
-    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_PROCESSOR, 0);
+    ADCSequenceConfigure(ADC0_BASE, ADC_SEQUENCE, ADC_TRIGGER_PROCESSOR, 0);
 
     //
     // Configure step 0 on sequence 3.  Sample channel 9 (ADC_CTL_CH9) in
@@ -92,20 +132,27 @@ void initADC (void)
     // sequence 0 has 8 programmable steps.  Since we are only doing a single
     // conversion using sequence 3 we will only configure step 0.  For more
     // on the ADC sequences and steps, refer to the LM3S1968 datasheet.
-    ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_CH9 | ADC_CTL_IE |
+    ADCSequenceStepConfigure(ADC0_BASE, ADC_SEQUENCE, 0, ADC_CTL_CH9 | ADC_CTL_IE |
                              ADC_CTL_END);
+#endif
 
     //
-    // Since sample sequence 3 is now configured, it must be enabled.
-    ADCSequenceEnable(ADC0_BASE, 3);
+    // Since the sample sequence is now configured, it must be enabled.
+    ADCSequenceEnable(ADC0_BASE, ADC_SEQUENCE);
 
     //
-    // Register the interrupt handler
-    ADCIntRegister (ADC0_BASE, 3, ADCIntHandler);
+    // Register the interrupt handler. It queues samples with
+    // xQueueSendFromISR, so it must not be above the RTOS syscall priority.
+    IntPrioritySet (INT_ADC0SS0 + ADC_SEQUENCE, configMAX_SYSCALL_INTERRUPT_PRIORITY);
+    VECTOR_REGISTER (INT_ADC0SS0 + ADC_SEQUENCE, ADCIntHandler);
 
     //
-    // Enable interrupts for ADC0 sequence 3 (clears any outstanding interrupts)
-    ADCIntEnable(ADC0_BASE, 3);
+    // Enable interrupts for the sequence (clears any outstanding interrupts)
+    ADCIntEnable(ADC0_BASE, ADC_SEQUENCE);
+
+    //
+    // Empty sample window, ground not yet calibrated
+    heliInitAltitude(&g_heli);
 
     //
     // Create Queue for ADC samples
@@ -134,17 +181,71 @@ void initADC (void)
 //    return ((2 * AltSum + BUF_SIZE) / 2 / BUF_SIZE);    //returns an overall sum.
 //}
 
+//  *****************************************************************************
+//  heliInitAltitude: Empties the sample window and starts the ground
+//                    calibration
+void heliInitAltitude (HeliContext *heli)
+{
+    altitude_t *alt = &heli->alt;
+
+    memset(alt, 0, sizeof(*alt));
+    groundCalInit(&heli->ground);
+}
+
+
+//  *****************************************************************************
+//  getAlt:         RETURNS the altitude in whole percent, truncated towards zero.
+//                  Taken from the mean rather than from altHundredths, which
+//                  is rounded and would read a whole percent high from 0.995.
+int32_t heliGetAlt (const HeliContext *heli)
+{
+    return heli->alt.percentAlt;
+}
+
 int32_t getAlt (void)
 {
-    return percentAlt;
+    return heliGetAlt(&g_heli);
 }
 
 
 //  *****************************************************************************
-//  resetAltitude: Resets the refAltitude to be current ADC altitude.
+//  getAltHundredths: RETURNS the altitude in hundredths of a percent, keeping
+//                    the resolution of the oversampled ADC
+int32_t heliGetAltHundredths (const HeliContext *heli)
+{
+    return heli->alt.altHundredths;
+}
+
+int32_t getAltHundredths (void)
+{
+    return heliGetAltHundredths(&g_heli);
+}
+
+
+//  *****************************************************************************
+//  resetAltitude: Resets the refAltitude to be current ADC altitude. Does
+//                 nothing until the ground is calibrated.
+void heliResetAltitude (HeliContext *heli)
+{
+    groundCalSet(&heli->ground, heli->alt.meanVal);
+}
+
 void resetAltitude (void)
 {
-    refAltitude = meanVal;
+    heliResetAltitude(&g_heli);
+}
+
+
+//  *****************************************************************************
+//  altitudeCalibrated: RETURNS true once the ground altitude is calibrated
+bool heliAltitudeCalibrated (const HeliContext *heli)
+{
+    return groundCalDone(&heli->ground);
+}
+
+bool altitudeCalibrated (void)
+{
+    return heliAltitudeCalibrated(&g_heli);
 }
 
 
@@ -152,13 +253,17 @@ void resetAltitude (void)
 //  percentAltitude: Converts the ADC Altitude into a usable percentage altitude
 //                   using a 0.8V difference as the maximum height
 //  RETURNS:         A Height Percentage as a int32_t from the reference height.
-int32_t percentAltitude(void)
+int32_t heliPercentAltitude (const HeliContext *heli)
 {
-    int32_t percent = 1000;
-    percent = 100*(refAltitude-meanVal);
+    int32_t percent = 100*(groundCalReference(&heli->ground) - heli->alt.meanVal);
     return percent/RANGE_ALTITUDE; //returns percentage of 0.8V change
 }
 
+int32_t percentAltitude(void)
+{
+    return heliPercentAltitude(&g_heli);
+}
+
 
 //  *****************************************************************************
 //  bufferLocation: Returns the location of the circular buffer
@@ -178,84 +283,88 @@ void vADCSampleTask(void *pvParameters)
     for ( ;; )
     {
         vTaskDelayUntil(&xLastWakeTime, xDelay30s);
+        lowPowerWakeCheck();
 
-        ADCProcessorTrigger(ADC0_BASE, 3);
-
-        ADCIntHandler();
-
+        // ADCIntHandler runs when the sequence completes
+        ADCProcessorTrigger(ADC0_BASE, ADC_SEQUENCE);
     }
 }
 
 
-void vADCTask(void *pvParameters)
+//  *****************************************************************************
+//  updateAltitude: Adds a new ADC sample to the sample window. Every fifth
+//                  sample the window mean and percentage altitude are updated.
+//                  Raw samples feed the ground calibration until it settles;
+//                  after that each mean may slowly re-zero the reference.
+//  TAKES:          sample, the raw ADC sample
+//  RETURNS:        true when a new altitude is ready for the controller
+bool heliUpdateAltitude(HeliContext *heli, uint32_t sample)
 {
-    TaskHandle_t xPIDTask = pvParameters;
-//    TickType_t xLastWakeTime;
-//    xLastWakeTime = xTaskGetTickCount();
-    const TickType_t xDelay1s = pdMS_TO_TICKS(20);
-    BaseType_t xReceive = pdFALSE;
-//    char statusStr[MAX_STR_LEN + 1];
-    uint32_t ADCSamples[QUEUE_SIZE];
-    int i, j = 0;
+    altitude_t *alt = &heli->alt;
+    bool altitudeReady = false;
+    int j;
 
+    alt->ADCSamples[alt->sampleIndex] = sample;
+    alt->sampleIndex = (alt->sampleIndex + 1) % ALT_WINDOW;
 
-    for ( ;; )
+    if (!groundCalDone(&heli->ground))
     {
+        groundCalSample(&heli->ground, sample);
+    }
 
-        xReceive = xQueueReceive(xADCQueue, &ADCSamples[i], portMAX_DELAY);
-        if (xReceive == pdTRUE)
+    if (alt->sampleIndex % 5 == 0)
+    {
+        int offset = ((((alt->sampleIndex / 5) - 1) * 5 + ALT_WINDOW) % ALT_WINDOW);
+        int sum = 0;
+        for (j = 0; j< 5; ++j)
+        {
+            sum += alt->ADCSamples[offset + j];
+        }
+        alt->meanVal = sum / 5;
+        if (groundCalDone(&heli->ground))
         {
-            i = (i + 1) % QUEUE_SIZE;
+            int32_t counts;
 
-            if (i % 5 == 0)
-            {
-                int offset = ((((i / 5) - 1) * 5 + QUEUE_SIZE) % QUEUE_SIZE);
-                int sum = 0;
-                for (j = 0; j< 5; ++j)
-                {
-                    sum += ADCSamples[offset + j];
-                }
-                meanVal = sum / 5;
-                percentAlt = 100*((int32_t)refAltitude-meanVal) / RANGE_ALTITUDE;
-                xTaskNotifyGive(xPIDTask);
-            }
+            groundCalTrack(&heli->ground, alt->meanVal);
+            counts = groundCalReference(&heli->ground) - alt->meanVal;
+            alt->altHundredths = FIXED_MUL(counts, ALT_RECIP);
+            alt->percentAlt = 100*counts / RANGE_ALTITUDE;
         }
+        altitudeReady = true;
+    }
 
+    return altitudeReady;
+}
 
+bool updateAltitude(uint32_t sample)
+{
+    bool calibrated = heliAltitudeCalibrated(&g_heli);
+    bool altitudeReady = heliUpdateAltitude(&g_heli, sample);
+
+    if (!calibrated && heliAltitudeCalibrated(&g_heli))
+    {
+        bootMark(BOOT_CALIBRATED);
+    }
+    return altitudeReady;
+}
+
+
+void vADCTask(void *pvParameters)
+{
+    TaskHandle_t xPIDTask = pvParameters;
+    const TickType_t xDelay1s = pdMS_TO_TICKS(20);
+    uint32_t sample;
 
-        if (calibrate_flag == 0)
+    for ( ;; )
+    {
+        if (xQueueReceive(xADCQueue, &sample, portMAX_DELAY) == pdTRUE)
         {
-            if (calibrate_counter == 20)
+            if (updateAltitude(sample))
             {
-                resetAltitude();
-                calibrate_flag = 1;
+                xTaskNotifyGive(xPIDTask);
             }
-            calibrate_counter++;
         }
 
-        //
-        // Guard UART from concurrent access. Print the currently
-        // blinking LED.
-        //
-//        xSemaphoreTake(g_pUARTSemaphore, portMAX_DELAY);
-//        printf("Left Button is pressed.\n");
-//        xSemaphoreGive(g_pUARTSemaphore);
-
-//        usprintf (statusStr, "\nulValue: %d\r", ulValue);
-//        UARTSend (statusStr);
-//
-//        usprintf (statusStr, "\nADC Buffer: %d\r", height);
-//        UARTSend (statusStr);
-//
-//        usprintf (statusStr, "\nReference: %d\r", refAltitude);
-//        UARTSend (statusStr);
-
-//        usprintf (statusStr, "\r\nMean: %d", meanVal);
-//        UARTSend (statusStr);
-
-//        usprintf (statusStr, "\r\nPercent: %d", percentAlt);
-//        UARTSend (statusStr);
-
         vTaskDelay(xDelay1s);
     }
 
@@ -10,6 +10,47 @@
 // Last modified:   20.4.2019
 //*****************************************************************************
 
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// ADC acquisition. In oversampling mode every trigger runs the 8 steps of
+// sequence 0 on the altitude channel with 16x hardware averaging, and the
+// sample passed on is the sum of the 8 results: a 15 bit value with about
+// 3 more useful bits than a single conversion. Define ADC_ACQ_MODE as
+// ADC_ACQ_SINGLE for the original single conversion on sequence 3.
+//*****************************************************************************
+#define ADC_ACQ_SINGLE      0
+#define ADC_ACQ_OVERSAMPLE  1
+
+#ifndef ADC_ACQ_MODE
+#define ADC_ACQ_MODE        ADC_ACQ_OVERSAMPLE
+#endif
+
+#if ADC_ACQ_MODE == ADC_ACQ_OVERSAMPLE
+#define ADC_SEQUENCE        0       // 8 step sequencer
+#define ADC_STEPS           8       // Conversions summed per sample
+#define ADC_HW_AVERAGE      16      // Hardware averaging per conversion
+#else
+#define ADC_SEQUENCE        3       // Single step sequencer
+#define ADC_STEPS           1
+#define ADC_HW_AVERAGE      1
+#endif
+
+#define ADC_SAMPLE_SCALE    ADC_STEPS               // Sample counts per 12 bit count
+#define ADC_SAMPLE_MAX      (4095 * ADC_SAMPLE_SCALE)
+
+#define ALT_WINDOW          15      // Recent samples kept, averaged 5 at a time
+
+// *******************************************************
+// One helicopter's altitude measurement, see heliContext.h
+typedef struct {
+    uint32_t ADCSamples[ALT_WINDOW];    // Window of recent samples
+    int32_t sampleIndex;
+    int32_t meanVal;                    // Mean of the latest 5 samples
+    int32_t altHundredths;              // Altitude, FIXED_SCALE per percent
+    int32_t percentAlt;                 // Altitude in whole percent, truncated
+} altitude_t;
 
 
 //  *****************************************************************************
@@ -33,15 +74,33 @@ initADC (void);
 //  RETURNS:         The calculated ADC altitude value as a int32_t
 //int32_t
 //computeAltitude(void);
+
+
+//  *****************************************************************************
+//  getAlt:         RETURNS the altitude in whole percent, truncated towards zero
 int32_t getAlt (void);
 
 
 //  *****************************************************************************
-//  resetAltitude: Resets the refAltitude to be current ADC altitude.
+//  getAltHundredths: RETURNS the altitude in hundredths of a percent, keeping
+//                    the resolution of the oversampled ADC
+int32_t
+getAltHundredths (void);
+
+
+//  *****************************************************************************
+//  resetAltitude: Resets the refAltitude to be current ADC altitude. Does
+//                 nothing until the ground is calibrated.
 void
 resetAltitude(void);
 
 
+//  *****************************************************************************
+//  altitudeCalibrated: RETURNS true once the ground altitude is calibrated
+bool
+altitudeCalibrated(void);
+
+
 //  *****************************************************************************
 //  percentAltitude: Converts the ADC Altitude into a usable percentage altitude
 //                   using a 0.8V difference as the maximum height
@@ -56,6 +115,16 @@ percentAltitude(void);
 //circBuf_t*
 //bufferLocation(void);
 
+//  *****************************************************************************
+//  updateAltitude: Adds a new ADC sample to the sample window. Every fifth
+//                  sample the window mean and percentage altitude are updated.
+//                  Raw samples feed the ground calibration until it settles;
+//                  after that each mean may slowly re-zero the reference.
+//  TAKES:          sample, the raw ADC sample
+//  RETURNS:        true when a new altitude is ready for the controller
+bool
+updateAltitude(uint32_t sample);
+
 void vADCSampleTask(void *pvParameters);
 
 void vADCTask(void *pvParameters);
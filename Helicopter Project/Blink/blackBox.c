@@ -0,0 +1,264 @@
+//*****************************************************************************
+//
+// blackBox - RAM black box recording full rate raw data (ADC samples, yaw
+//            edge counts and PID terms) into a ring of packed records.
+//            Recording freezes a short time after a trigger so the lead up
+//            to the event is kept, and the snapshot is then drained over UART.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driverlib/cpu.h"
+#include "utils/ustdlib.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "blackBox.h"
+#include "uart.h"
+
+#define BB_MAGIC            0xB1ACB0C6u     // Changes with the layout
+#define BB_INDEX_MASK       (BB_NUM_RECORDS - 1)
+
+// *******************************************************
+// The whole black box is kept out of the C auto-initialisation so a snapshot
+// frozen just before a reset (e.g. the reset button) survives into the next
+// boot and can still be drained.
+typedef struct {
+    uint32_t magic;
+    uint32_t windex;        // Next record to write, free running
+    uint32_t postCount;     // Records left to write after a trigger
+    bool triggered;
+    bool frozen;
+    uint32_t rindex;        // Next record to drain, free running
+    uint32_t yawIndex;      // BB_YAW record edges are folded into, free running
+    bbRecord_t records[BB_NUM_RECORDS];
+} blackBox_t;
+
+#pragma NOINIT(g_blackBox)
+static blackBox_t g_blackBox;
+
+
+// *******************************************************
+// saturate16:          Clips a value into the int16_t range of a record
+static int16_t saturate16(int32_t value)
+{
+    if (value > INT16_MAX)
+    {
+        return INT16_MAX;
+    } else if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+
+// *******************************************************
+// freeze:              Stops recording and starts the drain at the oldest
+//                      record. Called with interrupts masked.
+static void freeze(void)
+{
+    g_blackBox.frozen = true;
+    g_blackBox.rindex = g_blackBox.windex - BB_NUM_RECORDS;
+}
+
+
+// *******************************************************
+// advance:             Moves on the write index, counting down the post
+//                      trigger records. Called with interrupts masked.
+static void advance(void)
+{
+    g_blackBox.windex++;
+    if (g_blackBox.triggered)
+    {
+        if (g_blackBox.postCount == 0)
+        {
+            freeze();
+        } else {
+            g_blackBox.postCount--;
+        }
+    }
+}
+
+
+// *******************************************************
+// initBlackBox:        Arms the black box. A snapshot frozen before a reset
+//                      (the buffer lives in uninitialised RAM) is kept so it
+//                      can still be drained.
+void initBlackBox (void)
+{
+    uint32_t i;
+
+    if (g_blackBox.magic == BB_MAGIC && g_blackBox.frozen)
+    {
+        return;
+    }
+
+    for (i = 0; i < BB_NUM_RECORDS; i++)
+    {
+        g_blackBox.records[i].type = BB_EMPTY;
+    }
+    g_blackBox.windex = 0;
+    g_blackBox.rindex = 0;
+    g_blackBox.yawIndex = 0;
+    g_blackBox.postCount = 0;
+    g_blackBox.triggered = false;
+    g_blackBox.frozen = false;
+    g_blackBox.magic = BB_MAGIC;
+}
+
+
+// *******************************************************
+// blackBoxRecord:      Appends a record. Safe from ISRs and tasks, does
+//                      nothing once the capture has frozen.
+void blackBoxRecord (uint8_t type, uint8_t aux, int32_t value0, int32_t value1)
+{
+    bbRecord_t *record;
+    uint32_t ui32Mask;
+
+    if (g_blackBox.frozen)
+    {
+        return;
+    }
+
+    ui32Mask = CPUcpsid();
+    record = &g_blackBox.records[g_blackBox.windex & BB_INDEX_MASK];
+    record->time = (uint16_t)xTaskGetTickCountFromISR();
+    record->type = type;
+    record->aux = aux;
+    record->value[0] = saturate16(value0);
+    record->value[1] = saturate16(value1);
+    advance();
+    if (!ui32Mask)
+    {
+        CPUcpsie();
+    }
+}
+
+
+// *******************************************************
+// blackBoxYawEdge:     Records a quadrature edge. Edges inside BB_YAW_BIN_MS
+//                      are folded into one record to save space, even with
+//                      other records written in between, as long as it is
+//                      still in the ring.
+void blackBoxYawEdge (int32_t slot, uint8_t state)
+{
+    bbRecord_t *open;
+    uint16_t now;
+    uint32_t ui32Mask;
+
+    if (g_blackBox.frozen)
+    {
+        return;
+    }
+
+    ui32Mask = CPUcpsid();
+    now = (uint16_t)xTaskGetTickCountFromISR();
+    open = &g_blackBox.records[g_blackBox.yawIndex & BB_INDEX_MASK];
+    if (g_blackBox.windex - g_blackBox.yawIndex - 1 < BB_NUM_RECORDS &&
+        open->type == BB_YAW && (uint16_t)(now - open->time) < BB_YAW_BIN_MS &&
+        open->aux < UINT8_MAX)
+    {
+        open->aux++;
+        open->value[0] = saturate16(slot);
+        open->value[1] = state;
+    } else {
+        g_blackBox.yawIndex = g_blackBox.windex;
+        open = &g_blackBox.records[g_blackBox.windex & BB_INDEX_MASK];
+        open->time = now;
+        open->type = BB_YAW;
+        open->aux = 1;
+        open->value[0] = saturate16(slot);
+        open->value[1] = state;
+        advance();
+    }
+    if (!ui32Mask)
+    {
+        CPUcpsie();
+    }
+}
+
+
+// *******************************************************
+// blackBoxTrigger:     Starts the post trigger countdown if armed. Safe from
+//                      ISRs and tasks; the test and set are done with
+//                      interrupts masked so a second trigger cannot re-arm
+//                      the countdown. The reset button freezes at once, even
+//                      part way through a countdown, since nothing is
+//                      recorded after it and only a frozen snapshot survives
+//                      the reset.
+// TAKES:               reason, one of bbTriggers
+void blackBoxTrigger (uint8_t reason)
+{
+    uint32_t ui32Mask;
+
+    ui32Mask = CPUcpsid();
+    if (!g_blackBox.triggered)
+    {
+        blackBoxRecord(BB_TRIGGER, reason, 0, 0);
+        g_blackBox.postCount = BB_POST_TRIGGER;
+        g_blackBox.triggered = true;
+    }
+    if (reason == BB_TRIG_RESET && !g_blackBox.frozen)
+    {
+        freeze();
+    }
+    if (!ui32Mask)
+    {
+        CPUcpsie();
+    }
+}
+
+
+// *******************************************************
+// blackBoxFrozen:      RETURNS true once a snapshot is ready to drain
+bool blackBoxFrozen (void)
+{
+    return g_blackBox.frozen;
+}
+
+
+// *******************************************************
+// blackBoxDrain:       Sends up to maxRecords of the frozen snapshot over UART,
+//                      oldest first. Re-arms the black box once the whole
+//                      snapshot has been sent.
+// RETURNS:             true when the drain has finished
+bool blackBoxDrain (uint32_t maxRecords)
+{
+    char statusStr[MAX_STR_LEN + 1];
+    bbRecord_t *record;
+
+    if (!g_blackBox.frozen)
+    {
+        return true;
+    }
+
+    if (g_blackBox.rindex == g_blackBox.windex - BB_NUM_RECORDS)
+    {
+        UARTSend("BB begin\r\n");
+    }
+
+    while (maxRecords > 0 && g_blackBox.rindex != g_blackBox.windex)
+    {
+        record = &g_blackBox.records[g_blackBox.rindex & BB_INDEX_MASK];
+        if (record->type != BB_EMPTY)
+        {
+            usnprintf(statusStr, sizeof(statusStr), "BB %u %u %u %d %d\r\n",
+                      record->time, record->type, record->aux,
+                      record->value[0], record->value[1]);
+            UARTSend(statusStr);
+            maxRecords--;
+        }
+        g_blackBox.rindex++;
+    }
+
+    if (g_blackBox.rindex == g_blackBox.windex)
+    {
+        UARTSend("BB end\r\n");
+        g_blackBox.magic = 0;
+        initBlackBox();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,92 @@
+#ifndef BLACKBOX_H_
+#define BLACKBOX_H_
+
+//*****************************************************************************
+//
+// blackBox - RAM black box recording full rate raw data (ADC samples, yaw
+//            edge counts and PID terms) into a ring of packed records.
+//            Recording freezes a short time after a trigger so the lead up
+//            to the event is kept, and the snapshot is then drained over UART.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define BB_NUM_RECORDS      1024    // Must be a power of 2 (8 bytes each)
+#define BB_POST_TRIGGER     128     // Records kept after the trigger
+#define BB_YAW_BIN_MS       10      // Yaw edges folded into one record
+
+// The window held: at most one ADC record each 30 ms, four PID records each
+// 150 ms control cycle and one yaw record each BB_YAW_BIN_MS, 160 records a
+// second, so the ring holds at least 6.4 s, 5.6 s of it before the trigger.
+// Without the rotor turning it is 60 records a second, about 17 s.
+
+// Record types
+enum bbTypes {BB_EMPTY = 0, BB_ADC, BB_YAW, BB_ALT_PI, BB_ALT_DU,
+              BB_YAW_PI, BB_YAW_DU, BB_MODE, BB_TRIGGER, BB_MANOEUVRE,
+              BB_DEADLINE};
+
+// Trigger reasons, stored in the aux byte of the BB_TRIGGER record
+enum bbTriggers {BB_TRIG_MODE = 0, BB_TRIG_SATURATION, BB_TRIG_ERROR,
+                 BB_TRIG_RESET, BB_TRIG_MANUAL, BB_TRIG_DEADLINE};
+
+// *******************************************************
+// Packed record, 8 bytes. time is the low 16 bits of the tick count (ms).
+// For BB_YAW records aux counts the edges folded into the record in the
+// BB_YAW_BIN_MS from its time, and the values are the slot and state after
+// the last of them; PID records hold their terms in hundredths of a percent.
+// BB_MANOEUVRE records hold the status in aux, then the slot and pc.
+// BB_DEADLINE records hold a dlEvents value in aux, then the measured time
+// and the deadline monitor level.
+typedef struct __attribute__((packed)) {
+    uint16_t time;
+    uint8_t type;
+    uint8_t aux;
+    int16_t value[2];
+} bbRecord_t;
+
+
+// *******************************************************
+// initBlackBox:        Arms the black box. A snapshot frozen before a reset
+//                      (the buffer lives in uninitialised RAM) is kept so it
+//                      can still be drained.
+void
+initBlackBox (void);
+
+// *******************************************************
+// blackBoxRecord:      Appends a record. Safe from ISRs and tasks, does
+//                      nothing once the capture has frozen.
+void
+blackBoxRecord (uint8_t type, uint8_t aux, int32_t value0, int32_t value1);
+
+// *******************************************************
+// blackBoxYawEdge:     Records a quadrature edge. Edges inside BB_YAW_BIN_MS
+//                      are folded into one record to save space.
+void
+blackBoxYawEdge (int32_t slot, uint8_t state);
+
+// *******************************************************
+// blackBoxTrigger:     Starts the post trigger countdown if armed, or for
+//                      BB_TRIG_RESET freezes at once. Ignored while a capture
+//                      counts down or drains. Safe from ISRs and tasks.
+// TAKES:               reason, one of bbTriggers
+void
+blackBoxTrigger (uint8_t reason);
+
+// *******************************************************
+// blackBoxFrozen:      RETURNS true once a snapshot is ready to drain
+bool
+blackBoxFrozen (void);
+
+// *******************************************************
+// blackBoxDrain:       Sends up to maxRecords of the frozen snapshot over UART,
+//                      oldest first. Re-arms the black box once the whole
+//                      snapshot has been sent.
+// RETURNS:             true when the drain has finished
+bool
+blackBoxDrain (uint32_t maxRecords);
+
+#endif /*BLACKBOX_H_*/
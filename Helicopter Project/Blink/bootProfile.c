@@ -0,0 +1,118 @@
+//*****************************************************************************
+//
+// bootProfile - Power on bring up. Every peripheral clock is enabled at once
+//               so the modules' own ready waits find them already running,
+//               and each init stage is timestamped with the DWT cycle
+//               counter. The OLED and the ground calibration finish after
+//               the scheduler starts; the breakdown is sent over UART once
+//               both are done.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "utils/ustdlib.h"
+
+#include "bootProfile.h"
+#include "perf.h"
+#include "uart.h"
+
+// *******************************************************
+// One stage of the breakdown, timed from the end of an earlier one. The
+// stages in main() follow each other; the asynchronous ones are timed from
+// the scheduler starting.
+typedef struct {
+    const char *name;
+    uint8_t since;
+} bootStage_t;
+
+#define BOOT_POWER_ON       NUM_BOOT_STAGES     // initPerf, cycle count 0
+
+static const bootStage_t stages[NUM_BOOT_STAGES] = {
+    {"Clocks",      BOOT_POWER_ON},
+    {"ADC",         BOOT_CLOCKS},
+    {"Yaw",         BOOT_ADC},
+    {"Motors",      BOOT_YAW},
+    {"UART",        BOOT_MOTOR},
+    {"Buttons",     BOOT_UART},
+    {"Switch",      BOOT_BUTTONS},
+    {"Tasks",       BOOT_SWITCH},
+    {"Scheduler",   BOOT_TASKS},
+    {"OLED",        BOOT_SCHEDULER},
+    {"Calibrated",  BOOT_SCHEDULER}
+};
+
+// Every peripheral clock the firmware enables, including the OLED's SSI
+// and delay timer
+static const uint32_t peripherals[] = {
+    SYSCTL_PERIPH_GPIOA, SYSCTL_PERIPH_GPIOB, SYSCTL_PERIPH_GPIOC,
+    SYSCTL_PERIPH_GPIOD, SYSCTL_PERIPH_GPIOE, SYSCTL_PERIPH_GPIOF,
+    SYSCTL_PERIPH_ADC0, SYSCTL_PERIPH_PWM0, SYSCTL_PERIPH_PWM1,
+    SYSCTL_PERIPH_UART0, SYSCTL_PERIPH_WDOG0, SYSCTL_PERIPH_SSI3,
+    SYSCTL_PERIPH_TIMER1
+};
+#define NUM_PERIPHERALS     (sizeof(peripherals) / sizeof(peripherals[0]))
+
+static uint32_t marks[NUM_BOOT_STAGES];
+static uint16_t marked;                 // Bit per marked stage
+static bool reported = false;
+
+
+// *******************************************************
+// bootEnablePeripherals: Enables every clock, then waits for them together
+void bootEnablePeripherals (void)
+{
+    uint8_t i;
+
+    for (i = 0; i < NUM_PERIPHERALS; i++)
+    {
+        SysCtlPeripheralEnable(peripherals[i]);
+    }
+    for (i = 0; i < NUM_PERIPHERALS; i++)
+    {
+        while(!SysCtlPeripheralReady(peripherals[i]));
+    }
+}
+
+
+// *******************************************************
+// bootMark:            Records the cycle count at the end of a stage
+void bootMark (uint8_t stage)
+{
+    if (stage < NUM_BOOT_STAGES && !(marked & (1 << stage)))
+    {
+        marks[stage] = PERF_CYCLES();
+        marked |= 1 << stage;
+    }
+}
+
+
+// *******************************************************
+// bootReport:          Sends the stage breakdown once every stage is
+//                      marked. The cycle counter wraps after 53 s, so a
+//                      calibration slower than that is reported short.
+bool bootReport (void)
+{
+    char statusStr[MAX_STR_LEN + 1];
+    uint32_t start;
+    uint8_t i;
+
+    if (reported || marked != (1 << NUM_BOOT_STAGES) - 1)
+    {
+        return reported;
+    }
+
+    UARTSend ("Boot stage | took us | done at us\n\r");
+    for (i = 0; i < NUM_BOOT_STAGES; i++)
+    {
+        start = stages[i].since == BOOT_POWER_ON ? 0 : marks[stages[i].since];
+        usnprintf (statusStr, sizeof(statusStr), "%10s | %7u | %10u\n\r", stages[i].name,
+                   PERF_US(marks[i] - start), PERF_US(marks[i]));
+        UARTSend (statusStr);
+    }
+    reported = true;
+    return true;
+}
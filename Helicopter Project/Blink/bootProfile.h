@@ -0,0 +1,46 @@
+#ifndef BOOTPROFILE_H_
+#define BOOTPROFILE_H_
+
+//*****************************************************************************
+//
+// bootProfile - Power on bring up. Every peripheral clock is enabled at once
+//               so the modules' own ready waits find them already running,
+//               and each init stage is timestamped with the DWT cycle
+//               counter. The OLED and the ground calibration finish after
+//               the scheduler starts; the breakdown is sent over UART once
+//               both are done.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Init stages in the order main() reaches them. The last two complete in
+// their own tasks after the scheduler has started.
+enum bootStages {BOOT_CLOCKS = 0, BOOT_ADC, BOOT_YAW, BOOT_MOTOR, BOOT_UART,
+                 BOOT_BUTTONS, BOOT_SWITCH, BOOT_TASKS, BOOT_SCHEDULER,
+                 BOOT_DISPLAY, BOOT_CALIBRATED, NUM_BOOT_STAGES};
+
+
+// *******************************************************
+// bootEnablePeripherals: Enables the clocks of every peripheral the firmware
+//                      uses, then waits once for all of them to be ready
+void
+bootEnablePeripherals (void);
+
+
+// *******************************************************
+// bootMark:            Records the cycle count at the end of a stage. Only
+//                      the first mark of each stage is kept.
+// TAKES:               stage, one of bootStages
+void
+bootMark (uint8_t stage);
+
+
+// *******************************************************
+// bootReport:          Sends the stage breakdown over UART, once, as soon
+//                      as every stage has been marked
+// RETURNS:             true once the breakdown has been sent
+bool
+bootReport (void);
+
+#endif /* BOOTPROFILE_H_ */
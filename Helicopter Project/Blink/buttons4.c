@@ -3,7 +3,8 @@
 // buttons4:        Support for a set of FOUR specific buttons on the Tiva/Orbit.
 //                  ENCE361 sample code.
 //                  The buttons are:  UP and DOWN (on the Orbit daughterboard) plus
-//                  LEFT and RIGHT on the Tiva.
+//                  LEFT and RIGHT on the Tiva. The mode switch SW1 and
+//                  the reset button are debounced the same way.
 //
 //Note:             pin PF0 (the pin for the RIGHT pushbutton - SW2 on
 //                  the Tiva board) needs special treatment - See PhilsNotesOnTiva.rtf.
@@ -20,24 +21,104 @@
 #include "driverlib/gpio.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/debug.h"
+#include "driverlib/interrupt.h"
 #include "inc/tm4c123gh6pm.h"  // Board specific defines (for PF0)
 #include "buttons4.h"
+#include "vectors.h"
+#include "deferred.h"
 
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "queue.h"
 #include "task.h"
-#include "uart.h"
+#include "timers.h"
+
+// *******************************************************
+// Pin of each input, indexed by butNames then inputNames
+static const uint32_t but_base[NUM_INPUTS] = {UP_BUT_PORT_BASE, DOWN_BUT_PORT_BASE,
+    LEFT_BUT_PORT_BASE, RIGHT_BUT_PORT_BASE, SWITCH1_PORT_BASE, RESET_BUT_PORT_BASE};
+static const uint8_t but_pin[NUM_INPUTS] = {UP_BUT_PIN, DOWN_BUT_PIN,
+    LEFT_BUT_PIN, RIGHT_BUT_PIN, SWITCH1_PIN, RESET_BUT_PIN};
 
 // *******************************************************
 // Globals to module
-static bool but_state[NUM_BUTS];	// Corresponds to the electrical state
-static uint8_t but_count[NUM_BUTS];
-static bool but_flag[NUM_BUTS];
-static bool but_normal[NUM_BUTS];   // Corresponds to the electrical state
+static bool but_state[NUM_INPUTS];	// Corresponds to the electrical state
+static bool but_flag[NUM_INPUTS];
+static bool but_normal[NUM_INPUTS];   // Corresponds to the electrical state
+static TickType_t but_edge[NUM_INPUTS];   // First edge of the change being debounced
+static TimerHandle_t but_timer[NUM_INPUTS];
+static QueueHandle_t subscriber[BUT_MAX_SUBSCRIBERS];
+static uint32_t subscriberMask[BUT_MAX_SUBSCRIBERS];
+static uint8_t numSubscribers = 0;
+
+// *******************************************************
+// ButtonIntHandler:    Edge on any input. Masks the pin so its bounces cost
+//                      nothing and starts its debounce timer.
+void
+ButtonIntHandler (void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t status;
+    int i;
+
+    for (i = 0; i < NUM_INPUTS; i++)
+    {
+        status = GPIOIntStatus (but_base[i], true);
+        if (status & but_pin[i])
+        {
+            GPIOIntDisable (but_base[i], but_pin[i]);
+            GPIOIntClear (but_base[i], but_pin[i]);
+            but_edge[i] = xTaskGetTickCountFromISR ();
+            xTimerResetFromISR (but_timer[i], &xHigherPriorityTaskWoken);
+        }
+    }
+    portYIELD_FROM_ISR (xHigherPriorityTaskWoken);
+}
+
+// *******************************************************
+// debounceExpire:      Debounce timer callback. An edge latched while the
+//                      pin was masked means it is still bouncing, so the
+//                      timer starts again and the first edge is kept.
+//                      Otherwise the pin is re-armed before it is sampled so
+//                      no edge after the sample is missed.
+static void
+debounceExpire (TimerHandle_t timer)
+{
+    uint8_t butName = (uint8_t)(uintptr_t)pvTimerGetTimerID (timer);
+    butEvent_t event;
+    bool value;
+    int i;
+
+    if (GPIOIntStatus (but_base[butName], false) & but_pin[butName])
+    {
+        GPIOIntClear (but_base[butName], but_pin[butName]);
+        xTimerReset (timer, 0);
+        return;
+    }
+    GPIOIntClear (but_base[butName], but_pin[butName]);
+    GPIOIntEnable (but_base[butName], but_pin[butName]);
+    value = (GPIOPinRead (but_base[butName], but_pin[butName]) == but_pin[butName]);
+    if (value == but_state[butName])
+    {
+        return;
+    }
+
+    but_state[butName] = value;
+    but_flag[butName] = true;	   // Reset by call to checkButton()
+    event.input = butName;
+    event.state = (value == but_normal[butName]) ? RELEASED : PUSHED;
+    event.time = but_edge[butName];
+    for (i = 0; i < numSubscribers; i++)
+    {
+        if (subscriberMask[i] & (1 << butName))
+        {
+            xQueueSend (subscriber[i], &event, 0);
+        }
+    }
+}
 
 // *******************************************************
-// initButtons:     Initialise the variables associated with the set of buttons
-//                  defined by the constants in the buttons2.h header file.
+// initButtons:     Initialise the variables associated with the set of inputs
+//                  defined by the constants in the buttons4.h header file.
 void
 initButtons (void)
 {
@@ -78,51 +159,47 @@ initButtons (void)
     GPIOPadConfigSet (RIGHT_BUT_PORT_BASE, RIGHT_BUT_PIN, GPIO_STRENGTH_2MA,
        GPIO_PIN_TYPE_STD_WPU);
     but_normal[RIGHT] = RIGHT_BUT_NORMAL;
+    // SW1 mode switch (on when HIGH)
+    SysCtlPeripheralEnable (SWITCH1_PERIPH);
+    while(!SysCtlPeripheralReady(SWITCH1_PERIPH));
+    GPIOPinTypeGPIOInput (SWITCH1_PORT_BASE, SWITCH1_PIN);
+    GPIOPadConfigSet (SWITCH1_PORT_BASE, SWITCH1_PIN, GPIO_STRENGTH_2MA,
+       GPIO_PIN_TYPE_STD_WPD);
+    but_normal[SWITCH1] = SWITCH1_NORMAL;
+    // Reset button (active LOW)
+    SysCtlPeripheralEnable (RESET_BUT_PERIPH);
+    while(!SysCtlPeripheralReady(RESET_BUT_PERIPH));
+    GPIOPinTypeGPIOInput (RESET_BUT_PORT_BASE, RESET_BUT_PIN);
+    GPIOPadConfigSet (RESET_BUT_PORT_BASE, RESET_BUT_PIN, GPIO_STRENGTH_2MA,
+       GPIO_PIN_TYPE_STD_WPU);
+    but_normal[RESET_BUT] = RESET_BUT_NORMAL;
 
-	for (i = 0; i < NUM_BUTS; i++)
+	for (i = 0; i < NUM_INPUTS; i++)
 	{
-		but_state[i] = but_normal[i];
-		but_count[i] = 0;
+        // Start from the level at power on, so a switch left on is seen as on
+		but_state[i] = (GPIOPinRead (but_base[i], but_pin[i]) == but_pin[i]);
 		but_flag[i] = false;
+		but_timer[i] = xTimerCreate ("debounce", pdMS_TO_TICKS(BUT_DEBOUNCE_MS), pdFALSE,
+		                             (void *)(uintptr_t)i, debounceExpire);
+		if (but_timer[i] == NULL)
+		{
+		    while(1);
+		}
+		GPIOIntTypeSet (but_base[i], but_pin[i], GPIO_BOTH_EDGES);
+		GPIOIntClear (but_base[i], but_pin[i]);
+		GPIOIntEnable (but_base[i], but_pin[i]);
 	}
-}
 
-// *******************************************************
-// updateButtons:   Function designed to be called regularly. It polls all
-//                  buttons once and updates variables associated with the buttons if
-//                  necessary.  It is efficient enough to be part of an ISR, e.g. from
-//                  a SysTick interrupt.
-//                  Debounce algorithm: A state machine is associated with each button.
-//                  A state change occurs only after NUM_BUT_POLLS consecutive polls have
-//                  read the pin in the opposite condition, before the state changes and
-//                  a flag is set.  Set NUM_BUT_POLLS according to the polling rate.
-void
-updateButtons (void)
-{
-	bool but_value[NUM_BUTS];
-	int i;
-	
-	// Read the pins; true means HIGH, false means LOW
-	but_value[UP] = (GPIOPinRead (UP_BUT_PORT_BASE, UP_BUT_PIN) == UP_BUT_PIN);
-	but_value[DOWN] = (GPIOPinRead (DOWN_BUT_PORT_BASE, DOWN_BUT_PIN) == DOWN_BUT_PIN);
-    but_value[LEFT] = (GPIOPinRead (LEFT_BUT_PORT_BASE, LEFT_BUT_PIN) == LEFT_BUT_PIN);
-    but_value[RIGHT] = (GPIOPinRead (RIGHT_BUT_PORT_BASE, RIGHT_BUT_PIN) == RIGHT_BUT_PIN);
-	// Iterate through the buttons, updating button variables as required
-	for (i = 0; i < NUM_BUTS; i++)
-	{
-        if (but_value[i] != but_state[i])
-        {
-        	but_count[i]++;
-        	if (but_count[i] >= NUM_BUT_POLLS)
-        	{
-        		but_state[i] = but_value[i];
-        		but_flag[i] = true;	   // Reset by call to checkButton()
-        		but_count[i] = 0;
-        	}
-        }
-        else
-        	but_count[i] = 0;
-	}
+    // One handler serves every port with an input on it. It calls FreeRTOS,
+    // so it must not run above the deferred ISRs' priority.
+    IntPrioritySet (INT_GPIOA, DEFER_ISR_PRIORITY);
+    IntPrioritySet (INT_GPIOD, DEFER_ISR_PRIORITY);
+    IntPrioritySet (INT_GPIOE, DEFER_ISR_PRIORITY);
+    IntPrioritySet (INT_GPIOF, DEFER_ISR_PRIORITY);
+    VECTOR_REGISTER (INT_GPIOA, ButtonIntHandler);
+    VECTOR_REGISTER (INT_GPIOD, ButtonIntHandler);
+    VECTOR_REGISTER (INT_GPIOE, ButtonIntHandler);
+    VECTOR_REGISTER (INT_GPIOF, ButtonIntHandler);
 }
 
 // *******************************************************
@@ -143,19 +220,26 @@ checkButton (uint8_t butName)
 	return NO_CHANGE;
 }
 
-
-void vButtonTask (void *pvParameters)
+// *******************************************************
+// buttonPushed:    Returns true if the debounced input is pushed (or on, for SWITCH1)
+bool
+buttonPushed (uint8_t butName)
 {
-    const TickType_t xDelay1s = pdMS_TO_TICKS(10);
-//    char statusStr[MAX_STR_LEN + 1];
+    return but_state[butName] != but_normal[butName];
+}
 
-    for ( ;; )
+// *******************************************************
+// buttonSubscribe: Sends every debounced change of the inputs in mask to queue
+// RETURNS:         false if there are already BUT_MAX_SUBSCRIBERS
+bool
+buttonSubscribe (QueueHandle_t queue, uint32_t mask)
+{
+    if (numSubscribers >= BUT_MAX_SUBSCRIBERS)
     {
-        updateButtons();
-
-//        usprintf (statusStr, "\r\nButton working");
-//        UARTSend (statusStr);
-
-        vTaskDelay(xDelay1s);
+        return false;
     }
+    subscriber[numSubscribers] = queue;
+    subscriberMask[numSubscribers] = mask;
+    numSubscribers++;
+    return true;
 }
@@ -7,7 +7,12 @@
 // Support for a set of FOUR specific buttons on the Tiva/Orbit.
 // ENCE361 sample code.
 // The buttons are:  UP and DOWN (on the Orbit daughterboard) plus
-// LEFT and RIGHT on the Tiva.
+// LEFT and RIGHT on the Tiva. The mode switch SW1 and the reset
+// button are debounced the same way.
+//
+// Inputs are interrupt driven: an edge masks the pin and starts a
+// debounce timer, and the pin is sampled once when it expires. Nothing
+// runs while the inputs are idle.
 //
 // P.J. Bones UCECE
 // Last modified:  7.2.2018
@@ -17,10 +22,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "FreeRTOS.h"
+#include "queue.h"
+
 //*****************************************************************************
 // Constants
 //*****************************************************************************
 enum butNames {UP = 0, DOWN, LEFT, RIGHT, NUM_BUTS};
+enum inputNames {SWITCH1 = NUM_BUTS, RESET_BUT, NUM_INPUTS};
 enum butStates {RELEASED = 0, PUSHED, NO_CHANGE};
 // UP button
 #define UP_BUT_PERIPH  SYSCTL_PERIPH_GPIOE
@@ -43,35 +52,65 @@ enum butStates {RELEASED = 0, PUSHED, NO_CHANGE};
 #define RIGHT_BUT_PIN  GPIO_PIN_0
 #define RIGHT_BUT_NORMAL  true
 
-#define NUM_BUT_POLLS 3
-// Debounce algorithm:  A state machine is associated with each button.
-//                      A state change occurs only after NUM_BUT_POLLS consecutive polls have
-//                      read the pin in the opposite condition, before the state changes and
-//                      a flag is set.  Set NUM_BUT_POLLS according to the polling rate.
+// SW1 mode switch (on when HIGH)
+#define SWITCH1_PERIPH  SYSCTL_PERIPH_GPIOA
+#define SWITCH1_PORT_BASE  GPIO_PORTA_BASE
+#define SWITCH1_PIN  GPIO_PIN_7
+#define SWITCH1_NORMAL  false
+// Reset button (active LOW)
+#define RESET_BUT_PERIPH  SYSCTL_PERIPH_GPIOA
+#define RESET_BUT_PORT_BASE  GPIO_PORTA_BASE
+#define RESET_BUT_PIN  GPIO_PIN_6
+#define RESET_BUT_NORMAL  true
+
+#define BUT_DEBOUNCE_MS 5
+#define BUT_MAX_SUBSCRIBERS 2
+// Debounce algorithm:  The first edge on a pin masks its interrupt, stamps the time and
+//                      starts a one shot timer. When it expires BUT_DEBOUNCE_MS later,
+//                      any edge latched meanwhile means the pin is still bouncing and
+//                      the timer starts again. Once the pin has been quiet for
+//                      BUT_DEBOUNCE_MS the interrupt is re-armed and the pin is sampled;
+//                      a level different from the debounced state changes the state,
+//                      sets a flag and sends one event stamped with the first edge.
+
+// *******************************************************
+// A debounced change, time stamped with the edge that started it
+typedef struct {
+    uint8_t input;          // butNames or inputNames
+    uint8_t state;          // PUSHED or RELEASED
+    TickType_t time;
+} butEvent_t;
 
 // *******************************************************
-// initButtons:         Initialise the variables associated with the set of buttons
-//                      defined by the constants above.
+// initButtons:         Initialise the variables associated with the set of inputs
+//                      defined by the constants above and enable their interrupts.
 void
 initButtons (void);
 
 // *******************************************************
-// updateButtons:       Function designed to be called regularly. It polls all
-//                      buttons once and updates variables associated with the buttons if
-//                      necessary.  It is efficient enough to be part of an ISR, e.g. from
-//                      a SysTick interrupt.
+// ButtonIntHandler:    Edge interrupt handler for every port with an input on it
 void
-updateButtons (void);
+ButtonIntHandler (void);
 
 // *******************************************************
 // checkButton:         Function returns the new button state if the button state
 //                      (PUSHED or RELEASED) has changed since the last call, otherwise returns
 //                      NO_CHANGE.  The argument butName should be one of constants in the
-//                      enumeration butStates, excluding 'NUM_BUTS'. Safe under interrupt.
+//                      enumerations butNames or inputNames. Safe under interrupt.
 uint8_t
 checkButton (uint8_t butName);
 
-void
-vButtonTask (void *pvParameters);
+// *******************************************************
+// buttonPushed:        Returns true if the debounced input is pushed (or on, for SWITCH1)
+bool
+buttonPushed (uint8_t butName);
+
+// *******************************************************
+// buttonSubscribe:     Sends every debounced change of the inputs in mask (bit n for
+//                      input n) to queue, which must hold butEvent_t items. Events are
+//                      dropped if the queue is full.
+// RETURNS:             false if there are already BUT_MAX_SUBSCRIBERS
+bool
+buttonSubscribe (QueueHandle_t queue, uint32_t mask);
 
 #endif /*BUTTONS_H_*/
@@ -33,10 +33,28 @@
 #include "display.h"
 #include "yaw.h"
 #include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
+#include "altSchedule.h"
+#include "trajectory.h"
+#include "manoeuvre.h"
+#include "control.h"
 #include "buttons4.h"
+#include "blackBox.h"
+#include "groundCal.h"
+#include "deadline.h"
+#include "ramfunc.h"
+#include "vectors.h"
+#include "fastIO.h"
+#include "bootProfile.h"
+#include "deferred.h"
+#include "perf.h"
+#include "fixedPoint.h"
+#include "heliContext.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "queue.h"
 #include "task.h"
 #include "uart.h"
 #include "timers.h"
@@ -49,10 +67,8 @@
 #define YAW_REF_INIT        0    //Initial yaw reference
 #define YAW_STEP_RATE       15   //Yaw step rate
 
-// Helirig 1
-#define ALT_PROP_CONTROL    0.5  //Altitude PID control
-#define ALT_INT_CONTROL     0.03
-#define ALT_DIF_CONTROL     0.2//1.5
+// Helirig 1 altitude gains (0.5, 0.03, 0.2) and hover duty (45%) are now the
+// defaults of the altitude schedule, see altSchedule.h
 
 //// Milestone
 //#define ALT_PROP_CONTROL    0.4  //Altitude PID control
@@ -65,70 +81,320 @@
 
 #define DELTA_T             0.01 // 1/SYS_TICK_RATE
 
-#define TAIL_OFFSET         35   //Tail offset
-#define MAIN_OFFSET         45   //Main offset
+// Reference trajectory limits are in trajectory.h
+
+#define ALT_VEL_FF          0.2  //Duty % per %/s of reference velocity
+#define YAW_VEL_FF          0.05 //Duty % per degree/s of reference velocity
+
+#define FF_STEADY_YAW       3.0  //Errors small enough to count as steady hover,
+#define FF_STEADY_ALT       3.0  //in degrees and percent
+#define FF_STEADY_CYCLES    10   //Steady control cycles before the feedforward learns
 
 #define MODE_CHANGE_TIME    500   //The time before flipping the switch will
                                  //land the heli instead of swapping mode.
 
 #define TOTAL_ANGLE         360 // Total degrees
+#define LAND_YAW            10  // Degrees from the reference a landing descends
+                                // and touches down within
 
-//sets the intial value of the Altitude and
-extern int32_t AltRef =  ALT_REF_INIT;
-extern int32_t YawRef = YAW_REF_INIT;
-
-//Sets integral error variables
-static double AltIntError = 0;
-static double AltPreviousError = 0;
-static double YawIntError = 0;
-static double YawPreviousError = 0;
+#define DUTY_MIN            10   //Limits of the PID duty cycle outputs
+#define DUTY_MAX            90
 
-//Yaw error and control variables
-double Yaw_error, YawDerivError;
-double YawControl;
+#define BB_ALT_ERROR        40   //Errors large enough to trigger the black box
+#define BB_YAW_ERROR        200
 
-//Altitude error and control variables
-double Alt_error = 0, AltDerivError;
-double AltControl;
-
-//Main and tail duty cycle
-double mainDuty = 0, tailDuty = 0;
+//Black box trigger conditions, bits of control_t alarms
+#define ALARM_ALT_SATURATED 0x01
+#define ALARM_ALT_ERROR     0x02
+#define ALARM_YAW_SATURATED 0x04
+#define ALARM_YAW_ERROR     0x08
 
 //Reading from PC4 to find reference
 uint32_t PC4Read = 0;
-uint32_t switchState = 0;
-bool stable = false, paralysed = true, ref_Found = false;
+
+static QueueHandle_t switchEvents;     //Debounced SW1 changes from buttons4
 
 TimerHandle_t switchTimer;
-bool timerResetFlag = false;
-bool spiralSetUp = false;
-bool spinSetUp = false;
-static int32_t error;
 
+// *******************************************************
+// Declaring modes Landed, Initialising, TakeOff, Flying, Special and Landing.
+// Powered and InFlight are parent states grouping the modes the PID loops
+// run in and the modes the switch can land from; they are never current.
+typedef enum {Landed, Initialising, TakeOff, Flying, Special, Landing,
+              InFlight, Powered, NUM_MODES} mode_type;
+
+// Events queued for the mode machine, besides SM_EV_TICK each control cycle
+enum modeEvents {EV_REF_FOUND = 1, EV_SWITCH_TIMER, EV_DEADLINE};
+
+#define SWITCH_QUEUE_LENGTH 4
+
+
+void switchTimerExpire(TimerHandle_t pxTimer);
+
+static void enterLanded(void *owner);
+static void enterInitialising(void *owner);
+static void enterLanding(void *owner);
+static void duringTakeOff(void *owner);
+static void duringFlying(void *owner);
+static void duringSpecial(void *owner);
+static void duringLanding(void *owner);
+static bool readyToFly(void *owner);
+static bool isStable(void *owner);
+static bool switchOn(void *owner);
+static bool isOnGround(void *owner);
+static void startMotors(void *owner);
+static void zeroYawRef(void *owner);
+static void deadlineMissed(HeliContext *heli);
+
+static const smState_t modeStates[NUM_MODES] = {
+    //               name            parent        entry              during
+    [Landed]       = {"Landed",       SM_NO_PARENT, enterLanded,       NULL},
+    [Initialising] = {"Initialising", SM_NO_PARENT, enterInitialising, NULL},
+    [TakeOff]      = {"TakeOff",      Powered,      NULL,              duringTakeOff},
+    [Flying]       = {"Flying",       InFlight,     NULL,              duringFlying},
+    [Special]      = {"Special",      InFlight,     NULL,              duringSpecial},
+    [Landing]      = {"Landing",      Powered,      enterLanding,      duringLanding},
+    [InFlight]     = {"InFlight",     Powered,      NULL,              NULL},
+    [Powered]      = {"Powered",      SM_NO_PARENT, NULL,              NULL},
+};
+
+static const smTransition_t modeTable[] = {
+    // state        event            guard       action       next
+    {Landed,       SM_EV_TICK,      readyToFly, startMotors, Initialising},
+    {Initialising, EV_REF_FOUND,    NULL,       zeroYawRef,  TakeOff},
+    {TakeOff,      SM_EV_TICK,      isStable,   NULL,        Flying},
+    {Flying,       EV_SWITCH_TIMER, switchOn,   NULL,        Special},
+    {Special,      EV_SWITCH_TIMER, switchOn,   NULL,        Flying},
+    {InFlight,     EV_SWITCH_TIMER, NULL,       zeroYawRef,  Landing},
+    {Landing,      SM_EV_TICK,      isOnGround, NULL,        Landed},
+    {Initialising, EV_DEADLINE,     NULL,       zeroYawRef,  Landing},
+    {TakeOff,      EV_DEADLINE,     NULL,       zeroYawRef,  Landing},
+    {InFlight,     EV_DEADLINE,     NULL,       zeroYawRef,  Landing},
+};
 
-typedef enum {Normal, SpiralUp, SpiralDown, Spin180Left, Spin180Right}specialMode;
-specialMode specialTrick = Normal;
 
 // *******************************************************
-// Declaring modes Landed, Initialising, TakeOff, Flying and Landing
-typedef enum {Landed, Initialising, TakeOff, Flying, Special, Landing} mode_type;
-mode_type mode = Landed;  //Initial mode is landed
+// The context's hooks, each of which may be missing
+static void record(HeliContext *heli, uint8_t type, uint8_t aux,
+                   int32_t value0, int32_t value1)
+{
+    if (heli->hooks.record != NULL)
+    {
+        heli->hooks.record(heli, type, aux, value0, value1);
+    }
+}
 
+static void trigger(HeliContext *heli, uint8_t reason)
+{
+    if (heli->hooks.trigger != NULL)
+    {
+        heli->hooks.trigger(heli, reason);
+    }
+}
 
-void YawRefIntHandler(void);
+// Triggers when an alarm condition starts, not on every cycle it holds
+static void triggerOnAlarm(HeliContext *heli, uint8_t alarmBit, bool active, uint8_t reason)
+{
+    control_t *ctl = &heli->ctl;
+
+    if (active && !(ctl->alarms & alarmBit))
+    {
+        trigger(heli, reason);
+    }
+    if (active)
+    {
+        ctl->alarms |= alarmBit;
+    } else {
+        ctl->alarms &= ~alarmBit;
+    }
+}
+
+static uint8_t button(HeliContext *heli, uint8_t butNo)
+{
+    if (heli->hooks.button != NULL)
+    {
+        return heli->hooks.button(heli, butNo);
+    }
+    return NO_CHANGE;
+}
+
+static void lock(HeliContext *heli)
+{
+    if (heli->hooks.lock != NULL)
+    {
+        heli->hooks.lock(heli);
+    }
+}
+
+static void unlock(HeliContext *heli)
+{
+    if (heli->hooks.unlock != NULL)
+    {
+        heli->hooks.unlock(heli);
+    }
+}
+
+static bool outputsHeld(HeliContext *heli)
+{
+    return heli->hooks.outputsHeld != NULL && heli->hooks.outputsHeld(heli);
+}
+
+// The mode machine's queue is guarded by the context's lock
+static void lockModes(void *owner)
+{
+    lock(owner);
+}
+
+static void unlockModes(void *owner)
+{
+    unlock(owner);
+}
 
-void switchTimerExpire(TimerHandle_t pxTimer);
+
+// *******************************************************
+// g_heli's hooks, on the buttons, switch timer, black box, RTOS critical
+// sections and deadline monitor
+static uint8_t readButton(HeliContext *heli, uint8_t butNo)
+{
+    return checkButton(butNo);
+}
+
+static void startSwitchTimer(HeliContext *heli, TickType_t now)
+{
+    if (xTimerReset(switchTimer, portMAX_DELAY) != pdPASS)
+    {
+        while(1);
+    }
+}
+
+static void recordBlackBox(HeliContext *heli, uint8_t type, uint8_t aux,
+                           int32_t value0, int32_t value1)
+{
+    blackBoxRecord(type, aux, value0, value1);
+}
+
+static void triggerBlackBox(HeliContext *heli, uint8_t reason)
+{
+    blackBoxTrigger(reason);
+}
+
+static void enterCritical(HeliContext *heli)
+{
+    taskENTER_CRITICAL();
+}
+
+static void exitCritical(HeliContext *heli)
+{
+    taskEXIT_CRITICAL();
+}
+
+static bool deadlineHolds(HeliContext *heli)
+{
+    return deadlineStalled();
+}
+
+
+// *******************************************************
+// modeChanged:         Called after every mode transition. Records it, with
+//                      its latency, in the black box and triggers a capture.
+//                      The ground reference is only re-zeroed while landed.
+static void modeChanged(void *owner, const smLogEntry_t *entry)
+{
+    HeliContext *heli = owner;
+    control_t *ctl = &heli->ctl;
+
+    if (entry->to != Special)
+    {
+        manoeuvreStop(&ctl->manoeuvre);
+    }
+    groundCalSetTracking(&heli->ground, entry->to == Landed);
+    record(heli, BB_MODE, entry->to, entry->from, entry->latency);
+    trigger(heli, BB_TRIG_MODE);
+}
+
+// *******************************************************
+// postModeEvent:       Queues an event for the mode machine. One that finds
+//                      the queue full is kept and posted again next cycle.
+static void postModeEvent(HeliContext *heli, uint8_t event, TickType_t now)
+{
+    control_t *ctl = &heli->ctl;
+
+    if (!smPost(&ctl->heliModes, event, now))
+    {
+        lock(heli);
+        ctl->pendingEvents |= 1u << event;
+        unlock(heli);
+    }
+}
+
+// *******************************************************
+// repostModeEvents:    Posts again the events that found the queue full
+static void repostModeEvents(HeliContext *heli, TickType_t now)
+{
+    control_t *ctl = &heli->ctl;
+    uint32_t pending;
+    uint8_t event;
+
+    lock(heli);
+    pending = ctl->pendingEvents;
+    ctl->pendingEvents = 0;
+    unlock(heli);
+
+    for (event = 0; pending != 0; event++, pending >>= 1)
+    {
+        if (pending & 1)
+        {
+            postModeEvent(heli, event, now);
+        }
+    }
+}
+
+// *******************************************************
+// heliInitControl:     Starts landed and paralysed, with the built in
+//                      manoeuvres and the reference trajectories at rest
+void heliInitControl(HeliContext *heli)
+{
+    control_t *ctl = &heli->ctl;
+
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->AltRef = ALT_REF_INIT;
+    ctl->YawRef = YAW_REF_INIT;
+    ctl->paralysed = true;
+
+    // Flight modes start landed
+    smInit(&ctl->heliModes, modeStates, modeTable, sizeof(modeTable) / sizeof(modeTable[0]),
+           Landed, heli, modeChanged);
+    smSetLock(&ctl->heliModes, lockModes, unlockModes);
+
+    // Built in manoeuvres until others are uploaded
+    memcpy(ctl->manoeuvrePrograms, manoeuvreBuiltIn, sizeof(ctl->manoeuvrePrograms));
+
+    // Reference trajectories start at rest
+    trajectoryInit(&ctl->altTraj, ALT_TRAJ_VEL, ALT_TRAJ_ACC, ALT_TRAJ_JERK);
+    trajectoryInit(&ctl->yawTraj, YAW_TRAJ_VEL, YAW_TRAJ_ACC, YAW_TRAJ_JERK);
+}
 
 // *******************************************************
 // initSwitch_PC4:      Initialises and sets up switch on PC4
 void initSwitch_PC4(void)
 {
-    // Initialise SW1
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOA));
-    GPIOPinTypeGPIOInput (GPIO_PORTA_BASE, GPIO_PIN_7);
-    GPIOPadConfigSet (GPIO_PORTA_BASE, GPIO_PIN_7, GPIO_STRENGTH_2MA,
-           GPIO_PIN_TYPE_STD_WPD);
+    heliInitControl(&g_heli);
+    g_heli.hooks.button = readButton;
+    g_heli.hooks.switchTimer = startSwitchTimer;
+    g_heli.hooks.record = recordBlackBox;
+    g_heli.hooks.trigger = triggerBlackBox;
+    g_heli.hooks.lock = enterCritical;
+    g_heli.hooks.unlock = exitCritical;
+    g_heli.hooks.outputsHeld = deadlineHolds;
+
+    // SW1 and the reset button are debounced by buttons4, which sends their
+    // changes here. initButtons must already have run.
+    switchEvents = xQueueCreate(SWITCH_QUEUE_LENGTH, sizeof(butEvent_t));
+    if (switchEvents == NULL || !buttonSubscribe(switchEvents, 1 << SWITCH1))
+    {
+        while(1);
+    }
+    heliSetSwitch(&g_heli, buttonPushed(SWITCH1));
 
     // Initialise PC4 used to find yaw ref
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
@@ -139,12 +405,8 @@ void initSwitch_PC4(void)
     GPIOPadConfigSet(GPIO_PORTC_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
     GPIOIntTypeSet(GPIO_PORTC_BASE, GPIO_PIN_4, GPIO_FALLING_EDGE); //Trigger interrupts on both edges of wave changes on PC4
     GPIOIntEnable(GPIO_PORTC_BASE, GPIO_INT_PIN_4); //Enable interrupts from PC4
-    GPIOIntRegister(GPIO_PORTC_BASE, YawRefIntHandler); //If interrupt occurs, run YawRefIntHandler
-    IntEnable(INT_GPIOC); //Enable interrupts on C.
-
-    //Initialise reset button
-    GPIOPinTypeGPIOInput (GPIO_PORTA_BASE, GPIO_PIN_6);
-    GPIODirModeSet(GPIO_PORTA_BASE, GPIO_PIN_6, GPIO_DIR_MODE_IN);
+    IntPrioritySet(INT_GPIOC, DEFER_ISR_PRIORITY);
+    VECTOR_REGISTER(INT_GPIOC, YawRefIntHandler); //If interrupt occurs, run YawRefIntHandler
 
     // Initialise switch timer
     switchTimer = xTimerCreate("switch timer", pdMS_TO_TICKS(MODE_CHANGE_TIME), pdFALSE, 0, switchTimerExpire);
@@ -153,54 +415,88 @@ void initSwitch_PC4(void)
         while(1);
     }
 
+    // Watch the control cycle, landing if it runs late. Starts the watchdog.
+    initDeadline(&g_heli, deadlineMissed);
+
 }
 
 // *******************************************************
-// updateReset:         Reads the reset button, reset system if reset is pushed
+// updateReset:         Resets the system if the debounced reset button is
+//                      pushed, each control cycle. The black box freezes
+//                      first so its capture survives into the next boot.
 void updateReset(void)
 {
-    uint32_t reset = GPIOPinRead(GPIO_PORTA_BASE, GPIO_PIN_6);
-    GPIOIntClear(GPIO_PORTA_BASE, GPIO_PIN_6);
-    if(reset == 0) {
+    if(buttonPushed(RESET_BUT)) {
+        blackBoxTrigger(BB_TRIG_RESET);
         SysCtlReset();
     }
 }
 
 
 // *******************************************************
-// GetSwitchState:      Reads the switch, if the program starts with the switch on,
+// heliSetSwitch:       Sets the debounced state of SW1
+void heliSetSwitch(HeliContext *heli, bool on)
+{
+    heli->ctl.switchState = on;
+}
+
+// *******************************************************
+// takeSwitchEvents:    Takes the debounced switch changes from buttons4
+static void takeSwitchEvents(void)
+{
+    butEvent_t event;
+
+    while (xQueueReceive(switchEvents, &event, 0) == pdPASS)
+    {
+        heliSetSwitch(&g_heli, event.state == PUSHED);
+    }
+}
+
+
+// *******************************************************
+// GetSwitchState:      Takes the debounced switch changes, if the program starts with the switch on,
 //                      the helicopter will be paralysed (not be able to take of)
-void GetSwitchState(void)
+void heliGetSwitchState(HeliContext *heli)
 {
-    switchState = GPIOPinRead (GPIO_PORTA_BASE, GPIO_PIN_7) / 128;
-    GPIOIntClear(GPIO_PORTA_BASE, GPIO_PIN_7);
+    control_t *ctl = &heli->ctl;
 
-    if((mode == Landed) && (switchState == 0) && paralysed)
+    if((ctl->heliModes.current == Landed) && (ctl->switchState == 0) && ctl->paralysed)
     {
-        paralysed = false;
+        ctl->paralysed = false;
     }
-    if ((mode == Flying || mode == Special) && (switchState == 0)) {
-        if(timerResetFlag == false)
+    if (smIn(&ctl->heliModes, InFlight) && (ctl->switchState == 0)) {
+        if(ctl->timerResetFlag == false)
         {
-            if (xTimerReset(switchTimer, portMAX_DELAY) != pdPASS)
+            if (heli->hooks.switchTimer != NULL)
             {
-                while(1);
+                heli->hooks.switchTimer(heli, ctl->now);
             }
-            timerResetFlag = true;
+            ctl->timerResetFlag = true;
         }
     }
 }
 
+void GetSwitchState(void)
+{
+    takeSwitchEvents();
+    heliGetSwitchState(&g_heli);
+}
+
 
 // *******************************************************
 // checkStability:      Checks if the helicopter has taken off, sets stable to true
-void checkStability(void)
+void heliCheckStability(HeliContext *heli)
 {
-    if(getAlt() >= 30) {
-        stable = true;
+    if(heliGetAlt(heli) >= 30) {
+        heli->ctl.stable = true;
     }
 }
 
+void checkStability(void)
+{
+    heliCheckStability(&g_heli);
+}
+
 
 int32_t clamp(int32_t x, int32_t min, int32_t max)
 {
@@ -214,212 +510,207 @@ int32_t clamp(int32_t x, int32_t min, int32_t max)
     return value;
 }
 
+
+// *******************************************************
+// clampDouble:         clamp for the PID terms, which must not be rounded
+//                      to whole percent before they reach the motors
+double clampDouble(double x, double min, double max)
+{
+    double value = x;
+    if(value > max)
+    {
+        value = max;
+    } else if(value < min){
+        value = min;
+    }
+    return value;
+}
+
 // *******************************************************
 // setAltRef:           Sets the altitude reference
 // TAKES:               New altitude reference as a percentage
+void heliSetAltRef(HeliContext *heli, int32_t newAltRef)
+{
+    heli->ctl.AltRef = clamp(newAltRef, 10, 100);
+}
+
 void setAltRef(int32_t newAltRef)
 {
-    AltRef = clamp(newAltRef, 10, 100);
+    heliSetAltRef(&g_heli, newAltRef);
 }
 
 
 // *******************************************************
 // setYawRef:           Sets the yaw reference
 // TAKES:               newYawRef, the new yaw reference as a percentage
-void setYawRef(int32_t newYawRef)
+void heliSetYawRef(HeliContext *heli, int32_t newYawRef)
 {
+    control_t *ctl = &heli->ctl;
+
     if(newYawRef == 0)
     {
         int32_t reference = newYawRef;
-        int32_t yaw = getYawTotal() % TOTAL_ANGLE;
+        int32_t yaw = heliGetYawTotal(heli) % TOTAL_ANGLE;
         if(yaw > 180)
         {
-            YawRef = reference + (360 - yaw);
+            ctl->YawRef = reference + (360 - yaw);
         }else {
-            YawRef = reference - yaw;
+            ctl->YawRef = reference - yaw;
         }
     }
 
-    YawRef = newYawRef;
+    ctl->YawRef = newYawRef;
+}
+
+void setYawRef(int32_t newYawRef)
+{
+    heliSetYawRef(&g_heli, newYawRef);
 }
 
 
 // *******************************************************
 // GetAltRef:           Returns the current reference for the altitude
 // RETURNS:             Altitude Reference as a int32_t
+int32_t heliGetAltRef(const HeliContext *heli)
+{
+    return heli->ctl.AltRef;
+}
+
 int32_t GetAltRef(void)
 {
-    return AltRef;
+    return heliGetAltRef(&g_heli);
 }
 
 
 // *******************************************************
 // GetYawRef:           Returns the current reference for the yaw
 // RETURNS:             Yaw Reference as a int32_t
+int32_t heliGetYawRef(const HeliContext *heli)
+{
+    return heli->ctl.YawRef;
+}
+
 int32_t GetYawRef(void)
 {
-    return YawRef;
+    return heliGetYawRef(&g_heli);
 }
 
 
 // *******************************************************
 // take_Off:            Checks if yaw is zero.
 //                      If this is true, sets Altitude Reference to 50%
-void take_Off(void)
+void heliTakeOff(HeliContext *heli)
 {
-    int32_t yaw = getYaw();
+    int32_t yaw = heliGetYaw(heli);
     if (abs(yaw) < 10) {
-        setAltRef(50);
+        heliSetAltRef(heli, 50);
     }
 }
 
+void take_Off(void)
+{
+    heliTakeOff(&g_heli);
+}
 
-void specialButtonMode(void)
+
+// *******************************************************
+// specialButtonMode:   In Special mode, starts the manoeuvre of the button
+//                      pushed (UP, DOWN, LEFT or RIGHT) unless one is running
+void heliSpecialButtonMode(HeliContext *heli)
 {
-    int32_t currentYaw = getYawTotal();
-    int32_t currentAlt = getAlt();
-    if(mode == Special)
+    control_t *ctl = &heli->ctl;
+    uint8_t butNo;
+
+    // Every button is read so pushes during a manoeuvre are not kept
+    for (butNo = UP; butNo < NUM_BUTS; butNo++)
     {
-        if (checkButton (UP) == PUSHED)
-        {
-            specialTrick = SpiralUp;
-        }
-        if (checkButton (DOWN) == PUSHED)
+        if ((button(heli, butNo) == PUSHED) && (ctl->heliModes.current == Special) &&
+            (ctl->manoeuvre.status != MV_RUNNING) &&
+            manoeuvreStart(&ctl->manoeuvre, ctl->manoeuvrePrograms[butNo],
+                           ctl->AltRef, ctl->YawRef))
         {
-            specialTrick = SpiralDown;
-        }
-        if (checkButton (LEFT) == PUSHED )
-        {
-            specialTrick = Spin180Left;
-        }
-        if (checkButton (RIGHT) == PUSHED)
-        {
-            specialTrick = Spin180Right;
+            ctl->manoeuvreSlot = butNo;
+            record(heli, BB_MANOEUVRE, MV_RUNNING, butNo, 0);
         }
     }
 }
 
-void spiralTrick(void)
+void specialButtonMode(void)
 {
-    if(specialTrick == SpiralUp)
-    {
-        int32_t currentYaw = getYawTotal();
-        int32_t currentYaw180 = getYaw();
-        int32_t currentAlt = getAlt();
-        int32_t refAlt = GetAltRef();
-        int32_t refYaw = GetYawRef();
+    heliSpecialButtonMode(&g_heli);
+}
 
-        if(spiralSetUp == false)
-        {
-            setYawRef(0);
-            setAltRef(10);
-            if(currentAlt == 10)
-            {
-                spiralSetUp = true;
-            }
-        }
 
-        if(spiralSetUp == true)
-        {
-            if ((currentAlt > 80 && currentAlt < 96) && abs(currentYaw180) < 8)
-            {
-                spiralSetUp = false;
-                specialTrick = Normal;
-            } else {
-                if (((currentAlt < refAlt + 5) && (currentAlt < refAlt + 5)) &&
-                        ((currentYaw < refYaw + 5) && (currentYaw < refYaw + 5)))
-                {
-                    setAltRef(GetAltRef() + 10);
-                    setYawRef(GetYawRef() + 45);
-                }
-            }
+// *******************************************************
+// updateManoeuvre:     Steps the running manoeuvre and passes its references
+//                      on. A manoeuvre that times out holds its references.
+void heliUpdateManoeuvre(HeliContext *heli)
+{
+    control_t *ctl = &heli->ctl;
+    mvStatus_t status;
 
-        }
-    } else if(specialTrick == SpiralDown)
+    if (ctl->manoeuvre.status != MV_RUNNING)
     {
-        int32_t currentYaw = getYawTotal();
-        int32_t currentYaw180 = getYaw();
-        int32_t currentAlt = getAlt();
-        int32_t refAlt = GetAltRef();
-        int32_t refYaw = GetYawRef();
-
-        if(spiralSetUp == false)
-        {
-            setYawRef(0);
-            setAltRef(90);
-            if(currentAlt == 90)
-            {
-                spiralSetUp = true;
-            }
-        }
+        return;
+    }
+    status = manoeuvreStep(&ctl->manoeuvre, heliGetAltHundredths(heli),
+                           heliGetYawTotalHundredths(heli), ctl->controlPeriodMs);
+    heliSetAltRef(heli, ctl->manoeuvre.altRef);
+    heliSetYawRef(heli, ctl->manoeuvre.yawRef);
 
-        if(spiralSetUp == true)
+    if (status != MV_RUNNING)
+    {
+        record(heli, BB_MANOEUVRE, status, ctl->manoeuvreSlot, ctl->manoeuvre.pc);
+        if (status == MV_TIMED_OUT)
         {
-            if ((currentAlt > 0 && currentAlt < 16) && abs(currentYaw180) < 8)
-            {
-                spiralSetUp = false;
-                specialTrick = Normal;
-            } else {
-                if (((currentAlt < refAlt + 5) && (currentAlt < refAlt + 5)) &&
-                        ((currentYaw < refYaw + 5) && (currentYaw < refYaw + 5)))
-                {
-                    setAltRef(GetAltRef() - 10);
-                    setYawRef(GetYawRef() - 45);
-                }
-            }
-
+            trigger(heli, BB_TRIG_ERROR);
         }
     }
 }
 
-
-// Here I switched around the + and - on Left and Right to match in IRL. Right now, spint right goes out of control, yaw keeps going doesnt stop
-void spinTrick(void)
+void updateManoeuvre(void)
 {
-    if(specialTrick == Spin180Left)
-    {
-        int32_t currentYaw = getYawTotal();
+    heliUpdateManoeuvre(&g_heli);
+}
 
-        if(spinSetUp == false)
-        {
-            error = currentYaw + 180;
-            setYawRef(error);
-            spinSetUp = true;
-        } else {
-            spinSetUp = false;
-            specialTrick = Normal;
-        }
 
-//        if((currentYaw < error - 5) && (currentYaw > error + 5))
-//        {
-//            setYawRef(currentYaw + 10);
-//        } else {
-//            spinSetUp = false;
-//            specialTrick = Normal;
-//        }
-    } else if(specialTrick == Spin180Right)
+// *******************************************************
+// uploadManoeuvre:     Installs a manoeuvre received over UART in place of
+//                      the program of its slot, unless that slot is flying
+// TAKES:               line, the upload line, see manoeuvreParseUpload
+// RETURNS:             true if the program was installed
+bool heliUploadManoeuvre(HeliContext *heli, const char *line)
+{
+    control_t *ctl = &heli->ctl;
+    mvInstr_t program[MV_MAX_LENGTH];
+    int32_t length;
+    uint8_t slot;
+    bool installed = false;
+
+    length = manoeuvreParseUpload(line, program, &slot);
+    if (length < 0)
     {
-        int32_t currentYaw = getYawTotal();
-
-        if(spinSetUp == false)
-        {
-            error = currentYaw - 180;
-            setYawRef(error);
-            spinSetUp = true;
-        } else {
-            spinSetUp = false;
-            specialTrick = Normal;
-        }
+        return false;
+    }
 
-//        if((currentYaw < error - 5) && (currentYaw > error + 5))
-//        {
-//            setYawRef(currentYaw - 15);
-//        } else {
-//            spinSetUp = false;
-//            specialTrick = Normal;
-//        }
+    // The control task may start or step a manoeuvre at any time
+    lock(heli);
+    if ((ctl->manoeuvre.status != MV_RUNNING) || (ctl->manoeuvreSlot != slot))
+    {
+        memcpy(ctl->uploadedPrograms[slot], program, length * sizeof(mvInstr_t));
+        ctl->manoeuvrePrograms[slot] = ctl->uploadedPrograms[slot];
+        installed = true;
     }
+    unlock(heli);
+    return installed;
+}
+
+bool uploadManoeuvre(const char *line)
+{
+    return heliUploadManoeuvre(&g_heli, line);
 }
+
+
 // *******************************************************
 // findYawRef:          Turns on main and tail motor. Spins the helicopter clockwise
 //                      and  reads PC4 to check if the helicopter is at the reference
@@ -437,165 +728,292 @@ void spinTrick(void)
 //    }
 //}
 
-void YawRefIntHandler(void)
+// *******************************************************
+// heliRefFound:        While initialising, zeroes the yaw where it was at
+//                      the falling edge and tells the mode machine. The yaw
+//                      profile restarts in the new frame, so TakeOff does not
+//                      sweep from where the old frame put the reference.
+void heliRefFound(HeliContext *heli, int32_t capturedSlot, TickType_t now)
 {
-    GPIOIntClear(GPIO_PORTC_BASE, GPIO_PIN_4);
+    control_t *ctl = &heli->ctl;
 
-    if (ref_Found == false)
+    if (ctl->refArmed)
     {
-        ref_Found = true; //Origin Found
-        resetYaw(); //Reset current yaw value to 0
-        setYawRef(0); // Resets yaw reference to 0
+        ctl->refArmed = false;
+        heliResetYawAt(heli, capturedSlot);
+        trajectoryReset(&ctl->yawTraj, heliGetYawTotalHundredths(heli));
+        postModeEvent(heli, EV_REF_FOUND, now);
     }
 }
 
+// *******************************************************
+// refFound:            Deferred from YawRefIntHandler
+static void refFound(uint32_t capturedSlot)
+{
+    heliRefFound(&g_heli, (int32_t)capturedSlot, xTaskGetTickCount());
+}
+
+// *******************************************************
+// YawRefIntHandler:    PC4 falls at the yaw reference. Captures the slot
+//                      count and leaves the rest to the control task.
+void YawRefIntHandler(void)
+{
+    uint32_t entered = PERF_CYCLES();
+
+    fastGPIOIntClear(GPIO_PORTC_BASE, GPIO_PIN_4);
+    deferFromISR(PERF_REF_ISR, entered, refFound, (uint32_t)yawSlot());
+}
+
 // *******************************************************
 // landing:             Once yaw is within 5 degrees of 0,
 //                      decrease altitude by 5% if over 10%
 //                      If altitude is under 10%, shut off motors
-void landing(void)
+void heliLanding(HeliContext *heli)
 {
 
-    if (YawRef != 0)
+    if (heli->ctl.YawRef != 0)
     {
-        setYawRef(0);
+        heliSetYawRef(heli, 0);
     }
 
-    int32_t currentYaw = getYaw();
-    int32_t currentAlt = getAlt();
-    if (abs(currentYaw) < 10)
+    int32_t currentYaw = heliGetYaw(heli);
+    int32_t currentAlt = heliGetAlt(heli);
+    if (abs(currentYaw) < LAND_YAW)
     {
         if (currentAlt > 10)
         {
-            setAltRef(currentAlt - 15);
+            heliSetAltRef(heli, currentAlt - 15);
         }
         else
         {
-            SetMainPWM(0);
-            SetTailPWM(0);
+            heliMotorOutputStop(heli);
         }
     } else {
-        setAltRef(30);
+        heliSetAltRef(heli, 30);
     }
 
 
 }
 
+void landing(void)
+{
+    heliLanding(&g_heli);
+}
+
 
 // *******************************************************
 //  PIDControlYaw:      Uses PID control during TakeOff, Flying and Landing modes
 //                      Ensures the yaw follows the yaw reference
-void PIDControlYaw(void)
+RAMFUNC void heliPIDControlYaw(HeliContext *heli)
 {
-    if( (mode == TakeOff) || (mode == Flying) || (mode == Special) || (mode == Landing))
+    control_t *ctl = &heli->ctl;
+
+    if (smIn(&ctl->heliModes, Powered))
     {
         int32_t currentYaw = 0;
-        if (mode == Landing)
+        int32_t mainPermille, learnt;
+        if (ctl->heliModes.current == Landing)
         {
-            currentYaw = getYaw();
+            currentYaw = heliGetYawHundredths(heli);
         } else {
-            currentYaw = getYawTotal();
+            currentYaw = heliGetYawTotalHundredths(heli);
+        }
+
+        // The reference follows a smooth profile to YawRef. Landing measures
+        // yaw in -180..180, so the profile restarts from there on the change.
+        if ((ctl->heliModes.current == Landing) != ctl->yawTrajWrapped)
+        {
+            ctl->yawTrajWrapped = (ctl->heliModes.current == Landing);
+            trajectoryReset(&ctl->yawTraj, currentYaw);
         }
+        trajectorySetTarget(&ctl->yawTraj, ctl->YawRef * FIXED_SCALE);
+        trajectoryStep(&ctl->yawTraj, ctl->controlPeriodMs);
 
-        Yaw_error = YawRef - currentYaw;  // Calculates the yaw error
+        // Calculates the yaw error in degrees, to 0.01 degree resolution
+        ctl->Yaw_error = FIXED_TO_DOUBLE(ctl->yawTraj.pos - currentYaw);
 
-        if(getTailPWM() <85 && getTailPWM() > 5)
+        if(heliGetTailPWM(heli) <85 && heliGetTailPWM(heli) > 5)
+        {
+            ctl->YawIntError += ctl->Yaw_error * DELTA_T;  //Integral error
+        }
+        ctl->YawDerivError  = ctl->Yaw_error-ctl->YawPreviousError;  //Derivative error
+
+        // In steady hover, hand what the integrator has found over to the
+        // torque feedforward table, keeping the total output unchanged
+        mainPermille = heliGetMainPWMPermille(heli);
+        if ((ctl->heliModes.current == Flying) && (fabs(ctl->Yaw_error) < FF_STEADY_YAW) &&
+            (fabs(ctl->Alt_error) < FF_STEADY_ALT) &&
+            (ctl->yawTraj.vel == 0) && (ctl->altTraj.vel == 0))
         {
-            YawIntError += Yaw_error * DELTA_T;  //Integral error
+            if (++ctl->steadyCycles >= FF_STEADY_CYCLES)
+            {
+                learnt = torqueFFLearn(&heli->torque, mainPermille,
+                                       ctl->YawIntError * YAW_INT_CONTROL * 10);
+                ctl->YawIntError -= learnt / (10 * YAW_INT_CONTROL);
+            }
+        } else {
+            ctl->steadyCycles = 0;
         }
-        YawDerivError  = Yaw_error-YawPreviousError;  //Derivative error
 
-        YawControl = clamp(Yaw_error * YAW_PROP_CONTROL, -30, 30)      //yaw control based on PID terms
-                    + YawIntError * YAW_INT_CONTROL
-                    + clamp(YawDerivError * YAW_DIF_CONTROL, -30, 30)
-                    + TAIL_OFFSET;
+        ctl->YawControl = clampDouble(ctl->Yaw_error * YAW_PROP_CONTROL, -30, 30)      //yaw control based on PID terms
+                    + ctl->YawIntError * YAW_INT_CONTROL
+                    + clampDouble(ctl->YawDerivError * YAW_DIF_CONTROL, -30, 30)
+                    + torqueFF(&heli->torque, mainPermille) / 10.0       //cancels the main rotor torque
+                    + FIXED_TO_DOUBLE(ctl->yawTraj.vel) * YAW_VEL_FF;    //reference velocity feedforward
 
 
-        YawControl = clamp(YawControl, 10, 90);
-        SetTailPWM(YawControl);  //Sets the tail duty cycle
-        YawPreviousError = Yaw_error;
-        tailDuty = YawControl;
+        ctl->YawControl = clampDouble(ctl->YawControl, DUTY_MIN, DUTY_MAX);
+
+        record(heli, BB_YAW_PI, ctl->heliModes.current, ctl->Yaw_error * YAW_PROP_CONTROL * 100,
+               ctl->YawIntError * YAW_INT_CONTROL * 100);
+        record(heli, BB_YAW_DU, ctl->heliModes.current, ctl->YawDerivError * YAW_DIF_CONTROL * 100,
+               ctl->YawControl * 100);
+        triggerOnAlarm(heli, ALARM_YAW_SATURATED,
+                       ctl->YawControl == DUTY_MIN || ctl->YawControl == DUTY_MAX,
+                       BB_TRIG_SATURATION);
+        triggerOnAlarm(heli, ALARM_YAW_ERROR, abs((int32_t)ctl->Yaw_error) > BB_YAW_ERROR,
+                       BB_TRIG_ERROR);
+
+        heliMotorOutputSetTail(heli, ctl->YawControl * 10 + 0.5);  //Sets the tail duty cycle to 0.1%
+        ctl->YawPreviousError = ctl->Yaw_error;
+        ctl->tailDuty = ctl->YawControl;
+    } else {
+        // Not flying: the profile waits at rest on the measured yaw
+        ctl->yawTrajWrapped = false;
+        trajectoryReset(&ctl->yawTraj, heliGetYawTotalHundredths(heli));
+        ctl->alarms &= ~(ALARM_YAW_SATURATED | ALARM_YAW_ERROR);
     }
 }
 
+void PIDControlYaw(void)
+{
+    heliPIDControlYaw(&g_heli);
+}
+
 
 // *******************************************************
 // PIDControlAlt:       Uses PID control during TakeOff, Flying and Landing modes
 //                      Ensures the altitude follows the altitude reference
-void PIDControlAlt(void)
+RAMFUNC void heliPIDControlAlt(HeliContext *heli)
 {
-    if ((mode == TakeOff) || (mode == Flying) || (mode == Special) || (mode == Landing)) {
+    control_t *ctl = &heli->ctl;
 
-        Alt_error = AltRef - getAlt();  //Calculates altitude error
+    if (smIn(&ctl->heliModes, Powered)) {
+        altSchedule_t hoverSchedule, gainSchedule;
 
-        if(getMainPWM() <85 && getMainPWM() > 5)
-        {
-            AltIntError += Alt_error * DELTA_T;  //Integral error
-        }
+        // The reference follows a smooth profile to AltRef
+        trajectorySetTarget(&ctl->altTraj, ctl->AltRef * FIXED_SCALE);
+        trajectoryStep(&ctl->altTraj, ctl->controlPeriodMs);
 
-        AltDerivError = (Alt_error-AltPreviousError) * 100;  //Derivative error
+        //Calculates altitude error in percent, to 0.01% resolution
+        ctl->Alt_error = FIXED_TO_DOUBLE(ctl->altTraj.pos - heliGetAltHundredths(heli));
 
-        AltControl = Alt_error * ALT_PROP_CONTROL//clamp(Alt_error * ALT_PROP_CONTROL, -50, 50)  //Altitude control based on the PID terms
-                    + AltIntError * ALT_INT_CONTROL
-                    + AltDerivError * ALT_DIF_CONTROL//clamp(AltDerivError * ALT_DIF_CONTROL, -30, 30)
-                    + MAIN_OFFSET;
+        // Hover duty at the reference, gains at the current altitude
+        altScheduleLookup(ctl->altTraj.pos, &hoverSchedule);
+        altScheduleLookup(heliGetAltHundredths(heli), &gainSchedule);
 
-        AltControl = clamp(AltControl, 10, 90);
+        // The integral is kept already multiplied by its gain, so a change
+        // of gain with altitude does not make the output jump
+        if(heliGetMainPWM(heli) <85 && heliGetMainPWM(heli) > 5)
+        {
+            ctl->AltIntError += gainSchedule.ki * ctl->Alt_error * DELTA_T;  //Integral error
+        }
 
-        SetMainPWM(AltControl);  //Sets the main duty cycle
-        AltPreviousError = Alt_error;
-        mainDuty = AltControl;
+        ctl->AltDerivError = (ctl->Alt_error-ctl->AltPreviousError) * 100;  //Derivative error
+
+        ctl->AltControl = ctl->Alt_error * gainSchedule.kp  //Altitude control based on the PID terms
+                    + ctl->AltIntError
+                    + ctl->AltDerivError * gainSchedule.kd
+                    + hoverSchedule.hover
+                    + FIXED_TO_DOUBLE(ctl->altTraj.vel) * ALT_VEL_FF;  //reference velocity feedforward
+
+        ctl->AltControl = clampDouble(ctl->AltControl, DUTY_MIN, DUTY_MAX);
+
+        record(heli, BB_ALT_PI, ctl->heliModes.current, ctl->Alt_error * gainSchedule.kp * 100,
+               ctl->AltIntError * 100);
+        record(heli, BB_ALT_DU, ctl->heliModes.current, ctl->AltDerivError * gainSchedule.kd * 100,
+               ctl->AltControl * 100);
+        triggerOnAlarm(heli, ALARM_ALT_SATURATED,
+                       ctl->AltControl == DUTY_MIN || ctl->AltControl == DUTY_MAX,
+                       BB_TRIG_SATURATION);
+        triggerOnAlarm(heli, ALARM_ALT_ERROR, abs((int32_t)ctl->Alt_error) > BB_ALT_ERROR,
+                       BB_TRIG_ERROR);
+
+        heliMotorOutputSetMain(heli, ctl->AltControl * 10 + 0.5);  //Sets the main duty cycle to 0.1%
+        ctl->AltPreviousError = ctl->Alt_error;
+        ctl->mainDuty = ctl->AltControl;
+    } else {
+        // Not flying: the profile waits at rest on the measured altitude
+        trajectoryReset(&ctl->altTraj, heliGetAltHundredths(heli));
+        ctl->alarms &= ~(ALARM_ALT_SATURATED | ALARM_ALT_ERROR);
     }
 }
 
+void PIDControlAlt(void)
+{
+    heliPIDControlAlt(&g_heli);
+}
+
 
 // *******************************************************
 // getMainDuty:         Returns main rotor duty cycle
 // RETURNS:             The main duty cycle as a uint32_t
+uint32_t heliGetMainDuty(const HeliContext *heli)
+{
+    return heli->ctl.mainDuty;
+}
+
 uint32_t getMainDuty(void)
 {
-    return mainDuty;
+    return heliGetMainDuty(&g_heli);
 }
 
 
 // *******************************************************
 // getTailDuty:         Returns tail duty cycle
 // RETURNS:             The tail rotor duty cycle as a uint32_t
+uint32_t heliGetTailDuty(const HeliContext *heli)
+{
+    return heli->ctl.tailDuty;
+}
+
 uint32_t getTailDuty(void)
 {
-    return tailDuty;
+    return heliGetTailDuty(&g_heli);
 }
 
 
 // *******************************************************
 // getMode:             Finds the current mode of the helicopter
 // RETURNS:             A char* containing the current mode
-char* getMode(void)
+char* heliGetMode(const HeliContext *heli)
 {
-    switch(mode)
-    {
-    case Landed: return "Landed";
-    case Initialising: return "Initialising";
-    case TakeOff:  return "TakeOff";
-    case Flying: return"Flying";
-    case Special: return"Special";
-    case Landing: return "Landing";
-    }
+    return (char *)modeStates[heli->ctl.heliModes.current].name;
+}
 
-   return NULL;
+char* getMode(void)
+{
+    return heliGetMode(&g_heli);
 }
 
 
 // *******************************************************
 // resetIntControl:     Reset all error and integral error to 0
+void heliResetIntControl(HeliContext *heli)
+{
+    control_t *ctl = &heli->ctl;
+
+    ctl->Alt_error = 0;
+    ctl->AltIntError = 0;
+    ctl->AltPreviousError = 0;
+    ctl->Yaw_error = 0;
+    ctl->YawIntError = 0;
+    ctl->YawPreviousError = 0;
+}
+
 void resetIntControl(void)
 {
-    Alt_error = 0;
-    AltIntError = 0;
-    AltPreviousError = 0;
-    Yaw_error = 0;
-    YawIntError = 0;
-    YawPreviousError = 0;
+    heliResetIntControl(&g_heli);
 }
 
 
@@ -604,125 +1022,257 @@ void resetIntControl(void)
 //                      Checks button status and changes reference altitudes and yaws
 //                      UP and DOWN are used to increase/decrease altitude reference
 //                      LEFT and RIGHT are used to increase/decrease yaw reference
-void RefUpdate(void)
+void heliRefUpdate(HeliContext *heli)
 {
-    if(mode == Flying) {
-        if ((checkButton (UP) == PUSHED) && (AltRef < ALT_MAX))
+    control_t *ctl = &heli->ctl;
+
+    if(ctl->heliModes.current == Flying) {
+        if ((button(heli, UP) == PUSHED) && (ctl->AltRef < ALT_MAX))
         {
-            setAltRef(GetAltRef() + ALT_STEP_RATE);
+            heliSetAltRef(heli, heliGetAltRef(heli) + ALT_STEP_RATE);
         }
-        if ((checkButton (DOWN) == PUSHED) && (AltRef > ALT_MIN))
+        if ((button(heli, DOWN) == PUSHED) && (ctl->AltRef > ALT_MIN))
         {
-            setAltRef(GetAltRef() - ALT_STEP_RATE);
+            heliSetAltRef(heli, heliGetAltRef(heli) - ALT_STEP_RATE);
         }
-        if (checkButton (LEFT) == PUSHED )
+        if (button(heli, LEFT) == PUSHED )
         {
-            YawRef -= YAW_STEP_RATE;
+            ctl->YawRef -= YAW_STEP_RATE;
         }
-        if (checkButton (RIGHT) == PUSHED)
+        if (button(heli, RIGHT) == PUSHED)
         {
-            YawRef += YAW_STEP_RATE;
+            ctl->YawRef += YAW_STEP_RATE;
         }
 
     }
 }
 
+void RefUpdate(void)
+{
+    heliRefUpdate(&g_heli);
+}
+
 
 // *******************************************************
-// helicopterStates:    Switches mode between the 5 modes
-void helicopterStates(void){
+// Mode machine guards, actions and state functions, each given the context
 
-    switch(mode) {
-    case Landed:
+// Switch on, not paralysed and the ground is known
+static bool readyToFly(void *owner)
+{
+    HeliContext *heli = owner;
 
-        if (switchState == 1 && !paralysed) {  //If switch is flicked on and the helicopter is not paralysed
-            mode = Initialising;               // Change mode to Initialising
-            resetIntControl();                 //Reset any previous error terms
+    return heli->ctl.switchState == 1 && !heli->ctl.paralysed &&
+           heliAltitudeCalibrated(heli);
+}
 
-            //Sets initial power percentages
-            SetMainPWM(15);
-            SetTailPWM(20);
-        }
-        break;
+static bool isStable(void *owner)
+{
+    return ((HeliContext *)owner)->ctl.stable;
+}
 
-    case Initialising:
+static bool switchOn(void *owner)
+{
+    return ((HeliContext *)owner)->ctl.switchState == 1;
+}
 
-//        findYawRef();                          //Spins clockwise until the reference point is found
-        if(ref_Found) {
-            mode = TakeOff;
-            ref_Found = false;//Change mode to takeoff once the reference point is found
-        }
-        break;
+// A landing begun in flight only ends on the ground facing the reference.
+// Touching down on the way round, as a descending altitude reference can
+// make it, leaves it landing, so it climbs back and finishes the turn.
+static bool isOnGround(void *owner)
+{
+    HeliContext *heli = owner;
 
-    case TakeOff:
+    return heliGetAlt(heli) == 0 &&
+           (!heli->ctl.landingAloft || abs(heliGetYaw(heli)) < LAND_YAW);
+}
 
-        take_Off();                            //Set yaw to 0 and raises the helicopter up to 50% altitude
-        checkStability();
-        if(stable) {
-            mode = Flying;                     //Once the reference point is met and the correct altitude is reached set the state to flying
-        }
-        break;
+// Resets any previous error terms and ramps the initial power up gently
+static void startMotors(void *owner)
+{
+    ((HeliContext *)owner)->ctl.timerResetFlag = false;
+    heliResetIntControl(owner);
+    heliMotorOutputSoftStart(owner, 150, 200);
+}
 
-    case Flying:
+static void zeroYawRef(void *owner)
+{
+    heliSetYawRef(owner, 0);
+}
 
-        RefUpdate();                           //Checks if for button pushes and alter references
-        break;
+// On the ground the PID loops stop, so the rotors are stopped here rather
+// than left slewing to their last targets, however the landing ended
+static void enterLanded(void *owner)
+{
+    heliMotorOutputStop(owner);
+    heliResetIntControl(owner);
+}
 
-    case Special:
+// Lets the PC4 interrupt zero the yaw at the reference
+static void enterInitialising(void *owner)
+{
+    ((HeliContext *)owner)->ctl.refArmed = true;
+}
 
-        specialButtonMode();
-        spiralTrick();
-        spinTrick();
-        break;
+// Notes whether the landing has to come down from the air, see isOnGround.
+// Only one from Initialising starts on the ground.
+static void enterLanding(void *owner)
+{
+    control_t *ctl = &((HeliContext *)owner)->ctl;
 
-    case Landing:
-        landing();
+    ctl->landingAloft = smLogEntry(&ctl->heliModes, 0)->from != Initialising;
+}
 
-        if (getAlt() == 0) {          //If altitude is at 0, change mode to landed
-            mode = Landed;
-        }
-        break;
+// Sets yaw to 0 and raises the helicopter up to 50% altitude
+static void duringTakeOff(void *owner)
+{
+    heliTakeOff(owner);
+    heliCheckStability(owner);
+}
+
+static void duringFlying(void *owner)
+{
+    heliRefUpdate(owner);
+}
+
+static void duringSpecial(void *owner)
+{
+    heliSpecialButtonMode(owner);          //Starts a manoeuvre on a button push
+    heliUpdateManoeuvre(owner);
+}
+
+static void duringLanding(void *owner)
+{
+    heliLanding(owner);
+}
+
+
+// *******************************************************
+// helicopterStates:    Runs the mode machine for one control cycle: the work
+//                      of the current mode, then any transition it is ready for
+void heliStates(HeliContext *heli)
+{
+    smTick(&heli->ctl.heliModes, heli->ctl.now);
+}
+
+void helicopterStates(void)
+{
+    heliStates(&g_heli);
+}
+
+
+// *******************************************************
+// getModeTransition:   RETURNS the n'th most recent mode transition (0 is the
+//                      latest) with its time and latency, or NULL
+const smLogEntry_t *heliGetModeTransition(const HeliContext *heli, uint32_t n)
+{
+    return smLogEntry(&heli->ctl.heliModes, n);
+}
+
+const smLogEntry_t *getModeTransition(uint32_t n)
+{
+    return heliGetModeTransition(&g_heli, n);
+}
+
+
+// *******************************************************
+// getModeTransitionCount: RETURNS the number of mode transitions since start up
+uint32_t heliGetModeTransitionCount(const HeliContext *heli)
+{
+    return heli->ctl.heliModes.numLogged;
+}
+
+uint32_t getModeTransitionCount(void)
+{
+    return heliGetModeTransitionCount(&g_heli);
+}
+
+
+// *******************************************************
+// heliUpdateControl:   Runs one control cycle. Both rotors are committed
+//                      together once the controllers and mode logic have run,
+//                      unless the owner holds them, as g_heli's deadline
+//                      monitor does for a stalled descent.
+void heliUpdateControl(HeliContext *heli, TickType_t now)
+{
+    control_t *ctl = &heli->ctl;
+
+    ctl->now = now;
+    ctl->controlPeriodMs = (now - ctl->lastUpdate) * portTICK_PERIOD_MS;
+    ctl->lastUpdate = now;
+
+    heliGetSwitchState(heli);
+    repostModeEvents(heli, now);
+    smRun(&ctl->heliModes, now);    //Mode changes queued by timers and deferred work
+    heliPIDControlAlt(heli);
+    heliPIDControlYaw(heli);
+    heliStates(heli);
+
+    lock(heli);
+    if (!outputsHeld(heli))
+    {
+        heliMotorOutputApply(heli, ctl->controlPeriodMs);
     }
+    unlock(heli);
+}
+
+// *******************************************************
+// updateControl:       Runs one control cycle of g_heli, called each time a
+//                      new altitude is ready
+void updateControl(void)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    deadlineCycleStart();
+    deferRun();             //Work left by the PC4 interrupt
+    takeSwitchEvents();
+    updateReset();
+    heliUpdateControl(&g_heli, now);
+    deadlineCycleEnd();
 }
 
 
 void vControlTask (void *pvParameters)
 {
-//    TickType_t xDelay10s = pdMS_TO_TICKS(30);
-//    TickType_t xLastWakeTime;
-//    xLastWakeTime = xTaskGetTickCount();
+    bootMark(BOOT_SCHEDULER);
 
     for ( ;; )
     {
-//        vTaskDelayUntil(&xLastWakeTime, xDelay10s);
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        GetSwitchState();
-        PIDControlAlt();
-        PIDControlYaw();
-        helicopterStates();
-
+        updateControl();
     }
 }
 
-// The handler for the switch timer. Should switch to landing mode or the second control mode.
+// *******************************************************
+// heliDeadlineMissed:  The control cycle is running late; land
+void heliDeadlineMissed(HeliContext *heli, TickType_t now)
+{
+    postModeEvent(heli, EV_DEADLINE, now);
+}
+
+// *******************************************************
+// deadlineMissed:      The deadline monitor has degraded; land. Queued, so
+//                      it is safe from the monitor's timer callback.
+static void deadlineMissed(HeliContext *heli)
+{
+    heliDeadlineMissed(heli, xTaskGetTickCount());
+}
+
+// *******************************************************
+// heliSwitchTimerExpired: The switch has been down for MODE_CHANGE_TIME. The
+//                      mode machine decides between landing (switch still
+//                      down) and swapping between Flying and Special.
+//                      The timer has stopped whether or not a transition
+//                      follows, so switch down may start it again.
+void heliSwitchTimerExpired(HeliContext *heli, TickType_t now)
+{
+    heli->ctl.timerResetFlag = false;
+    postModeEvent(heli, EV_SWITCH_TIMER, now);
+}
+
+// *******************************************************
+// switchTimerExpire:   The switch timer of g_heli, see heliSwitchTimerExpired
 void switchTimerExpire(TimerHandle_t pxTimer)
 {
-    if (switchState == 0)
-    {
-        mode = Landing;
-        setYawRef(0);                      //Set yaw reference to 0
-    }
-    else
-    {
-        if (mode == Flying)
-        {
-            mode = Special;
-        }
-        else if (mode == Special)
-        {
-            mode = Flying;
-        }
-    }
-    timerResetFlag = false;
+    heliSwitchTimerExpired(&g_heli, xTaskGetTickCount());
 }
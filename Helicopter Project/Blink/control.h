@@ -14,8 +14,60 @@
 #define CONTROL_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "FreeRTOS.h"
 #include "timers.h"
+#include "stateMachine.h"
+#include "trajectory.h"
+#include "manoeuvre.h"
+
+// *******************************************************
+// The controllers, references and modes of one helicopter, kept in its
+// context (see heliContext.h). The global API below runs on g_heli.
+typedef struct {
+    int32_t AltRef;                     //Altitude and yaw references
+    int32_t YawRef;
+
+    //Integral and previous errors
+    double AltIntError;
+    double AltPreviousError;
+    double YawIntError;
+    double YawPreviousError;
+    uint32_t steadyCycles;
+
+    //Smooth references followed by the PID loops; AltRef and YawRef are their targets
+    trajectory_t altTraj;
+    trajectory_t yawTraj;
+    bool yawTrajWrapped;                //Yaw trajectory in -180..180 (Landing) frame
+    TickType_t now;                     //Start of the current control cycle
+    TickType_t lastUpdate;
+    uint32_t controlPeriodMs;           //Length of the current control cycle
+
+    //Yaw and altitude error and control variables
+    double Yaw_error, YawDerivError;
+    double YawControl;
+    double Alt_error, AltDerivError;
+    double AltControl;
+
+    //Main and tail duty cycle
+    double mainDuty, tailDuty;
+
+    uint32_t switchState;
+    bool stable, paralysed;
+    bool refArmed;                      //Set on entering Initialising, cleared at the reference
+    bool landingAloft;                  //Landing began in flight, not Initialising
+    bool timerResetFlag;                //Switch timer running
+    uint32_t pendingEvents;             //Mode events that found the queue full, one bit each
+    uint8_t alarms;                     //Black box trigger conditions holding, one bit each
+
+    stateMachine_t heliModes;
+
+    //Special mode manoeuvres, one program per button. Uploaded programs live in RAM.
+    manoeuvre_t manoeuvre;
+    uint8_t manoeuvreSlot;
+    const mvInstr_t *manoeuvrePrograms[MV_NUM_SLOTS];
+    mvInstr_t uploadedPrograms[MV_NUM_SLOTS][MV_MAX_LENGTH];
+} control_t;
 
 
 // *******************************************************
@@ -25,13 +77,13 @@ initSwitch_PC4(void);
 
 
 // *******************************************************
-// updateReset:         Reads the reset button, reset system if reset is pushed
+// updateReset:         Resets the system if the debounced reset button is pushed
 void
 updateReset(void);
 
 
 // *******************************************************
-// GetSwitchState:      Reads the switch, if the program starts with the switch on,
+// GetSwitchState:      Takes the debounced switch changes, if the program starts with the switch on,
 //                      the helicopter will be paralysed (not be able to take of)
 void
 GetSwitchState(void);
@@ -45,6 +97,12 @@ checkStability(void);
 int32_t
 clamp(int32_t x, int32_t min, int32_t max);
 
+// *******************************************************
+// clampDouble:         clamp for the PID terms, which must not be rounded
+//                      to whole percent before they reach the motors
+double
+clampDouble(double x, double min, double max);
+
 // *******************************************************
 // setAltRef:           Sets the altitude reference
 // TAKES:               New altitude reference as a percentage
@@ -79,11 +137,27 @@ void
 take_Off(void);
 
 
+// *******************************************************
+// specialButtonMode:   In Special mode, starts the manoeuvre of the button
+//                      pushed (UP, DOWN, LEFT or RIGHT) unless one is running
 void
 specialButtonMode(void);
 
+
+// *******************************************************
+// updateManoeuvre:     Steps the running manoeuvre and passes its references
+//                      on. A manoeuvre that times out holds its references.
 void
-spiralTrick(void);
+updateManoeuvre(void);
+
+
+// *******************************************************
+// uploadManoeuvre:     Installs a manoeuvre received over UART in place of
+//                      the program of its slot, unless that slot is flying
+// TAKES:               line, the upload line, see manoeuvreParseUpload
+// RETURNS:             true if the program was installed
+bool
+uploadManoeuvre(const char *line);
 
 // *******************************************************
 // findYawRef:          Turns on main and tail motor. Spins the helicopter clockwise
@@ -92,6 +166,9 @@ spiralTrick(void);
 //void
 //findYawRef(void);
 
+// *******************************************************
+// YawRefIntHandler:    PC4 falls at the yaw reference. While initialising,
+//                      zeroes the yaw at once and tells the mode machine.
 void
 YawRefIntHandler(void);
 
@@ -151,13 +228,35 @@ void
 RefUpdate(void);
 
 // *******************************************************
-// helicopterStates:    Switches mode between the 5 modes
+// helicopterStates:    Runs the mode machine for one control cycle: the work
+//                      of the current mode, then any transition it is ready for
 void
 helicopterStates(void);
 
+// *******************************************************
+// getModeTransition:   RETURNS the n'th most recent mode transition (0 is the
+//                      latest) with its time and latency, or NULL
+const smLogEntry_t *
+getModeTransition(uint32_t n);
+
+// *******************************************************
+// getModeTransitionCount: RETURNS the number of mode transitions since start up
+uint32_t
+getModeTransitionCount(void);
+
+// *******************************************************
+// updateControl:       Runs one control cycle, called each time a new
+//                      altitude is ready
+void
+updateControl(void);
+
 void
 vControlTask (void *pvParameters);
 
+// *******************************************************
+// switchTimerExpire:   The switch has been down for MODE_CHANGE_TIME. The
+//                      mode machine decides between landing (switch still
+//                      down) and swapping between Flying and Special.
 void
 switchTimerExpire(TimerHandle_t pxTimer);
 
@@ -46,12 +46,6 @@ bool createTasks (void)
         while (1); // error creating task, out of memory?
     }
 
-    if (pdTRUE != xTaskCreate(vButtonTask, "Buttons", TASK_STACK_DEPTH, NULL, 3,
-                           NULL))
-    { // (void *)1 is our pvParameters for our task func specifying PF_1
-        while (1); // error creating task, out of memory?
-    }
-
     if (pdTRUE != xTaskCreate(vMotorTask, "Motors", TASK_STACK_DEPTH, NULL, 3,
                                NULL))
     { // (void *)1 is our pvParameters for our task func specifying PF_1
@@ -0,0 +1,280 @@
+//*****************************************************************************
+//
+// deadline - Control cycle deadline monitor. Each cycle's period and
+//            execution time are checked against their budgets and misses
+//            are counted. Too many misses in a window degrade to a landing.
+//            A software timer, independent of the control task, catches a
+//            stalled control chain and ramps the rotors down itself. If the
+//            stall outlasts the descent the hardware watchdog is no longer
+//            fed and resets the board. Every escalation is recorded in the
+//            black box.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/watchdog.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "deadline.h"
+#include "heliContext.h"
+#include "blackBox.h"
+#include "perf.h"
+#include "vectors.h"
+
+static HeliContext *watched;             // The context whose cycle is watched
+static void (*degrade)(HeliContext *heli);
+static TimerHandle_t monitorTimer;
+static volatile TickType_t lastStart;
+static volatile bool armed = false;     // Set by the first control cycle
+static uint32_t startCycles;
+static bool cycleMissed;
+static uint32_t missHistory;            // One bit per cycle, newest in bit 0
+static deadlineStats_t stats;
+static int32_t descentMain, descentMain0, descentTail0;
+
+
+// *******************************************************
+// escalate:            Records a move to a worse level and lands
+static void escalate (uint8_t event, int32_t value)
+{
+    blackBoxRecord(BB_DEADLINE, event, value, stats.level);
+    blackBoxTrigger(BB_TRIG_DEADLINE);
+    if (degrade != NULL)
+    {
+        degrade(watched);
+    }
+}
+
+
+// *******************************************************
+// descend:             One step of the stalled descent. The main rotor
+//                      ramps down at DL_DESCENT_SLEW and the tail follows
+//                      in proportion so the yaw torque stays balanced. The
+//                      control task no longer commits outputs, but a stop
+//                      it made is kept. Called in a critical section.
+static void descend (void)
+{
+    if (heliMotorOutputGetMain(watched) < descentMain)
+    {
+        descentMain = heliMotorOutputGetMain(watched);
+    }
+    descentMain -= DL_DESCENT_SLEW * DL_CHECK_MS / 1000;
+    if (descentMain < 0)
+    {
+        descentMain = 0;
+    }
+    heliMotorOutputSetMain(watched, descentMain);
+    heliMotorOutputSetTail(watched,
+        descentMain0 > 0 ? descentTail0 * descentMain / descentMain0 : 0);
+    heliMotorOutputApply(watched, DL_CHECK_MS);
+}
+
+
+// *******************************************************
+// monitorExpire:       Monitor timer callback. The timer task runs above
+//                      every other task, so a busy or blocked control task
+//                      cannot hold it off. The outputs are taken over in a
+//                      critical section so a control cycle caught part way
+//                      through cannot commit between the snapshot and the
+//                      first descent step.
+static void monitorExpire (TimerHandle_t timer)
+{
+    uint32_t since;
+    bool stalled = false;
+
+    if (armed)
+    {
+        since = (xTaskGetTickCount() - lastStart) * portTICK_PERIOD_MS;
+        taskENTER_CRITICAL();
+        if (since >= DL_STALL_MS && stats.level < DL_STALLED)
+        {
+            stats.stalls++;
+            descentMain = descentMain0 = heliMotorOutputGetMain(watched);
+            descentTail0 = heliMotorOutputGetTail(watched);
+            stats.level = DL_STALLED;
+            stalled = true;
+        }
+        taskEXIT_CRITICAL();
+        if (stalled)
+        {
+            escalate(DL_EV_STALL, since);
+        }
+        if (stats.level == DL_STALLED)
+        {
+            taskENTER_CRITICAL();
+            descend();
+            if (since >= DL_RESET_MS)
+            {
+                stats.level = DL_RESETTING;
+                blackBoxRecord(BB_DEADLINE, DL_EV_WATCHDOG, since, DL_RESETTING);
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    if (stats.level != DL_RESETTING)
+    {
+        WatchdogIntClear(WATCHDOG0_BASE);
+    }
+}
+
+
+// *******************************************************
+// WatchdogIntHandler:  First watchdog time out. Left uncleared the second
+//                      resets the board; the NVIC line is masked so the
+//                      handler does not run again meanwhile.
+void WatchdogIntHandler (void)
+{
+    IntDisable(INT_WATCHDOG);
+    blackBoxRecord(BB_DEADLINE, DL_EV_WATCHDOG, 0, stats.level);
+    blackBoxTrigger(BB_TRIG_DEADLINE);
+}
+
+
+// *******************************************************
+// initDeadline:        Starts the monitor timer and the watchdog
+void initDeadline (HeliContext *heli, void (*onDegrade)(HeliContext *heli))
+{
+    watched = heli;
+    degrade = onDegrade;
+    stats.level = DL_NORMAL;
+
+    monitorTimer = xTimerCreate("deadline", pdMS_TO_TICKS(DL_CHECK_MS), pdTRUE, 0, monitorExpire);
+    if (monitorTimer == NULL || xTimerStart(monitorTimer, 0) != pdPASS)
+    {
+        while(1);
+    }
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_WDOG0);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_WDOG0));
+    WatchdogReloadSet(WATCHDOG0_BASE, SysCtlClockGet() / 1000 * DL_WATCHDOG_MS);
+    WatchdogResetEnable(WATCHDOG0_BASE);
+    WatchdogStallEnable(WATCHDOG0_BASE);    // Hold while the debugger has the CPU halted
+    VECTOR_REGISTER(INT_WATCHDOG, WatchdogIntHandler);
+    WatchdogEnable(WATCHDOG0_BASE);
+}
+
+
+// *******************************************************
+// deadlineCycleStart:  Checks the period since the last cycle started. A
+//                      cycle after a stall leaves the descent to the
+//                      controller, still degraded.
+void deadlineCycleStart (void)
+{
+    TickType_t now = xTaskGetTickCount();
+    uint32_t period;
+
+    startCycles = PERF_CYCLES();
+    cycleMissed = false;
+
+    taskENTER_CRITICAL();
+    if (armed)
+    {
+        period = (now - lastStart) * portTICK_PERIOD_MS;
+        if (period > stats.worstPeriodMs)
+        {
+            stats.worstPeriodMs = period;
+        }
+        if (period > DL_PERIOD_MS + DL_PERIOD_SLACK_MS)
+        {
+            stats.periodMisses++;
+            cycleMissed = true;
+            blackBoxRecord(BB_DEADLINE, DL_EV_PERIOD, period, stats.level);
+        }
+    }
+    if (stats.level >= DL_STALLED)
+    {
+        stats.level = DL_DEGRADED;
+        blackBoxRecord(BB_DEADLINE, DL_EV_RECOVER, 0, DL_DEGRADED);
+    }
+    lastStart = now;
+    armed = true;
+    taskEXIT_CRITICAL();
+}
+
+
+// *******************************************************
+// deadlineCycleEnd:    Checks the execution time and escalates on too many
+//                      misses, or returns to normal after a clean window.
+//                      The counters, miss history and level change in one
+//                      critical section, so the monitor timer and
+//                      deadlineGetStats never see them part way through.
+void deadlineCycleEnd (void)
+{
+    uint32_t execCycles = PERF_CYCLES() - startCycles;
+    uint32_t execUs = PERF_US(execCycles);
+    uint32_t misses = 0, history, i;
+    bool degraded = false;
+
+    perfRecord(PERF_CONTROL, execCycles);
+
+    taskENTER_CRITICAL();
+    stats.cycles++;
+    stats.lastExecUs = execUs;
+    if (execUs > stats.worstExecUs)
+    {
+        stats.worstExecUs = execUs;
+    }
+    if (execUs > DL_EXEC_BUDGET_US)
+    {
+        stats.execMisses++;
+        cycleMissed = true;
+        blackBoxRecord(BB_DEADLINE, DL_EV_EXEC, execUs, stats.level);
+    }
+
+    missHistory = (missHistory << 1) | cycleMissed;
+    if (DL_MISS_WINDOW < 32)
+    {
+        missHistory &= (1UL << DL_MISS_WINDOW) - 1;
+    }
+    for (history = missHistory, i = 0; i < DL_MISS_WINDOW; i++, history >>= 1)
+    {
+        misses += history & 1;
+    }
+
+    if (stats.level == DL_NORMAL && misses >= DL_MISS_LIMIT)
+    {
+        stats.level = DL_DEGRADED;
+        degraded = true;
+    }
+    else if (stats.level == DL_DEGRADED && misses == 0)
+    {
+        stats.level = DL_NORMAL;
+        blackBoxRecord(BB_DEADLINE, DL_EV_NORMAL, 0, DL_NORMAL);
+    }
+    taskEXIT_CRITICAL();
+
+    if (degraded)
+    {
+        escalate(DL_EV_DEGRADE, misses);
+    }
+}
+
+
+// *******************************************************
+// deadlineStalled:     RETURNS true while the stalled descent owns the
+//                      outputs. Read it in the same critical section as the
+//                      commit it guards.
+bool deadlineStalled (void)
+{
+    return stats.level >= DL_STALLED;
+}
+
+
+// *******************************************************
+// deadlineGetStats:    Copies the counters
+void deadlineGetStats (deadlineStats_t *copy)
+{
+    taskENTER_CRITICAL();
+    *copy = stats;
+    taskEXIT_CRITICAL();
+}
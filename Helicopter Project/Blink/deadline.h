@@ -0,0 +1,98 @@
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+//*****************************************************************************
+//
+// deadline - Control cycle deadline monitor. Each cycle's period and
+//            execution time are checked against their budgets and misses
+//            are counted. Too many misses in a window degrade to a landing.
+//            A software timer, independent of the control task, catches a
+//            stalled control chain and ramps the rotors down itself. If the
+//            stall outlasts the descent the hardware watchdog is no longer
+//            fed and resets the board. Every escalation is recorded in the
+//            black box.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants, times in ms unless marked
+//*****************************************************************************
+#define DL_PERIOD_MS        150     // Control period, 5 ADC samples of 30 ms
+#define DL_PERIOD_SLACK_MS  20      // A longer period than DL_PERIOD_MS + this misses
+#define DL_EXEC_BUDGET_US   2000    // Execution time allowed per cycle
+#define DL_MISS_WINDOW      16      // Cycles the misses are counted over, up to 32
+#define DL_MISS_LIMIT       3       // Misses in the window before degrading
+#define DL_CHECK_MS         50      // Monitor timer period
+#define DL_STALL_MS         450     // No cycle for this long starts the descent
+#define DL_DESCENT_SLEW     100     // Main rotor ramp down, per-mille per second
+#define DL_RESET_MS         5000    // Still stalled after this long, stop feeding
+#define DL_WATCHDOG_MS      500     // Watchdog interrupt, then reset after as long again
+
+// Escalation levels
+typedef enum {DL_NORMAL = 0, DL_DEGRADED, DL_STALLED, DL_RESETTING} dlLevel_t;
+
+// Black box events, stored in the aux byte of BB_DEADLINE records
+enum dlEvents {DL_EV_PERIOD = 0, DL_EV_EXEC, DL_EV_DEGRADE, DL_EV_STALL,
+               DL_EV_RECOVER, DL_EV_NORMAL, DL_EV_WATCHDOG};
+
+// *******************************************************
+// Counters since power on
+typedef struct {
+    uint32_t cycles;
+    uint32_t periodMisses;
+    uint32_t execMisses;
+    uint32_t stalls;
+    uint32_t worstPeriodMs;
+    uint32_t worstExecUs;
+    uint32_t lastExecUs;
+    dlLevel_t level;
+} deadlineStats_t;
+
+
+struct heliContext;
+
+// *******************************************************
+// initDeadline:        Starts the monitor timer and the watchdog. Monitoring
+//                      begins with the first control cycle.
+// TAKES:               heli, the context whose control cycle is watched and
+//                      whose rotors a stalled descent ramps down
+//                      onDegrade, called with heli from the control task or
+//                      the timer task when the monitor degrades; it should
+//                      land
+void
+initDeadline (struct heliContext *heli, void (*onDegrade)(struct heliContext *heli));
+
+
+// *******************************************************
+// deadlineCycleStart:  Called by the control task as each cycle starts
+void
+deadlineCycleStart (void);
+
+
+// *******************************************************
+// deadlineCycleEnd:    Called by the control task as each cycle ends
+void
+deadlineCycleEnd (void);
+
+
+// *******************************************************
+// deadlineStalled:     RETURNS true while the stalled descent owns the
+//                      rotor outputs; the control task must not commit them
+bool
+deadlineStalled (void);
+
+
+// *******************************************************
+// WatchdogIntHandler:  First watchdog time out, see deadline.c
+void
+WatchdogIntHandler (void);
+
+
+// *******************************************************
+// deadlineGetStats:    Copies the counters
+void
+deadlineGetStats (deadlineStats_t *stats);
+
+#endif /* DEADLINE_H_ */
@@ -0,0 +1,74 @@
+//*****************************************************************************
+//
+// deferred - Work handed from interrupt handlers to the control task. An ISR
+//            captures a timestamp and whatever hardware state it needs,
+//            queues a function to run with it, and returns. The control task
+//            runs the queued work at the start of each cycle, so the state
+//            it changes is only ever written from one context.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "deferred.h"
+#include "perf.h"
+
+// *******************************************************
+// One queued work item
+typedef struct {
+    deferFn_t fn;
+    uint32_t arg;
+    uint32_t queued;                    // Cycle count on entry to the ISR
+} deferWork_t;
+
+static deferWork_t work[DEFER_QUEUE_LENGTH];
+static volatile uint8_t head = 0;       // Next free item, moved by ISRs only
+static volatile uint8_t tail = 0;       // Next item to run, moved by the task only
+static volatile uint32_t dropped = 0;
+
+
+// *******************************************************
+// deferFromISR:        Queues work from an interrupt handler. The item is
+//                      filled in before head moves past it, so the task
+//                      never sees a partial item.
+bool deferFromISR (uint8_t point, uint32_t entered, deferFn_t fn, uint32_t arg)
+{
+    uint8_t next = (head + 1) & (DEFER_QUEUE_LENGTH - 1);
+    bool queued = next != tail;
+
+    if (queued)
+    {
+        work[head].fn = fn;
+        work[head].arg = arg;
+        work[head].queued = entered;
+        head = next;
+    } else {
+        dropped++;
+    }
+    perfRecord(point, PERF_CYCLES() - entered);
+    return queued;
+}
+
+
+// *******************************************************
+// deferRun:            Runs all queued work, oldest first
+void deferRun (void)
+{
+    deferWork_t *item;
+
+    while (tail != head)
+    {
+        item = &work[tail];
+        perfRecord(PERF_DEFER_LATENCY, PERF_CYCLES() - item->queued);
+        item->fn(item->arg);
+        tail = (tail + 1) & (DEFER_QUEUE_LENGTH - 1);
+    }
+}
+
+
+// *******************************************************
+// deferDropped:        RETURNS the work items dropped on a full queue
+uint32_t deferDropped (void)
+{
+    return dropped;
+}
@@ -0,0 +1,57 @@
+#ifndef DEFERRED_H_
+#define DEFERRED_H_
+
+//*****************************************************************************
+//
+// deferred - Work handed from interrupt handlers to the control task. An ISR
+//            captures a timestamp and whatever hardware state it needs,
+//            queues a function to run with it, and returns. The control task
+//            runs the queued work at the start of each cycle, so the state
+//            it changes is only ever written from one context. The queue is
+//            lock-free: ISRs move only the head and the task only the tail.
+//            Every ISR that defers must run at DEFER_ISR_PRIORITY so that no
+//            two can interrupt each other mid-push.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOSConfig.h"
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define DEFER_QUEUE_LENGTH  8       // Work items, must be a power of 2
+#define DEFER_ISR_PRIORITY  configMAX_SYSCALL_INTERRUPT_PRIORITY // Highest that may call FreeRTOS
+
+// *******************************************************
+// Deferred work, run by the control task with the value its ISR captured
+typedef void (*deferFn_t)(uint32_t arg);
+
+
+// *******************************************************
+// deferFromISR:        Queues work from an interrupt handler and records the
+//                      handler's execution time. Call it last in the ISR.
+// TAKES:               point, the perfPoints entry timing this ISR
+//                      entered, PERF_CYCLES() on entry to the ISR
+//                      fn, the work to run
+//                      arg, the state captured by the ISR
+// RETURNS:             false if the queue was full and the work dropped
+bool
+deferFromISR (uint8_t point, uint32_t entered, deferFn_t fn, uint32_t arg);
+
+
+// *******************************************************
+// deferRun:            Runs all queued work, oldest first, recording the
+//                      time from each ISR to its work. Only the control
+//                      task may call this.
+void
+deferRun (void);
+
+
+// *******************************************************
+// deferDropped:        RETURNS the work items dropped on a full queue
+uint32_t
+deferDropped (void);
+
+#endif /* DEFERRED_H_ */
@@ -23,6 +23,7 @@
 #include "driverlib/debug.h"
 #include "utils/ustdlib.h"
 #include "stdlib.h"
+#include <string.h>
 
 #include "display.h"
 #include "OrbitOLED/OrbitOLEDInterface.h"
@@ -33,11 +34,25 @@
 #include "uart.h"
 #include "buttons4.h"
 #include "motor.h"
+#include "blackBox.h"
+#include "lowPower.h"
+#include "deadline.h"
+#include "perf.h"
+#include "ramfunc.h"
+#include "bootProfile.h"
+#include "deferred.h"
+#include "fastIO.h"
+#include "fixedPoint.h"
+#include "torqueFF.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
 
+#define BB_DRAIN_PER_UPDATE     16  //Black box records sent per display update
+#define LP_REPORT_UPDATES       10  //Display updates per sleep report
+#define TF_COMMAND              "TF"  //UART line asking for the torque table
+
 //  *****************************************************************************
 //  initDisplay:        Initialises Display using OrbitLED functions
 void initDisplay (void)
@@ -68,6 +83,19 @@ void printString(char* restrict line_format, int32_t line_contents, uint8_t line
 }
 
 
+//  *****************************************************************************
+//  printFixed:         Prints a fixed point value on the given line number on OLED Display
+//  TAKES:              line_format - The format to print the string in, including FIXED_FMT
+//                      line_contents - The fixed point value to print on the line
+//                      line_number - The line number integer to print the string on.
+void printFixed(char* restrict line_format, int32_t line_contents, uint8_t line_number)
+{
+    char string[MAX_STR_LEN + 1];
+    usnprintf (string, sizeof(string), line_format, FIXED_ARGS(line_contents));
+    OLEDStringDraw (string, 0, line_number); // Update line on display.
+}
+
+
 //*****************************************************************************
 //  initButtonCheck:    Initialises left and up buttons on the micro-controller
 void initButtonCheck (void) {
@@ -112,30 +140,90 @@ void initButtonCheck (void) {
 
 
 
+//  *****************************************************************************
+//  reportTorqueFF:     Sends the learnt torque feedforward table over UART,
+//                      one "TF <main> <tail>" line per entry in per-mille,
+//                      so values learnt in flight can be copied into the
+//                      defaults before the power is cut. The control task
+//                      learns into the table, so it is copied out whole.
+static void reportTorqueFF (char *statusStr)
+{
+    int32_t table[TORQUE_FF_POINTS];
+    uint32_t i;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < TORQUE_FF_POINTS; i++)
+    {
+        table[i] = getTorqueFFEntry(i);
+    }
+    taskEXIT_CRITICAL();
+
+    for (i = 0; i < TORQUE_FF_POINTS; i++)
+    {
+        usprintf (statusStr, "TF %d %d\r\n", i * TORQUE_FF_STEP, table[i]);
+        UARTSend (statusStr);
+    }
+}
+
 void vDisplayTask (void *pvParameters)
 {
     char statusStr[MAX_STR_LEN + 1];
+    static char uploadLine[UART_RX_MAX + 1];
     const TickType_t xDelay1s = pdMS_TO_TICKS(100);
     int32_t yawReading = 0;
     int32_t altReading = 0;
+    lowPowerStats_t sleepStats;
+    deadlineStats_t deadlineStats;
+    perfStat_t yawIsr, adcIsr, control, pwm, refIsr, deferLatency;
+    uint32_t updates = 0;
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+
+    // The OLED power up busy-waits about 100 ms on its delay timer, so run
+    // it below the ADC tasks rather than hold up the first samples
+    vTaskPrioritySet(NULL, tskIDLE_PRIORITY + 1);
+    initDisplay();
+    vTaskPrioritySet(NULL, priority);
+    bootMark(BOOT_DISPLAY);
 
     for ( ;; )
     {
-        yawReading = getYaw();
-        altReading = getAlt();
+        yawReading = getYawHundredths();
+        altReading = getAltHundredths();
 
-        printString("Altitude = %4d%%", altReading, 0);
-        printString("Yaw      = %4d", yawReading, 1);
+        printFixed("Alt  = " FIXED_FMT "%%", altReading, 0);
+        printFixed("Yaw  = " FIXED_FMT, yawReading, 1);
         printString("Main PWM = %4d%%", getMainPWM(), 2);
         printString("Tail PWM = %4d%%", getTailPWM(), 3);
 
+        // Manoeuvre uploads and torque table requests are answered before
+        // anything else, even while a black box snapshot drains
+        if (UARTGetLine(uploadLine, sizeof(uploadLine)))
+        {
+            if (strcmp(uploadLine, TF_COMMAND) == 0)
+            {
+                reportTorqueFF(statusStr);
+            } else {
+                UARTSend(uploadManoeuvre(uploadLine) ? "MV OK\r\n" : "MV ERR\r\n");
+            }
+        }
+
+        // A frozen black box snapshot takes the place of the status lines
+        // until it is drained
+        if (blackBoxFrozen())
+        {
+            blackBoxDrain(BB_DRAIN_PER_UPDATE);
+            vTaskDelay(xDelay1s);
+            continue;
+        }
+
 //        usprintf (statusStr, "\033[2J\033[H Alt = %2d | Yaw = %2d |\n\r"
 //                "AltRef = %2d | YawRef = %2d |", percentAlt, degrees, AltRef, YawRef);
 //        UARTSend (statusStr);
 //        usprintf (statusStr, "\033[2J\033[H Alt = %2d | Yaw = %2d |\n\r", percentAlt, degrees);
 //        UARTSend (statusStr);
 
-        usprintf (statusStr, "Alt = %2d | Yaw = %2d |", altReading, yawReading);
+        usprintf (statusStr, "Alt = " FIXED_FMT " | Yaw = " FIXED_FMT " |",
+                  FIXED_ARGS(altReading), FIXED_ARGS(yawReading));
         UARTSend (statusStr);
         usprintf (statusStr, "Main PWM = %2d | Tail PWM = %2d |\n\r", getMainPWM(), getTailPWM());
         UARTSend (statusStr);
@@ -143,6 +231,58 @@ void vDisplayTask (void *pvParameters)
         UARTSend (statusStr);
         usprintf (statusStr, "Mode: %s | 360 Yaw: %d\n\r", getMode(), getYawTotal());
         UARTSend (statusStr);
+        bootReport();
+
+        // Tickless idle savings, most telling while Landed, and deadline misses
+        if (++updates % LP_REPORT_UPDATES == 0)
+        {
+            lowPowerReport(&sleepStats);
+            usprintf (statusStr, "Idle = %d%% | Wakeups/s = %d |\n\r",
+                      sleepStats.idlePercent, sleepStats.wakeupsPerSec);
+            UARTSend (statusStr);
+            usprintf (statusStr, "Wake = %d us | Worst = %d us | Late = %d\n\r",
+                      sleepStats.wakeMaxUs, sleepStats.wakeWorstUs, sleepStats.overBudget);
+            UARTSend (statusStr);
+
+            deadlineGetStats(&deadlineStats);
+            usprintf (statusStr, "Ctrl = %d us | Worst = %d us %d ms |\n\r",
+                      deadlineStats.lastExecUs, deadlineStats.worstExecUs,
+                      deadlineStats.worstPeriodMs);
+            UARTSend (statusStr);
+            usprintf (statusStr, "Misses = %d/%d | Stalls = %d | Level = %d\n\r",
+                      deadlineStats.periodMisses, deadlineStats.execMisses,
+                      deadlineStats.stalls, deadlineStats.level);
+            UARTSend (statusStr);
+
+            // Mean and worst cycles, to compare RAMFUNC_ENABLE and FASTIO builds
+            perfTake(PERF_YAW_ISR, &yawIsr);
+            perfTake(PERF_ADC_ISR, &adcIsr);
+            perfTake(PERF_CONTROL, &control);
+            usprintf (statusStr, "ISR cyc: Yaw %d/%d ADC %d/%d\n\r",
+                      yawIsr.count ? yawIsr.total / yawIsr.count : 0, yawIsr.max,
+                      adcIsr.count ? adcIsr.total / adcIsr.count : 0, adcIsr.max);
+            UARTSend (statusStr);
+            usprintf (statusStr, "Ctrl cyc: %d/%d (%s, %s)\n\r",
+                      control.count ? control.total / control.count : 0, control.max,
+                      RAMFUNC_ENABLE ? "SRAM" : "flash", FASTIO ? "fast IO" : "driverlib");
+            UARTSend (statusStr);
+            perfTake(PERF_PWM, &pwm);
+            usprintf (statusStr, "PWM cyc: %d/%d\n\r",
+                      pwm.count ? pwm.total / pwm.count : 0, pwm.max);
+            UARTSend (statusStr);
+
+            // PC4 ISR cycles, then how long its work waited for the task
+            perfTake(PERF_REF_ISR, &refIsr);
+            perfTake(PERF_DEFER_LATENCY, &deferLatency);
+            usprintf (statusStr, "Ref ISR cyc: %d/%d Dropped %d\n\r",
+                      refIsr.count ? refIsr.total / refIsr.count : 0, refIsr.max,
+                      deferDropped());
+            UARTSend (statusStr);
+            usprintf (statusStr, "Deferred: %d us/%d us\n\r",
+                      PERF_US(deferLatency.count ? deferLatency.total / deferLatency.count : 0),
+                      PERF_US(deferLatency.max));
+            UARTSend (statusStr);
+        }
 
 //        usprintf (statusStr, "\n<script src='https://foo.nz/heliplus-lite.js'></script>");
 //        UARTSend (statusStr);
@@ -39,6 +39,15 @@ void
 printString(char* restrict line_format, int32_t line_contents, uint8_t line_number);
 
 
+//  *****************************************************************************
+//  printFixed:         Prints a fixed point value on the given line number on OLED Display
+//  TAKES:              line_format - The format to print the string in, including FIXED_FMT
+//                      line_contents - The fixed point value to print on the line
+//                      line_number - The line number integer to print the string on.
+void
+printFixed(char* restrict line_format, int32_t line_contents, uint8_t line_number);
+
+
 //*****************************************************************************
 //  initButtonCheck:    Initialises left and up buttons on the micro-controller
 void
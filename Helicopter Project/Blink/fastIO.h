@@ -0,0 +1,133 @@
+#ifndef FASTIO_H_
+#define FASTIO_H_
+
+//*****************************************************************************
+//
+// fastIO - Direct register versions of the few driverlib calls made in the
+//          ISRs and the control loop. Each driverlib call is a function call
+//          from flash that re-derives register addresses and, for the PWM,
+//          reads back the generator mode and load on every write; these are
+//          inline HWREG accesses with the addresses folded at compile time.
+//          Build with FASTIO=0 to use driverlib instead, for comparing
+//          cycle counts or when a driverlib change needs to be picked up.
+//
+//          To compare, fly a build with and one without --define=FASTIO=0
+//          for a minute each. Every second the display task sends the mean
+//          and worst DWT cycles of YawIntHandler and ADCIntHandler ("ISR
+//          cyc"), the control cycle ("Ctrl cyc", tagged with the build)
+//          and the PWM setter drivePWM ("PWM cyc").
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_types.h"
+#include "driverlib/adc.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pwm.h"
+
+#ifndef FASTIO
+#ifdef HOST_BUILD
+#define FASTIO              0       // The host models driverlib, not registers
+#else
+#define FASTIO              1
+#endif
+#endif
+
+#if FASTIO
+
+//*****************************************************************************
+// Register offsets and fields, as in TivaWare's hw_adc.h, hw_gpio.h and
+// hw_pwm.h
+//*****************************************************************************
+#define FAST_ADC_O_ISC          0x00C   // ADC interrupt status and clear
+#define FAST_ADC_O_SSFIFO0      0x048   // Sequence 0 FIFO
+#define FAST_ADC_O_SSFSTAT0     0x04C   // Sequence 0 FIFO status
+#define FAST_ADC_SEQ_STEP       0x020   // Between sequencer register blocks
+#define FAST_ADC_SSFSTAT_EMPTY  0x100
+#define FAST_ADC_FIFO_DEPTH     8
+
+#define FAST_GPIO_O_DATA        0x000   // Masked by address bits 9:2
+#define FAST_GPIO_O_ICR         0x41C   // Interrupt clear
+
+#define FAST_PWM_O_CTL          0x000   // Master control, GLOBALSYNC bits
+#define FAST_PWM_O_X_CMPA       0x018   // Generator comparators
+#define FAST_PWM_O_X_CMPB       0x01C
+
+// *******************************************************
+// fastADCSequenceDataGet: ADCSequenceDataGet
+static inline int32_t
+fastADCSequenceDataGet (uint32_t ui32Base, uint32_t ui32SequenceNum,
+                        uint32_t *pui32Buffer)
+{
+    uint32_t seq = ui32Base + ui32SequenceNum * FAST_ADC_SEQ_STEP;
+    int32_t count = 0;
+
+    while (!(HWREG(seq + FAST_ADC_O_SSFSTAT0) & FAST_ADC_SSFSTAT_EMPTY) &&
+           count < FAST_ADC_FIFO_DEPTH)
+    {
+        pui32Buffer[count++] = HWREG(seq + FAST_ADC_O_SSFIFO0);
+    }
+    return count;
+}
+
+// *******************************************************
+// fastADCIntClear:     ADCIntClear
+static inline void
+fastADCIntClear (uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    HWREG(ui32Base + FAST_ADC_O_ISC) = 1 << ui32SequenceNum;
+}
+
+// *******************************************************
+// fastGPIOIntClear:    GPIOIntClear
+static inline void
+fastGPIOIntClear (uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    HWREG(ui32Port + FAST_GPIO_O_ICR) = ui32IntFlags;
+}
+
+// *******************************************************
+// fastGPIOPinRead:     GPIOPinRead
+static inline int32_t
+fastGPIOPinRead (uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return HWREG(ui32Port + FAST_GPIO_O_DATA + (ui8Pins << 2));
+}
+
+// *******************************************************
+// fastPWMPulseWidthSet: PWMPulseWidthSet for a generator in up/down count
+//                      mode, taking its period rather than reading it back
+// TAKES:               ui32Base, ui32PWMOut, as PWMPulseWidthSet
+//                      ui32Period, as given to PWMGenPeriodSet
+//                      ui32Width, the pulse width in PWM clocks
+static inline void
+fastPWMPulseWidthSet (uint32_t ui32Base, uint32_t ui32PWMOut,
+                      uint32_t ui32Period, uint32_t ui32Width)
+{
+    uint32_t gen = ui32Base + (ui32PWMOut & 0xFFFFFFC0);
+
+    HWREG(gen + ((ui32PWMOut & 1) ? FAST_PWM_O_X_CMPB : FAST_PWM_O_X_CMPA)) =
+        ui32Period / 2 - ui32Width / 2;
+}
+
+// *******************************************************
+// fastPWMSyncUpdate:   PWMSyncUpdate
+static inline void
+fastPWMSyncUpdate (uint32_t ui32Base, uint32_t ui32GenBits)
+{
+    HWREG(ui32Base + FAST_PWM_O_CTL) |= ui32GenBits;
+}
+
+#else
+
+#define fastADCSequenceDataGet(base, seq, buffer)   ADCSequenceDataGet(base, seq, buffer)
+#define fastADCIntClear(base, seq)                  ADCIntClear(base, seq)
+#define fastGPIOIntClear(port, flags)               GPIOIntClear(port, flags)
+#define fastGPIOPinRead(port, pins)                 GPIOPinRead(port, pins)
+#define fastPWMPulseWidthSet(base, out, period, width) PWMPulseWidthSet(base, out, width)
+#define fastPWMSyncUpdate(base, bits)               PWMSyncUpdate(base, bits)
+
+#endif
+
+#endif /* FASTIO_H_ */
@@ -0,0 +1,49 @@
+#ifndef FIXEDPOINT_H_
+#define FIXEDPOINT_H_
+
+//*****************************************************************************
+//
+// fixedPoint - Fixed point units shared by the altitude, yaw, control and
+//              display code. Altitude is held in hundredths of a percent and
+//              yaw in hundredths of a degree. Sensor counts are converted with
+//              a reciprocal multiply and shift instead of a division.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define FIXED_SCALE         100     // Fixed point units per percent or degree
+#define FIXED_RECIP_SHIFT   16      // Fraction bits of the reciprocals
+
+// *******************************************************
+// FIXED_RECIP:         Reciprocal of den scaled by num, rounded, for use with
+//                      FIXED_MUL. Both arguments must be compile time constants.
+#define FIXED_RECIP(num, den) \
+    ((int32_t)((((int64_t)(num) << FIXED_RECIP_SHIFT) + (den) / 2) / (den)))
+
+// *******************************************************
+// FIXED_MUL:           x * recip rounded to the nearest unit. The product is
+//                      64 bit (a single SMULL on the Cortex-M4).
+#define FIXED_MUL(x, recip) \
+    ((int32_t)(((int64_t)(x) * (recip) + (1 << (FIXED_RECIP_SHIFT - 1))) \
+               >> FIXED_RECIP_SHIFT))
+
+// *******************************************************
+// FIXED_WHOLE:         Whole percent or degrees, truncated towards zero
+#define FIXED_WHOLE(x)      ((x) / FIXED_SCALE)
+
+// *******************************************************
+// FIXED_TO_DOUBLE:     Fixed point value as a double, for the PID loops
+#define FIXED_TO_DOUBLE(x)  ((x) * (1.0 / FIXED_SCALE))
+
+// *******************************************************
+// FIXED_FMT / FIXED_ARGS: usprintf format and arguments printing a fixed
+//                      point value as e.g. "-0.25" or "12.50"
+#define FIXED_FMT           "%s%d.%02d"
+#define FIXED_ARGS(x)       (((x) < 0 && (x) > -FIXED_SCALE) ? "-" : ""), \
+                            FIXED_WHOLE(x), (abs(x) % FIXED_SCALE)
+
+#endif /* FIXEDPOINT_H_ */
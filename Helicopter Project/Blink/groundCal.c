@@ -0,0 +1,155 @@
+//*****************************************************************************
+//
+// groundCal - Ground altitude calibration. Raw ADC samples are accumulated
+//             with a running mean and variance (Welford) until the confidence
+//             interval on the mean is tight enough, rejecting samples that are
+//             far from the running mean. Once calibrated the reference can be
+//             slowly re-zeroed while landed to follow sensor drift.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "groundCal.h"
+
+
+// *******************************************************
+// groundCalInit:       Starts accumulating, with tracking enabled since the
+//                      helicopter starts landed
+void groundCalInit (groundCal_t *cal)
+{
+    groundCalStart(cal);
+    cal->tracking = true;
+    cal->refQ8 = 0;
+}
+
+
+// *******************************************************
+// groundCalStart:      Discards any calibration and starts accumulating again
+void groundCalStart (groundCal_t *cal)
+{
+    cal->count = 0;
+    cal->rejects = 0;
+    cal->mean = 0.0f;
+    cal->m2 = 0.0f;
+    cal->calibrated = false;
+}
+
+
+// *******************************************************
+// groundCalSample:     Adds one ADC sample to the calibration. Does
+//                      nothing once calibrated.
+// TAKES:               sample, an ADC sample
+// RETURNS:             true when this sample completed the calibration
+bool groundCalSample (groundCal_t *cal, uint32_t sample)
+{
+    float delta;
+    float var;
+
+    if (cal->calibrated)
+    {
+        return false;
+    }
+
+    delta = (float)sample - cal->mean;
+
+    // Once the spread is known, reject samples well outside it. A run of
+    // rejects means the level really moved, so start again from there.
+    if (cal->count >= CAL_MIN_SAMPLES)
+    {
+        var = cal->m2 / (float)(cal->count - 1);
+        if (var < CAL_VAR_FLOOR)
+        {
+            var = CAL_VAR_FLOOR;
+        }
+        if (delta * delta > CAL_OUTLIER_K2 * var)
+        {
+            if (++cal->rejects >= CAL_MAX_REJECTS)
+            {
+                groundCalStart(cal);
+            }
+            return false;
+        }
+    }
+    cal->rejects = 0;
+
+    // Welford update
+    cal->count++;
+    cal->mean += delta / (float)cal->count;
+    cal->m2 += delta * ((float)sample - cal->mean);
+
+    // Half width of the interval is z * sd / sqrt(n); compare squares
+    if (cal->count >= CAL_MIN_SAMPLES)
+    {
+        var = cal->m2 / (float)(cal->count - 1);
+        if (CAL_Z2 * var <= CAL_CI_COUNTS * CAL_CI_COUNTS * (float)cal->count ||
+            cal->count >= CAL_MAX_SAMPLES)
+        {
+            cal->refQ8 = (int32_t)(cal->mean * 256.0f + 0.5f);
+            cal->calibrated = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// *******************************************************
+// groundCalDone:       RETURNS true once the ground reference is calibrated
+bool groundCalDone (const groundCal_t *cal)
+{
+    return cal->calibrated;
+}
+
+
+// *******************************************************
+// groundCalSetTracking: Enables or disables slow re-zeroing of the reference
+// TAKES:               enable, true while the helicopter is landed
+void groundCalSetTracking (groundCal_t *cal, bool enable)
+{
+    cal->tracking = enable;
+}
+
+
+// *******************************************************
+// groundCalTrack:      Moves the reference slowly towards a new ground mean.
+//                      Ignored unless calibrated, tracking is enabled and the
+//                      mean is within GROUND_TRACK_WINDOW of the reference.
+// TAKES:               groundMean, a filtered ADC mean
+void groundCalTrack (groundCal_t *cal, int32_t groundMean)
+{
+    int32_t diffQ8 = (groundMean << 8) - cal->refQ8;
+
+    if (!cal->calibrated || !cal->tracking)
+    {
+        return;
+    }
+    if (diffQ8 > (GROUND_TRACK_WINDOW << 8) || diffQ8 < -(GROUND_TRACK_WINDOW << 8))
+    {
+        return;
+    }
+    cal->refQ8 += diffQ8 >> GROUND_TRACK_SHIFT;
+}
+
+
+// *******************************************************
+// groundCalSet:        Moves a calibrated reference directly. Ignored until
+//                      calibrated, as there is no ground mean to set it
+//                      from before then.
+// TAKES:               reference, the ground ADC value
+void groundCalSet (groundCal_t *cal, int32_t reference)
+{
+    if (!cal->calibrated)
+    {
+        return;
+    }
+    cal->refQ8 = reference << 8;
+}
+
+
+// *******************************************************
+// groundCalReference:  RETURNS the ground reference in ADC counts
+int32_t groundCalReference (const groundCal_t *cal)
+{
+    return (cal->refQ8 + 128) >> 8;
+}
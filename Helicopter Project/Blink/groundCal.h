@@ -0,0 +1,103 @@
+#ifndef GROUNDCAL_H_
+#define GROUNDCAL_H_
+
+//*****************************************************************************
+//
+// groundCal - Ground altitude calibration. Raw ADC samples are accumulated
+//             with a running mean and variance (Welford) until the confidence
+//             interval on the mean is tight enough, rejecting samples that are
+//             far from the running mean. Once calibrated the reference can be
+//             slowly re-zeroed while landed to follow sensor drift.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "altitude.h"
+
+//*****************************************************************************
+// Constants. Counts are ADC sample counts, ADC_SAMPLE_SCALE per 12 bit count.
+//*****************************************************************************
+#define CAL_MIN_SAMPLES     8       // Samples before the interval is trusted
+#define CAL_MAX_SAMPLES     64      // Take the mean regardless after this many
+#define CAL_CI_COUNTS       (1.0f * ADC_SAMPLE_SCALE)   // Target 95% half width of the mean
+#define CAL_Z2              4.0f    // z^2 for a 95% interval
+#define CAL_OUTLIER_K2      9.0f    // Reject samples beyond 3 sigma
+#define CAL_VAR_FLOOR       1.0f    // Minimum variance (sample quantisation)
+#define CAL_MAX_REJECTS     8       // Consecutive rejects before restarting
+
+#define GROUND_TRACK_WINDOW (25 * ADC_SAMPLE_SCALE)    // Only re-zero within 2% of the reference
+#define GROUND_TRACK_SHIFT  6       // Re-zero filter gain of 1/64 per mean
+
+// *******************************************************
+// One helicopter's ground calibration
+typedef struct {
+    uint32_t count;         // Accepted samples
+    uint32_t rejects;       // Consecutive rejected samples
+    float mean;             // Running mean (ADC counts)
+    float m2;               // Sum of squared differences from the mean
+    bool calibrated;
+    bool tracking;          // Re-zeroing allowed, while landed
+    int32_t refQ8;          // Ground reference, 1/256 sample counts
+} groundCal_t;
+
+
+// *******************************************************
+// groundCalInit:       Starts accumulating, with tracking enabled since the
+//                      helicopter starts landed
+void
+groundCalInit (groundCal_t *cal);
+
+
+// *******************************************************
+// groundCalStart:      Discards any calibration and starts accumulating again
+void
+groundCalStart (groundCal_t *cal);
+
+
+// *******************************************************
+// groundCalSample:     Adds one ADC sample to the calibration. Does
+//                      nothing once calibrated.
+// TAKES:               sample, an ADC sample
+// RETURNS:             true when this sample completed the calibration
+bool
+groundCalSample (groundCal_t *cal, uint32_t sample);
+
+
+// *******************************************************
+// groundCalDone:       RETURNS true once the ground reference is calibrated
+bool
+groundCalDone (const groundCal_t *cal);
+
+
+// *******************************************************
+// groundCalSetTracking: Enables or disables slow re-zeroing of the reference
+// TAKES:               enable, true while the helicopter is landed
+void
+groundCalSetTracking (groundCal_t *cal, bool enable);
+
+
+// *******************************************************
+// groundCalTrack:      Moves the reference slowly towards a new ground mean.
+//                      Ignored unless calibrated, tracking is enabled and the
+//                      mean is within GROUND_TRACK_WINDOW of the reference.
+// TAKES:               groundMean, a filtered ADC mean
+void
+groundCalTrack (groundCal_t *cal, int32_t groundMean);
+
+
+// *******************************************************
+// groundCalSet:        Moves a calibrated reference directly. Ignored until
+//                      calibrated, as there is no ground mean to set it
+//                      from before then.
+// TAKES:               reference, the ground ADC value
+void
+groundCalSet (groundCal_t *cal, int32_t reference);
+
+
+// *******************************************************
+// groundCalReference:  RETURNS the ground reference in ADC counts
+int32_t
+groundCalReference (const groundCal_t *cal);
+
+#endif /* GROUNDCAL_H_ */
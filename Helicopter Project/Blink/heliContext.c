@@ -0,0 +1,36 @@
+//*****************************************************************************
+//
+// heliContext - The helicopter behind the firmware's global API, and the
+//               set up of any other context. See heliContext.h.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "heliContext.h"
+
+// Set up piece by piece by initADC, initYaw, initmotor, initMotorOutput,
+// initTorqueFF and initSwitch_PC4
+HeliContext g_heli;
+
+
+// *******************************************************
+// heliInit:            Puts a context in its power on state: landed, with
+//                      the switch paralysed until it is seen down, the
+//                      ground uncalibrated and the rotors at rest
+void heliInit (HeliContext *heli, const heliHooks_t *hooks, void *user)
+{
+    memset(heli, 0, sizeof(*heli));
+    if (hooks != NULL)
+    {
+        heli->hooks = *hooks;
+    }
+    heli->user = user;
+
+    heliInitAltitude(heli);
+    heliInitYaw(heli);
+    heliInitMotorOutput(heli);
+    torqueFFReset(&heli->torque);
+    heliInitControl(heli);
+}
@@ -0,0 +1,316 @@
+#ifndef HELICONTEXT_H_
+#define HELICONTEXT_H_
+
+//*****************************************************************************
+//
+// heliContext - Everything one helicopter's flight logic remembers: the
+//               altitude and yaw measurements, the rotor duties, the
+//               controllers and the mode machine. Each flight logic function
+//               has a form here taking the context, so one process can fly
+//               any number of helicopters side by side, each on its own
+//               thread if need be (host/twin.c flies them both ways).
+//
+//               A context reaches nothing outside itself except through its
+//               hooks, so it needs no hardware, RTOS objects or other globals,
+//               and the caller gives it the time. Even its locking and the
+//               hold on its outputs are hooks: a context only one thread
+//               touches needs neither. The firmware's global API (getAlt,
+//               updateControl, YawIntHandler, ...) runs on g_heli, whose
+//               hooks the init functions point at the PWM hardware, buttons,
+//               switch timer, black box, RTOS critical sections and deadline
+//               monitor. Those hooks are g_heli's alone; another context
+//               gives its own or none.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "altitude.h"
+#include "groundCal.h"
+#include "yaw.h"
+#include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
+#include "control.h"
+
+typedef struct heliContext HeliContext;
+
+// *******************************************************
+// What a context needs from outside, any of which may be NULL
+typedef struct {
+    // Drives both rotors, in per-mille, once the context has its new duties
+    void (*pwm)(HeliContext *heli, uint32_t mainPermille, uint32_t tailPermille);
+
+    // As checkButton: PUSHED, RELEASED or NO_CHANGE since the last call
+    uint8_t (*button)(HeliContext *heli, uint8_t button);
+
+    // Starts the MODE_CHANGE_TIME switch timer. When it expires the owner
+    // calls heliSwitchTimerExpired.
+    void (*switchTimer)(HeliContext *heli, TickType_t now);
+
+    // As blackBoxRecord and blackBoxTrigger
+    void (*record)(HeliContext *heli, uint8_t type, uint8_t aux,
+                   int32_t value0, int32_t value1);
+    void (*trigger)(HeliContext *heli, uint8_t reason);
+
+    // Guard the context's shared state against the owner's other tasks and
+    // interrupts, which may also step it. Not nested.
+    void (*lock)(HeliContext *heli);
+    void (*unlock)(HeliContext *heli);
+
+    // RETURNS true while the owner has taken over the rotors, e.g. for a
+    // stalled descent, and the control cycle must not commit them. Called
+    // with the context locked.
+    bool (*outputsHeld)(HeliContext *heli);
+} heliHooks_t;
+
+struct heliContext {
+    altitude_t alt;
+    groundCal_t ground;
+    yaw_t yaw;
+    motorDuty_t motor;
+    motorOutput_t output;
+    torqueFF_t torque;
+    control_t ctl;
+    heliHooks_t hooks;
+    void *user;             // For the owner, e.g. its model of the rig
+};
+
+// The helicopter behind the firmware's global API
+extern HeliContext g_heli;
+
+
+//*****************************************************************************
+// Setting up
+//*****************************************************************************
+
+// *******************************************************
+// heliInit:            Puts a context in its power on state: landed, with
+//                      the switch paralysed until it is seen down, the
+//                      ground uncalibrated and the rotors at rest
+// TAKES:               hooks, copied, or NULL for none
+//                      user, kept for the owner
+void
+heliInit (HeliContext *heli, const heliHooks_t *hooks, void *user);
+
+// *******************************************************
+// heliInitAltitude, heliInitYaw, heliInitMotorOutput, heliInitControl:
+//                      The parts of heliInit, also run on g_heli by initADC,
+//                      initYaw, initMotorOutput and initSwitch_PC4
+void
+heliInitAltitude (HeliContext *heli);
+
+void
+heliInitYaw (HeliContext *heli);
+
+void
+heliInitMotorOutput (HeliContext *heli);
+
+void
+heliInitControl (HeliContext *heli);
+
+
+//*****************************************************************************
+// Altitude, see altitude.h
+//*****************************************************************************
+
+// *******************************************************
+// heliUpdateAltitude:  Adds a new ADC sample, as updateAltitude
+// RETURNS:             true when a new altitude is ready for the controller
+bool
+heliUpdateAltitude (HeliContext *heli, uint32_t sample);
+
+int32_t
+heliGetAlt (const HeliContext *heli);
+
+int32_t
+heliGetAltHundredths (const HeliContext *heli);
+
+void
+heliResetAltitude (HeliContext *heli);
+
+bool
+heliAltitudeCalibrated (const HeliContext *heli);
+
+int32_t
+heliPercentAltitude (const HeliContext *heli);
+
+
+//*****************************************************************************
+// Yaw, see yaw.h
+//*****************************************************************************
+
+// *******************************************************
+// heliYawEdge:         Decodes an encoder edge, as YawIntHandler
+// TAKES:               pins, the new levels of phase A (bit 0) and B (bit 1)
+void
+heliYawEdge (HeliContext *heli, uint32_t pins);
+
+int32_t
+heliGetYawHundredths (const HeliContext *heli);
+
+int32_t
+heliGetYawTotalHundredths (const HeliContext *heli);
+
+int32_t
+heliGetYaw (const HeliContext *heli);
+
+int32_t
+heliGetYawTotal (const HeliContext *heli);
+
+void
+heliResetYaw (HeliContext *heli);
+
+void
+heliResetYawAt (HeliContext *heli, int32_t captured);
+
+int32_t
+heliYawSlot (const HeliContext *heli);
+
+
+//*****************************************************************************
+// Rotors, see motor.h and motorOutput.h
+//*****************************************************************************
+
+// *******************************************************
+// heliSetBothPWMPermille: Commits both duties, as SetBothPWMPermille, then
+//                      drives them through the pwm hook
+void
+heliSetBothPWMPermille (HeliContext *heli, uint32_t mainPermille,
+                        uint32_t tailPermille);
+
+uint32_t
+heliGetMainPWM (const HeliContext *heli);
+
+uint32_t
+heliGetTailPWM (const HeliContext *heli);
+
+uint32_t
+heliGetMainPWMPermille (const HeliContext *heli);
+
+uint32_t
+heliGetTailPWMPermille (const HeliContext *heli);
+
+void
+heliMotorOutputSetMain (HeliContext *heli, int32_t permille);
+
+void
+heliMotorOutputSetTail (HeliContext *heli, int32_t permille);
+
+void
+heliMotorOutputSoftStart (HeliContext *heli, int32_t mainPermille,
+                          int32_t tailPermille);
+
+void
+heliMotorOutputApply (HeliContext *heli, uint32_t elapsedMs);
+
+int32_t
+heliMotorOutputGetMain (const HeliContext *heli);
+
+int32_t
+heliMotorOutputGetTail (const HeliContext *heli);
+
+void
+heliMotorOutputStop (HeliContext *heli);
+
+
+//*****************************************************************************
+// Control and modes, see control.h
+//*****************************************************************************
+
+// *******************************************************
+// heliUpdateControl:   Runs one control cycle, as updateControl
+// TAKES:               now, the time, which sets the cycle's period
+void
+heliUpdateControl (HeliContext *heli, TickType_t now);
+
+// *******************************************************
+// heliSetSwitch:       Sets the debounced state of SW1
+void
+heliSetSwitch (HeliContext *heli, bool on);
+
+// *******************************************************
+// heliRefFound:        The yaw reference was passed. While initialising,
+//                      zeroes the yaw at the captured slot and tells the
+//                      mode machine.
+// TAKES:               capturedSlot, heliYawSlot at the reference
+//                      now, the time
+void
+heliRefFound (HeliContext *heli, int32_t capturedSlot, TickType_t now);
+
+// *******************************************************
+// heliSwitchTimerExpired: The switch timer started by the switchTimer hook
+//                      has run out
+void
+heliSwitchTimerExpired (HeliContext *heli, TickType_t now);
+
+// *******************************************************
+// heliDeadlineMissed:  The control cycle is running late; land
+void
+heliDeadlineMissed (HeliContext *heli, TickType_t now);
+
+void
+heliGetSwitchState (HeliContext *heli);
+
+void
+heliCheckStability (HeliContext *heli);
+
+void
+heliSetAltRef (HeliContext *heli, int32_t newAltRef);
+
+void
+heliSetYawRef (HeliContext *heli, int32_t newYawRef);
+
+int32_t
+heliGetAltRef (const HeliContext *heli);
+
+int32_t
+heliGetYawRef (const HeliContext *heli);
+
+void
+heliTakeOff (HeliContext *heli);
+
+void
+heliSpecialButtonMode (HeliContext *heli);
+
+void
+heliUpdateManoeuvre (HeliContext *heli);
+
+bool
+heliUploadManoeuvre (HeliContext *heli, const char *line);
+
+void
+heliLanding (HeliContext *heli);
+
+void
+heliPIDControlYaw (HeliContext *heli);
+
+void
+heliPIDControlAlt (HeliContext *heli);
+
+uint32_t
+heliGetMainDuty (const HeliContext *heli);
+
+uint32_t
+heliGetTailDuty (const HeliContext *heli);
+
+char*
+heliGetMode (const HeliContext *heli);
+
+void
+heliResetIntControl (HeliContext *heli);
+
+void
+heliRefUpdate (HeliContext *heli);
+
+void
+heliStates (HeliContext *heli);
+
+const smLogEntry_t *
+heliGetModeTransition (const HeliContext *heli, uint32_t n);
+
+uint32_t
+heliGetModeTransitionCount (const HeliContext *heli);
+
+#endif /* HELICONTEXT_H_ */
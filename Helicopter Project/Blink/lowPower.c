@@ -0,0 +1,137 @@
+//*****************************************************************************
+//
+// lowPower - Tickless idle accounting. When every task is blocked the kernel
+//            stops the 1 kHz tick and sleeps until the next task is due
+//            (configUSE_TICKLESS_IDLE). These hooks count the ticks the
+//            kernel steps over each sleep, so the idle fraction and wakeups
+//            per second can be reported, and measure the latency from a wake
+//            to the first task of the control chain running with the DWT
+//            cycle counter. The core clock is gated during the WFI, so the
+//            cycle counter cannot time the sleep itself.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lowPower.h"
+#include "perf.h"
+
+#define CYCLES_PER_TICK     (configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+
+static uint32_t sleepExpected;          // Ticks the last sleep was set up for
+static uint32_t wakeCycles;             // Cycle count of the last wake
+static bool wakePending = false;        // Not yet matched by lowPowerWakeCheck
+
+static TickType_t windowStart;
+static uint32_t sleptTicks;
+static uint32_t sleeps;
+static uint32_t wakeMax;
+static uint32_t wakeWorst;
+static uint32_t overBudget;
+
+
+// *******************************************************
+// initLowPower:        Starts the first report window. initPerf must
+//                      already have run.
+void initLowPower (void)
+{
+    windowStart = xTaskGetTickCount();
+}
+
+
+// *******************************************************
+// lowPowerPreSleep:    Leaves expectedIdle alone so the port still does the
+//                      WFI itself
+void lowPowerPreSleep (uint32_t *expectedIdle)
+{
+    (void)expectedIdle;
+}
+
+
+// *******************************************************
+// lowPowerPostSleep:   Marks the wake for lowPowerWakeCheck
+void lowPowerPostSleep (uint32_t expectedIdle)
+{
+    wakeCycles = PERF_CYCLES();
+    sleepExpected = expectedIdle;
+    sleeps++;
+    wakePending = true;
+}
+
+
+// *******************************************************
+// lowPowerTicksStepped: A sleep that ran its full length leaves the tick
+//                      that ended it pending, so the port steps one tick
+//                      short. An early wake is rounded down to whole ticks.
+void lowPowerTicksStepped (uint32_t ticks)
+{
+    if (ticks + 1 == sleepExpected)
+    {
+        ticks++;
+    }
+    sleptTicks += ticks;
+}
+
+
+// *******************************************************
+// lowPowerWakeCheck:   A wake more than a tick ago ended a sleep cut short
+//                      by some other interrupt, not the one that released
+//                      the caller, so it is not counted.
+void lowPowerWakeCheck (void)
+{
+    uint32_t latency;
+
+    taskENTER_CRITICAL();
+    latency = PERF_CYCLES() - wakeCycles;
+    if (wakePending && latency < CYCLES_PER_TICK)
+    {
+        latency /= PERF_CYCLES_PER_US;
+        if (latency > wakeMax)
+        {
+            wakeMax = latency;
+        }
+        if (latency > wakeWorst)
+        {
+            wakeWorst = latency;
+        }
+        if (latency > LP_WAKE_BUDGET_US)
+        {
+            overBudget++;
+        }
+    }
+    wakePending = false;
+    taskEXIT_CRITICAL();
+}
+
+
+// *******************************************************
+// lowPowerReport:      Fills stats and starts a new window
+void lowPowerReport (lowPowerStats_t *stats)
+{
+    TickType_t now;
+    uint32_t window, slept, count;
+
+    taskENTER_CRITICAL();
+    now = xTaskGetTickCount();
+    slept = sleptTicks;
+    count = sleeps;
+    stats->wakeMaxUs = wakeMax;
+    stats->wakeWorstUs = wakeWorst;
+    stats->overBudget = overBudget;
+    sleptTicks = 0;
+    sleeps = 0;
+    wakeMax = 0;
+    taskEXIT_CRITICAL();
+
+    window = now - windowStart;
+    windowStart = now;
+    if (window == 0)
+    {
+        window = 1;
+    }
+    stats->idlePercent = slept * 100 / window;
+    stats->wakeupsPerSec = count * configTICK_RATE_HZ / window;
+}
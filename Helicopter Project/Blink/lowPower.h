@@ -0,0 +1,78 @@
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+//*****************************************************************************
+//
+// lowPower - Tickless idle accounting. When every task is blocked the kernel
+//            stops the 1 kHz tick and sleeps until the next task is due
+//            (configUSE_TICKLESS_IDLE). These hooks count the ticks the
+//            kernel steps over each sleep, so the idle fraction and wakeups
+//            per second can be reported, and measure the latency from a wake
+//            to the first task of the control chain running with the DWT
+//            cycle counter. The core clock is gated during the WFI, so the
+//            cycle counter cannot time the sleep itself.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define LP_WAKE_BUDGET_US   20      // Wake latency the control chain can absorb
+
+// *******************************************************
+// Sleep statistics. The first three cover the window since the last report,
+// the rest are since power on.
+typedef struct {
+    uint32_t idlePercent;           // Time spent asleep
+    uint32_t wakeupsPerSec;         // 1000 with a fixed tick
+    uint32_t wakeMaxUs;             // Worst wake latency
+    uint32_t wakeWorstUs;
+    uint32_t overBudget;            // Wakes slower than LP_WAKE_BUDGET_US
+} lowPowerStats_t;
+
+
+// *******************************************************
+// initLowPower:        Starts the first report window. initPerf must
+//                      already have run.
+void
+initLowPower (void);
+
+
+// *******************************************************
+// lowPowerPreSleep:    configPRE_SLEEP_PROCESSING hook, called with
+//                      interrupts disabled just before the WFI
+// TAKES:               expectedIdle, ticks the kernel will sleep for
+void
+lowPowerPreSleep (uint32_t *expectedIdle);
+
+
+// *******************************************************
+// lowPowerPostSleep:   configPOST_SLEEP_PROCESSING hook, called with
+//                      interrupts still disabled as soon as the CPU wakes
+void
+lowPowerPostSleep (uint32_t expectedIdle);
+
+
+// *******************************************************
+// lowPowerTicksStepped: traceINCREASE_TICK_COUNT hook, called with the ticks
+//                      vTaskStepTick adds after a sleep
+void
+lowPowerTicksStepped (uint32_t ticks);
+
+
+// *******************************************************
+// lowPowerWakeCheck:   Called by the first task of the control chain when
+//                      it unblocks. Records the time since the CPU woke if
+//                      that wake is what released it.
+void
+lowPowerWakeCheck (void);
+
+
+// *******************************************************
+// lowPowerReport:      Fills stats and starts a new window
+void
+lowPowerReport (lowPowerStats_t *stats);
+
+#endif /* LOWPOWER_H_ */
@@ -26,9 +26,15 @@
 #include "uart.h"
 #include "yaw.h"
 #include "buttons4.h"
+#include "lowPower.h"
+#include "perf.h"
 #include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
 #include "control.h"
 #include "display.h"
+#include "blackBox.h"
+#include "bootProfile.h"
 
 #define BUF_SIZE            10
 #define TASK_STACK_DEPTH    128
@@ -64,15 +70,29 @@ int main(void)
 //    { // (void *)1 is our pvParameters for our task func specifying PF_1
 //        while (1); // error creating task, out of memory?
 //    }
+    // Every clock is enabled up front, so no init below waits for one. The
+    // OLED is initialised by the display task after the scheduler starts.
+    initPerf();
+    initBlackBox();
+    initLowPower();
+    bootEnablePeripherals();
     initButtonCheck();
+    bootMark(BOOT_CLOCKS);
     initADC();
+    bootMark(BOOT_ADC);
     initYaw();
+    bootMark(BOOT_YAW);
     initmotor();
-    initDisplay();
+    initMotorOutput();
+    initTorqueFF();
+    bootMark(BOOT_MOTOR);
     initialiseUSB_UART();
     resetAltitude();
+    bootMark(BOOT_UART);
     initButtons();
+    bootMark(BOOT_BUTTONS);
     initSwitch_PC4();
+    bootMark(BOOT_SWITCH);
     IntMasterEnable();
 
     // Create ADC Task
@@ -83,12 +103,6 @@ int main(void)
     }
 
 
-    if (pdTRUE != xTaskCreate(vButtonTask, "Buttons", TASK_STACK_DEPTH, NULL, 3,
-                           NULL))
-    { // (void *)1 is our pvParameters for our task func specifying PF_1
-        while (1); // error creating task, out of memory?
-    }
-
     if (pdTRUE != xTaskCreate(vControlTask, "Control", TASK_STACK_DEPTH, NULL, 4,
                                &xPIDTask))
     { // (void *)1 is our pvParameters for our task func specifying PF_1
@@ -106,6 +120,7 @@ int main(void)
     { // (void *)1 is our pvParameters for our task func specifying PF_1
         while (1); // error creating task, out of memory?
     }
+    bootMark(BOOT_TASKS);
     vTaskStartScheduler();      // Start FreeRTOS!!
 
     while(1);                   // Should never get here since the RTOS should never "exit".
@@ -0,0 +1,331 @@
+//*****************************************************************************
+//
+// manoeuvre - Interpreter for scripted manoeuvres flown in Special mode. A
+//             manoeuvre is a short bytecode program that moves the altitude
+//             and yaw references through waypoints and waits for the
+//             helicopter to settle on each one, within tolerances, for a
+//             dwell time and before a timeout. The built in programs are
+//             const (see manoeuvrePrograms.c); replacements can be uploaded
+//             over UART into RAM. The interpreter has no hardware access so
+//             the host simulator runs exactly the same code.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "manoeuvre.h"
+#include "fixedPoint.h"
+
+#define MV_DEFAULT_TOL      (5 * FIXED_SCALE)   // Tolerance until MV_TOL is used
+
+
+// *******************************************************
+// manoeuvreValidate:   Checks a program before it is run: known opcodes,
+//                      values in range, balanced loops each containing a
+//                      WAIT or DELAY, and an MV_END within MV_MAX_LENGTH.
+// RETURNS:             The program length including MV_END, or -1 - the
+//                      index of the first bad instruction
+int32_t manoeuvreValidate (const mvInstr_t *program)
+{
+    bool waits[MV_LOOP_DEPTH + 1] = {false};    // Loop body so far waits
+    uint8_t depth = 0;
+    int32_t i;
+    bool ok;
+
+    for (i = 0; i < MV_MAX_LENGTH; i++)
+    {
+        int16_t value = program[i].value;
+
+        switch (program[i].op)
+        {
+        case MV_END:
+            return (depth == 0) ? i + 1 : -1 - i;
+        case MV_ALT:
+            ok = (value >= MV_ALT_MIN) && (value <= MV_ALT_MAX);
+            break;
+        case MV_ALT_BY:
+            ok = (value >= -MV_ALT_MAX) && (value <= MV_ALT_MAX);
+            break;
+        case MV_YAW_BY:
+            ok = true;
+            break;
+        case MV_FACE:
+            ok = (value >= 0) && (value < 360);
+            break;
+        case MV_TOL:
+            ok = (program[i].arg <= MV_AXIS_YAW) && (value >= 0);
+            break;
+        case MV_WAIT:
+        case MV_DELAY:
+            waits[depth] = true;
+            // fall through
+        case MV_TIMEOUT:
+            ok = (value >= 0);
+            break;
+        case MV_REPEAT:
+            ok = (depth < MV_LOOP_DEPTH) && (value > 0);
+            if (ok)
+            {
+                waits[++depth] = false;
+            }
+            break;
+        case MV_NEXT:
+            // A loop that never waits would spin inside one control cycle
+            ok = (depth > 0) && waits[depth];
+            if (ok)
+            {
+                depth--;
+                waits[depth] = true;
+            }
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+        {
+            return -1 - i;
+        }
+    }
+    return -1 - i;
+}
+
+
+// *******************************************************
+// manoeuvreStart:      Starts a program from the current references.
+//                      Tolerances default to 5 units and there is no timeout.
+// TAKES:               mv, the interpreter
+//                      program, the program to run
+//                      altRef, yawRef, the references in use now
+// RETURNS:             false, leaving mv idle, if the program is invalid
+bool manoeuvreStart (manoeuvre_t *mv, const mvInstr_t *program,
+                     int32_t altRef, int32_t yawRef)
+{
+    mv->status = MV_IDLE;
+    if (program == NULL || manoeuvreValidate(program) < 0)
+    {
+        return false;
+    }
+    mv->program = program;
+    mv->pc = 0;
+    mv->depth = 0;
+    mv->altRef = altRef;
+    mv->yawRef = yawRef;
+    mv->altTol = MV_DEFAULT_TOL;
+    mv->yawTol = MV_DEFAULT_TOL;
+    mv->timeout = 0;
+    mv->waited = 0;
+    mv->settled = 0;
+    mv->elapsed = 0;
+    mv->status = MV_RUNNING;
+    return true;
+}
+
+
+// *******************************************************
+// manoeuvreStep:       Runs a manoeuvre for one control cycle, updating its
+//                      references
+// TAKES:               mv, the interpreter
+//                      altHundredths, yawHundredths, the measured altitude
+//                      and total yaw
+//                      elapsedMs, time since the last step
+// RETURNS:             The status after the step
+mvStatus_t manoeuvreStep (manoeuvre_t *mv, int32_t altHundredths,
+                          int32_t yawHundredths, uint32_t elapsedMs)
+{
+    const mvInstr_t *instr;
+    int32_t turn;
+    bool done;
+
+    if (mv->status != MV_RUNNING)
+    {
+        return mv->status;
+    }
+    mv->elapsed += elapsedMs;
+
+    // Finish the wait in progress first
+    instr = &mv->program[mv->pc];
+    if (instr->op == MV_WAIT || instr->op == MV_DELAY)
+    {
+        mv->waited += elapsedMs;
+        if (instr->op == MV_WAIT)
+        {
+            if ((abs(altHundredths - mv->altRef * FIXED_SCALE) <= mv->altTol) &&
+                (abs(yawHundredths - mv->yawRef * FIXED_SCALE) <= mv->yawTol))
+            {
+                mv->settled += elapsedMs;
+            } else {
+                mv->settled = 0;
+            }
+            done = (mv->settled >= (uint32_t)instr->value);
+            if (!done && mv->timeout != 0 && mv->waited >= mv->timeout)
+            {
+                mv->status = MV_TIMED_OUT;
+                return mv->status;
+            }
+        } else {
+            done = (mv->waited >= (uint32_t)instr->value);
+        }
+        if (!done)
+        {
+            return mv->status;
+        }
+        mv->pc++;
+    }
+
+    // Then run on to the next wait. Validation guarantees every loop waits,
+    // so this always stops.
+    for ( ;; )
+    {
+        instr = &mv->program[mv->pc];
+        switch (instr->op)
+        {
+        case MV_END:
+            mv->status = MV_DONE;
+            return mv->status;
+        case MV_ALT:
+            mv->altRef = instr->value;
+            break;
+        case MV_ALT_BY:
+            mv->altRef += instr->value;
+            if (mv->altRef < MV_ALT_MIN)
+            {
+                mv->altRef = MV_ALT_MIN;
+            } else if (mv->altRef > MV_ALT_MAX) {
+                mv->altRef = MV_ALT_MAX;
+            }
+            break;
+        case MV_YAW_BY:
+            mv->yawRef += instr->value;
+            break;
+        case MV_FACE:
+            turn = (instr->value - mv->yawRef) % 360;
+            if (turn < -180)
+            {
+                turn += 360;
+            } else if (turn >= 180) {
+                turn -= 360;
+            }
+            mv->yawRef += turn;
+            break;
+        case MV_TOL:
+            if (instr->arg == MV_AXIS_ALT)
+            {
+                mv->altTol = instr->value;
+            } else {
+                mv->yawTol = instr->value;
+            }
+            break;
+        case MV_TIMEOUT:
+            mv->timeout = instr->value;
+            break;
+        case MV_WAIT:
+        case MV_DELAY:
+            mv->waited = 0;
+            mv->settled = 0;
+            return mv->status;
+        case MV_REPEAT:
+            mv->loopStart[mv->depth] = mv->pc + 1;
+            mv->loopLeft[mv->depth] = instr->value;
+            mv->depth++;
+            break;
+        case MV_NEXT:
+            if (--mv->loopLeft[mv->depth - 1] > 0)
+            {
+                mv->pc = mv->loopStart[mv->depth - 1];
+                continue;
+            }
+            mv->depth--;
+            break;
+        }
+        mv->pc++;
+    }
+}
+
+
+// *******************************************************
+// manoeuvreStop:       Leaves a manoeuvre, keeping its references
+void manoeuvreStop (manoeuvre_t *mv)
+{
+    mv->status = MV_IDLE;
+}
+
+
+// *******************************************************
+// parseHex:            Reads a fixed number of hex digits
+// RETURNS:             false if any of them is not a hex digit
+static bool parseHex (const char **text, uint8_t digits, uint32_t *value)
+{
+    char c;
+
+    *value = 0;
+    while (digits--)
+    {
+        c = *(*text)++;
+        if (c >= '0' && c <= '9')
+        {
+            *value = (*value << 4) | (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            *value = (*value << 4) | (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            *value = (*value << 4) | (c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// *******************************************************
+// manoeuvreParseUpload: Decodes an upload line
+//                      "MV <slot> <op arg value as 8 hex digits> ... *<sum>"
+//                      where sum is the 8 bit sum of the instruction bytes
+//                      as 2 hex digits. The program is validated.
+// TAKES:               line, the received line without its line ending
+//                      program, buffer of MV_MAX_LENGTH instructions
+//                      slot, set to the slot the program is for
+// RETURNS:             The program length, or -1 if the line is rejected
+int32_t manoeuvreParseUpload (const char *line, mvInstr_t *program, uint8_t *slot)
+{
+    uint32_t word, sum = 0, check;
+    int32_t length = 0;
+
+    if (line[0] != 'M' || line[1] != 'V' || line[2] != ' ' ||
+        line[3] < '0' || line[3] >= '0' + MV_NUM_SLOTS)
+    {
+        return -1;
+    }
+    *slot = line[3] - '0';
+    line += 4;
+
+    while (*line == ' ' && line[1] != '*')
+    {
+        line++;
+        if (length == MV_MAX_LENGTH || !parseHex(&line, 8, &word))
+        {
+            return -1;
+        }
+        program[length].op = word >> 24;
+        program[length].arg = word >> 16;
+        program[length].value = (int16_t)word;
+        sum += (word >> 24) + ((word >> 16) & 0xFF) + ((word >> 8) & 0xFF) + (word & 0xFF);
+        length++;
+    }
+
+    if (line[0] != ' ' || line[1] != '*')
+    {
+        return -1;
+    }
+    line += 2;
+    if (!parseHex(&line, 2, &check) || *line != '\0' || check != (sum & 0xFF))
+    {
+        return -1;
+    }
+    if (length == 0 || program[length - 1].op != MV_END)
+    {
+        return -1;
+    }
+    return (manoeuvreValidate(program) == length) ? length : -1;
+}
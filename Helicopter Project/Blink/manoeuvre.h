@@ -0,0 +1,140 @@
+#ifndef MANOEUVRE_H_
+#define MANOEUVRE_H_
+
+//*****************************************************************************
+//
+// manoeuvre - Interpreter for scripted manoeuvres flown in Special mode. A
+//             manoeuvre is a short bytecode program that moves the altitude
+//             and yaw references through waypoints and waits for the
+//             helicopter to settle on each one, within tolerances, for a
+//             dwell time and before a timeout. The built in programs are
+//             const (see manoeuvrePrograms.c); replacements can be uploaded
+//             over UART into RAM. The interpreter has no hardware access so
+//             the host simulator runs exactly the same code.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define MV_MAX_LENGTH       32      // Instructions in a program, including MV_END
+#define MV_LOOP_DEPTH       2       // Nested MV_REPEAT loops
+#define MV_NUM_SLOTS        4       // Programs, one per button (UP, DOWN, LEFT, RIGHT)
+#define MV_UPLOAD_MAX       (3 + 2 + MV_MAX_LENGTH * 9 + 4)    // Upload line length
+#define MV_ALT_MIN          10      // Altitude references are kept within the
+#define MV_ALT_MAX          100     // range setAltRef allows
+
+// Opcodes. Altitudes are in percent, yaws in degrees, tolerances in 0.01
+// units and times in ms.
+enum mvOps {
+    MV_END = 0,     //                  Manoeuvre complete
+    MV_ALT,         // value            Altitude reference, MV_ALT_MIN..MV_ALT_MAX
+    MV_ALT_BY,      // value            Move the altitude reference by value,
+                    //                  stopping at MV_ALT_MIN and MV_ALT_MAX
+    MV_YAW_BY,      // value            Move the yaw reference by value
+    MV_FACE,        // value            Turn the shortest way to face heading
+                    //                  0..359, relative to the yaw reference
+    MV_TOL,         // MV_AXIS_, value  Tolerance of WAIT on one axis
+    MV_TIMEOUT,     // value            Time allowed for each WAIT, 0 for none
+    MV_WAIT,        // value            Wait until both axes have been within
+                    //                  tolerance of their references for value
+    MV_DELAY,       // value            Wait value regardless of position
+    MV_REPEAT,      // value            Run up to the matching MV_NEXT value times
+    MV_NEXT,
+    MV_NUM_OPS
+};
+
+enum mvAxes {MV_AXIS_ALT = 0, MV_AXIS_YAW};
+
+// Interpreter status
+typedef enum {MV_IDLE = 0, MV_RUNNING, MV_DONE, MV_TIMED_OUT} mvStatus_t;
+
+// *******************************************************
+// One instruction, 4 bytes
+typedef struct {
+    uint8_t op;
+    uint8_t arg;
+    int16_t value;
+} mvInstr_t;
+
+// *******************************************************
+// A running manoeuvre. The references are read back by the controller.
+typedef struct {
+    const mvInstr_t *program;
+    mvStatus_t status;
+    uint8_t pc;
+    uint8_t depth;                          // Open MV_REPEAT loops
+    uint8_t loopStart[MV_LOOP_DEPTH];
+    int16_t loopLeft[MV_LOOP_DEPTH];
+    int32_t altRef;                         // References, percent and degrees
+    int32_t yawRef;
+    int32_t altTol;                         // Tolerances, 0.01 units
+    int32_t yawTol;
+    uint32_t timeout;
+    uint32_t waited;                        // Time in the current WAIT or DELAY
+    uint32_t settled;                       // Time spent within tolerance
+    uint32_t elapsed;                       // Time since the start
+} manoeuvre_t;
+
+
+// *******************************************************
+// Built in programs, indexed by slot
+extern const mvInstr_t * const manoeuvreBuiltIn[MV_NUM_SLOTS];
+
+
+// *******************************************************
+// manoeuvreValidate:   Checks a program before it is run: known opcodes,
+//                      values in range, balanced loops each containing a
+//                      WAIT or DELAY, and an MV_END within MV_MAX_LENGTH.
+// RETURNS:             The program length including MV_END, or -1 - the
+//                      index of the first bad instruction
+int32_t
+manoeuvreValidate (const mvInstr_t *program);
+
+
+// *******************************************************
+// manoeuvreStart:      Starts a program from the current references.
+//                      Tolerances default to 5 units and there is no timeout.
+// TAKES:               mv, the interpreter
+//                      program, the program to run
+//                      altRef, yawRef, the references in use now
+// RETURNS:             false, leaving mv idle, if the program is invalid
+bool
+manoeuvreStart (manoeuvre_t *mv, const mvInstr_t *program,
+                int32_t altRef, int32_t yawRef);
+
+
+// *******************************************************
+// manoeuvreStep:       Runs a manoeuvre for one control cycle, updating its
+//                      references
+// TAKES:               mv, the interpreter
+//                      altHundredths, yawHundredths, the measured altitude
+//                      and total yaw
+//                      elapsedMs, time since the last step
+// RETURNS:             The status after the step
+mvStatus_t
+manoeuvreStep (manoeuvre_t *mv, int32_t altHundredths, int32_t yawHundredths,
+               uint32_t elapsedMs);
+
+
+// *******************************************************
+// manoeuvreStop:       Leaves a manoeuvre, keeping its references
+void
+manoeuvreStop (manoeuvre_t *mv);
+
+
+// *******************************************************
+// manoeuvreParseUpload: Decodes an upload line
+//                      "MV <slot> <op arg value as 8 hex digits> ... *<sum>"
+//                      where sum is the 8 bit sum of the instruction bytes
+//                      as 2 hex digits. The program is validated.
+// TAKES:               line, the received line without its line ending
+//                      program, buffer of MV_MAX_LENGTH instructions
+//                      slot, set to the slot the program is for
+// RETURNS:             The program length, or -1 if the line is rejected
+int32_t
+manoeuvreParseUpload (const char *line, mvInstr_t *program, uint8_t *slot);
+
+#endif /* MANOEUVRE_H_ */
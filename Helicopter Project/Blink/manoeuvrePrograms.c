@@ -0,0 +1,70 @@
+//*****************************************************************************
+//
+// manoeuvrePrograms - Built in manoeuvres flown from Special mode, one per
+//                     button. They are const and stay in flash; a program
+//                     uploaded over UART replaces one until the next reset.
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "manoeuvre.h"
+
+// *******************************************************
+// Spiral up: from 10% facing the reference, climb to 90% in 10% steps while
+// turning 45 degrees clockwise each step, ending facing the reference again
+static const mvInstr_t spiralUp[] = {
+    {MV_TOL, MV_AXIS_ALT, 500},
+    {MV_TOL, MV_AXIS_YAW, 500},
+    {MV_TIMEOUT, 0, 15000},
+    {MV_ALT, 0, 10},
+    {MV_FACE, 0, 0},
+    {MV_WAIT, 0, 300},
+    {MV_REPEAT, 0, 8},
+        {MV_ALT_BY, 0, 10},
+        {MV_YAW_BY, 0, 45},
+        {MV_WAIT, 0, 150},
+    {MV_NEXT, 0, 0},
+    {MV_END, 0, 0}
+};
+
+// *******************************************************
+// Spiral down: the reverse of spiralUp, from 90% down to 10%
+static const mvInstr_t spiralDown[] = {
+    {MV_TOL, MV_AXIS_ALT, 500},
+    {MV_TOL, MV_AXIS_YAW, 500},
+    {MV_TIMEOUT, 0, 15000},
+    {MV_ALT, 0, 90},
+    {MV_FACE, 0, 0},
+    {MV_WAIT, 0, 300},
+    {MV_REPEAT, 0, 8},
+        {MV_ALT_BY, 0, -10},
+        {MV_YAW_BY, 0, -45},
+        {MV_WAIT, 0, 150},
+    {MV_NEXT, 0, 0},
+    {MV_END, 0, 0}
+};
+
+// *******************************************************
+// Half turns at the current altitude. Left is a positive yaw on the rig.
+static const mvInstr_t spinLeft[] = {
+    {MV_TIMEOUT, 0, 10000},
+    {MV_YAW_BY, 0, 180},
+    {MV_WAIT, 0, 300},
+    {MV_END, 0, 0}
+};
+
+static const mvInstr_t spinRight[] = {
+    {MV_TIMEOUT, 0, 10000},
+    {MV_YAW_BY, 0, -180},
+    {MV_WAIT, 0, 300},
+    {MV_END, 0, 0}
+};
+
+// *******************************************************
+// Built in programs, indexed by slot
+const mvInstr_t * const manoeuvreBuiltIn[MV_NUM_SLOTS] = {
+    spiralUp,       // UP
+    spiralDown,     // DOWN
+    spinLeft,       // LEFT
+    spinRight       // RIGHT
+};
@@ -28,6 +28,9 @@
 #include "stdlib.h"
 #include "OrbitOLED/OrbitOLEDInterface.h"
 #include "motor.h"
+#include "fastIO.h"
+#include "heliContext.h"
+#include "perf.h"
 
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -79,21 +82,127 @@
 #define PWM_SEC_GPIO_BASE       GPIO_PORTF_BASE
 #define PWM_SEC_GPIO_CONFIG     GPIO_PF1_M1PWM5
 #define PWM_SEC_GPIO_PIN        GPIO_PIN_1
+#define PWM_SEC_GENBIT          PWM_GEN_2_BIT
+
+static uint32_t pwmPeriod = 0;         // Generator period in PWM clock counts
+static uint32_t pwmPermilleScale = 0;  // Counts per per-mille, PWM_SCALE_SHIFT fraction bits
+
+/********************************************************
+ * cachePWMPeriod
+ * The period never changes, so it is worked out once
+ * along with the per-mille to compare count scale.
+ ********************************************************/
+static void
+cachePWMPeriod (void)
+{
+    pwmPeriod = SysCtlClockGet() / PWM_DIVIDER / PWM_RATE_HZ;
+    pwmPermilleScale = (pwmPeriod << PWM_SCALE_SHIFT) / PWM_PERMILLE_MAX;
+}
+
+
+/********************************************************
+ * Function to set the compare count of M0PWM7. The new
+ * value is loaded at the next generator period boundary.
+ ********************************************************/
+void
+SetMainPWMCounts (uint32_t ui32Counts)
+{
+    if (ui32Counts > pwmPeriod)
+    {
+        ui32Counts = pwmPeriod;
+    }
+    g_heli.motor.mainPWM = (ui32Counts * PWM_PERMILLE_MAX + pwmPeriod / 2) / pwmPeriod;
+    fastPWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, pwmPeriod, ui32Counts);
+    fastPWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+}
+
+
+/********************************************************
+ * Function to set the duty cycle of M0PWM7 in per-mille
+ ********************************************************/
+void
+SetMainPWMPermille (uint32_t ui32Permille)
+{
+    if (ui32Permille > PWM_PERMILLE_MAX)
+    {
+        ui32Permille = PWM_PERMILLE_MAX;
+    }
+    g_heli.motor.mainPWM = ui32Permille;
+    fastPWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, pwmPeriod,
+                         (ui32Permille * pwmPermilleScale) >> PWM_SCALE_SHIFT);
+    fastPWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+}
+
 
-static uint32_t mainPWM = 0;
-static uint32_t tailPWM = 0;
 /********************************************************
- * Function to set the freq, duty cycle of M0PWM7
+ * Function to set the duty cycle of M0PWM7 in percent
  ********************************************************/
 void
 SetMainPWM (uint32_t ui32Duty)
 {
-    mainPWM = ui32Duty;
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t ui32Period = SysCtlClockGet() / PWM_DIVIDER / PWM_RATE_HZ;
+    SetMainPWMPermille(ui32Duty * 10);
+}
+
 
-    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, ui32Period);
-    PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, ui32Period * ui32Duty / 100);
+/********************************************************
+ * Function to set both rotors of a helicopter context at
+ * once in per-mille, driving them through its pwm hook
+ ********************************************************/
+void
+heliSetBothPWMPermille (HeliContext *heli, uint32_t ui32MainPermille,
+                        uint32_t ui32TailPermille)
+{
+    if (ui32MainPermille > PWM_PERMILLE_MAX)
+    {
+        ui32MainPermille = PWM_PERMILLE_MAX;
+    }
+    if (ui32TailPermille > PWM_PERMILLE_MAX)
+    {
+        ui32TailPermille = PWM_PERMILLE_MAX;
+    }
+    heli->motor.mainPWM = ui32MainPermille;
+    heli->motor.tailPWM = ui32TailPermille;
+
+    if (heli->hooks.pwm != NULL)
+    {
+        heli->hooks.pwm(heli, ui32MainPermille, ui32TailPermille);
+    }
+}
+
+
+/********************************************************
+ * Function to set both rotors at once in per-mille. Both
+ * compare values are written first and the two generators
+ * are then released back to back, so the new duties start
+ * on the same PWM period instead of one cycle apart.
+ ********************************************************/
+void
+SetBothPWMPermille (uint32_t ui32MainPermille, uint32_t ui32TailPermille)
+{
+    heliSetBothPWMPermille(&g_heli, ui32MainPermille, ui32TailPermille);
+}
+
+
+/********************************************************
+ * drivePWM
+ * The pwm hook of g_heli, as SetBothPWMPermille. Timed
+ * as PERF_PWM, the PWM setter every control cycle runs.
+ ********************************************************/
+static void
+drivePWM (HeliContext *heli, uint32_t ui32MainPermille, uint32_t ui32TailPermille)
+{
+    uint32_t start = PERF_CYCLES();
+
+    fastPWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, pwmPeriod,
+                         (ui32MainPermille * pwmPermilleScale) >> PWM_SCALE_SHIFT);
+    fastPWMPulseWidthSet(PWM_SEC_BASE, PWM_SEC_OUTNUM, pwmPeriod,
+                         (ui32TailPermille * pwmPermilleScale) >> PWM_SCALE_SHIFT);
+
+    taskENTER_CRITICAL();
+    fastPWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+    fastPWMSyncUpdate(PWM_SEC_BASE, PWM_SEC_GENBIT);
+    taskEXIT_CRITICAL();
+    perfRecord(PERF_PWM, PERF_CYCLES() - start);
 }
 
 
@@ -112,8 +221,11 @@ initialiseMainPWM (void)
     GPIOPinConfigure(PWM_MAIN_GPIO_CONFIG);
     GPIOPinTypePWM(PWM_MAIN_GPIO_BASE, PWM_MAIN_GPIO_PIN);
 
+    // Compare writes only take effect on PWMSyncUpdate, at the next
+    // period boundary, so an update never produces a runt pulse
     PWMGenConfigure(PWM_MAIN_BASE, PWM_MAIN_GEN,
-                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
+                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_SYNC);
+    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, pwmPeriod);
     // Set the initial PWM parameters
     SetMainPWM (PWM_MAIN_START_DUTY);
 
@@ -125,19 +237,46 @@ initialiseMainPWM (void)
 
 
 /********************************************************
- * Function to set the freq, duty cycle of M1PWM5
+ * Function to set the compare count of M1PWM5. The new
+ * value is loaded at the next generator period boundary.
  ********************************************************/
 void
-SetTailPWM (uint32_t ui32Duty)
+SetTailPWMCounts (uint32_t ui32Counts)
+{
+    if (ui32Counts > pwmPeriod)
+    {
+        ui32Counts = pwmPeriod;
+    }
+    g_heli.motor.tailPWM = (ui32Counts * PWM_PERMILLE_MAX + pwmPeriod / 2) / pwmPeriod;
+    fastPWMPulseWidthSet(PWM_SEC_BASE, PWM_SEC_OUTNUM, pwmPeriod, ui32Counts);
+    fastPWMSyncUpdate(PWM_SEC_BASE, PWM_SEC_GENBIT);
+}
+
+
+/********************************************************
+ * Function to set the duty cycle of M1PWM5 in per-mille
+ ********************************************************/
+void
+SetTailPWMPermille (uint32_t ui32Permille)
 {
-    tailPWM = ui32Duty;
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t ui32Period =
-        SysCtlClockGet() / PWM_DIVIDER / PWM_RATE_HZ;
+    if (ui32Permille > PWM_PERMILLE_MAX)
+    {
+        ui32Permille = PWM_PERMILLE_MAX;
+    }
+    g_heli.motor.tailPWM = ui32Permille;
+    fastPWMPulseWidthSet(PWM_SEC_BASE, PWM_SEC_OUTNUM, pwmPeriod,
+                         (ui32Permille * pwmPermilleScale) >> PWM_SCALE_SHIFT);
+    fastPWMSyncUpdate(PWM_SEC_BASE, PWM_SEC_GENBIT);
+}
+
 
-    PWMGenPeriodSet(PWM_SEC_BASE, PWM_SEC_GEN, ui32Period);
-    PWMPulseWidthSet(PWM_SEC_BASE, PWM_SEC_OUTNUM,
-        ui32Period * ui32Duty / 100);
+/********************************************************
+ * Function to set the duty cycle of M1PWM5 in percent
+ ********************************************************/
+void
+SetTailPWM (uint32_t ui32Duty)
+{
+    SetTailPWMPermille(ui32Duty * 10);
 }
 
 /*********************************************************
@@ -155,8 +294,11 @@ initialiseTailPWM (void)
     GPIOPinConfigure(PWM_SEC_GPIO_CONFIG);
     GPIOPinTypePWM(PWM_SEC_GPIO_BASE, PWM_SEC_GPIO_PIN);
 
+    // Compare writes only take effect on PWMSyncUpdate, at the next
+    // period boundary, so an update never produces a runt pulse
     PWMGenConfigure(PWM_SEC_BASE, PWM_SEC_GEN,
-                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
+                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_SYNC);
+    PWMGenPeriodSet(PWM_SEC_BASE, PWM_SEC_GEN, pwmPeriod);
     // Set the initial PWM parameters
     SetTailPWM (PWM_SEC_START_DUTY);
 
@@ -166,29 +308,58 @@ initialiseTailPWM (void)
     PWMOutputState(PWM_SEC_BASE, PWM_SEC_OUTBIT, false);
 }
 
-/********************************************************
-* resetmotor
-* Resets the Peripherals for the GPIO Pins and PWM pins
- ********************************************************/
-void
-resetmotor(void)
+uint32_t
+heliGetMainPWM(const HeliContext *heli)
+{
+    return heli->motor.mainPWM / 10;
+}
+
+uint32_t
+heliGetTailPWM(const HeliContext *heli)
 {
-    SysCtlPeripheralReset (PWM_MAIN_PERIPH_GPIO); // Used for PWM output
-    SysCtlPeripheralReset (PWM_MAIN_PERIPH_PWM);  // Main Rotor PWM
-    SysCtlPeripheralReset (PWM_SEC_PERIPH_GPIO); // Used for PWM output
-    SysCtlPeripheralReset (PWM_SEC_PERIPH_PWM);  // Main Rotor PWM
+    return heli->motor.tailPWM / 10;
+}
+
+uint32_t
+heliGetMainPWMPermille(const HeliContext *heli)
+{
+    return heli->motor.mainPWM;
+}
+
+uint32_t
+heliGetTailPWMPermille(const HeliContext *heli)
+{
+    return heli->motor.tailPWM;
 }
 
 uint32_t
 getMainPWM(void)
 {
-    return mainPWM;
+    return heliGetMainPWM(&g_heli);
 }
 
 uint32_t
 getTailPWM(void)
 {
-    return tailPWM;
+    return heliGetTailPWM(&g_heli);
+}
+
+uint32_t
+getMainPWMPermille(void)
+{
+    return heliGetMainPWMPermille(&g_heli);
+}
+
+uint32_t
+getTailPWMPermille(void)
+{
+    return heliGetTailPWMPermille(&g_heli);
+}
+
+uint32_t
+getPWMPeriod(void)
+{
+    return pwmPeriod;
 }
 
 
@@ -199,10 +370,11 @@ getTailPWM(void)
 void
 initmotor(void)
 {
-    // As a precaution, make sure that the peripherals used are reset
-    resetmotor();
-
+    // The peripherals are in their reset state from power on, and their
+    // clocks already run, see bootEnablePeripherals
     SysCtlPWMClockSet(PWM_DIVIDER_CODE);
+    cachePWMPeriod ();
+    g_heli.hooks.pwm = drivePWM;
     initialiseMainPWM ();
     initialiseTailPWM ();
 
@@ -8,6 +8,8 @@
 #ifndef MOTOR_H_
 #define MOTOR_H_
 
+#include <stdint.h>
+
 /**********************************************************
  * Constants
  **********************************************************/
@@ -19,6 +21,15 @@
 #define PWM_DIVIDER_CODE        SYSCTL_PWMDIV_16
 #define PWM_DIVIDER             16
 
+#define PWM_PERMILLE_MAX        1000    // Full scale of the per-mille duty API
+#define PWM_SCALE_SHIFT         16      // Fraction bits of the cached count scale
+
+// Duty cycles last committed to one helicopter's rotors, see heliContext.h
+typedef struct {
+    uint32_t mainPWM;       // Per-mille
+    uint32_t tailPWM;
+} motorDuty_t;
+
 //Second PWM Config
 #define PWM_SEC_START_DUTY      0 //10
 #define PWM_MAIN_START_DUTY     0 //50
@@ -34,11 +45,36 @@
 #define PWM_MAIN_GPIO_BASE      GPIO_PORTC_BASE
 #define PWM_MAIN_GPIO_CONFIG    GPIO_PC5_M0PWM7
 #define PWM_MAIN_GPIO_PIN       GPIO_PIN_5
+#define PWM_MAIN_GENBIT         PWM_GEN_3_BIT
 
 
+/********************************************************
+ * Function to set the duty cycle of M0PWM7 in percent
+ ********************************************************/
 void
 SetMainPWM (uint32_t ui32Duty);
 
+/********************************************************
+ * Function to set the duty cycle of M0PWM7 in per-mille.
+ * The new value is loaded at the next period boundary.
+ ********************************************************/
+void
+SetMainPWMPermille (uint32_t ui32Permille);
+
+/********************************************************
+ * Function to set the compare count of M0PWM7, from 0 to
+ * getPWMPeriod(). Loaded at the next period boundary.
+ ********************************************************/
+void
+SetMainPWMCounts (uint32_t ui32Counts);
+
+/********************************************************
+ * Function to set both rotors at once in per-mille. The
+ * new duties start on the same PWM period.
+ ********************************************************/
+void
+SetBothPWMPermille (uint32_t ui32MainPermille, uint32_t ui32TailPermille);
+
 /*********************************************************
  * initialiseMainPWM
  * M0PWM7 (J4-05, PC5) is used for the main rotor motor
@@ -49,11 +85,25 @@ initialiseMainPWM (void);
 
 
 /********************************************************
- * Function to set the freq, duty cycle of M1PWM5
+ * Function to set the duty cycle of M1PWM5 in percent
  ********************************************************/
 void
 SetTailPWM (uint32_t ui32Duty);
 
+/********************************************************
+ * Function to set the duty cycle of M1PWM5 in per-mille.
+ * The new value is loaded at the next period boundary.
+ ********************************************************/
+void
+SetTailPWMPermille (uint32_t ui32Permille);
+
+/********************************************************
+ * Function to set the compare count of M1PWM5, from 0 to
+ * getPWMPeriod(). Loaded at the next period boundary.
+ ********************************************************/
+void
+SetTailPWMCounts (uint32_t ui32Counts);
+
 
 /*********************************************************
  * initialiseTailPWM
@@ -62,9 +112,6 @@ SetTailPWM (uint32_t ui32Duty);
 void
 initialiseTailPWM (void);
 
-void
-resetmotor(void);
-
 void
 initmotor(void);
 
@@ -80,6 +127,19 @@ getMainPWM(void);
 uint32_t
 getTailPWM(void);
 
+uint32_t
+getMainPWMPermille(void);
+
+uint32_t
+getTailPWMPermille(void);
+
+/********************************************************
+ * getPWMPeriod
+ * The generator period in PWM clock counts, cached at init
+ ********************************************************/
+uint32_t
+getPWMPeriod(void);
+
 
 
 #endif /* MOTOR_H_ */
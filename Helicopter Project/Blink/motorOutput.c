@@ -0,0 +1,199 @@
+//*****************************************************************************
+//
+// motorOutput - Output stage between the controllers and the PWM hardware.
+//               The controllers set targets for both rotors; each control
+//               cycle the targets are slew limited (with a gentler soft start
+//               ramp after take off is commanded) and both rotors are then
+//               committed together. The slew core has no hardware access so
+//               it can be run on the host. The channels are kept in the
+//               helicopter context; the global API below runs on g_heli.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "motorOutput.h"
+#include "motor.h"
+#include "heliContext.h"
+
+
+// *******************************************************
+// motorChannelInit:    Sets a channel to rest with the given slew rates
+void motorChannelInit (motorChannel_t *channel, int32_t slewUp, int32_t slewDown)
+{
+    channel->current = 0;
+    channel->target = 0;
+    channel->slewUp = slewUp;
+    channel->slewDown = slewDown;
+    channel->softStartTo = 0;
+}
+
+
+// *******************************************************
+// motorChannelStep:    Moves the channel's duty towards its target, limited
+//                      by its slew rate, or by the soft start rate while
+//                      below the soft start duty.
+// TAKES:               channel, the channel to step
+//                      elapsedMs, time since the last step
+// RETURNS:             true if the duty changed
+bool motorChannelStep (motorChannel_t *channel, uint32_t elapsedMs)
+{
+    int32_t previous = channel->current;
+    int32_t delta = channel->target - channel->current;
+    int32_t rate, limit;
+
+    if (delta > 0)
+    {
+        rate = (channel->current < channel->softStartTo) ? SOFT_START_SLEW
+                                                         : channel->slewUp;
+    } else {
+        rate = channel->slewDown;
+    }
+
+    // At least one per-mille a step so a short step still makes progress
+    limit = (rate * (int32_t)elapsedMs + 999) / 1000;
+
+    if (delta > limit)
+    {
+        delta = limit;
+    } else if (delta < -limit) {
+        delta = -limit;
+    }
+    // The soft start ramp stops exactly at its end duty
+    if (previous < channel->softStartTo && previous + delta > channel->softStartTo)
+    {
+        delta = channel->softStartTo - previous;
+    }
+    channel->current += delta;
+
+    return channel->current != previous;
+}
+
+
+// *******************************************************
+// heliInitMotorOutput: Sets both rotors to rest
+void heliInitMotorOutput (HeliContext *heli)
+{
+    motorChannelInit(&heli->output.mainChannel, MAIN_SLEW_UP, MAIN_SLEW_DOWN);
+    motorChannelInit(&heli->output.tailChannel, TAIL_SLEW_UP, TAIL_SLEW_DOWN);
+}
+
+
+// *******************************************************
+// heliMotorOutputSetMain: Sets the main rotor target duty in per-mille
+void heliMotorOutputSetMain (HeliContext *heli, int32_t permille)
+{
+    heli->output.mainChannel.target = permille;
+}
+
+
+// *******************************************************
+// heliMotorOutputSetTail: Sets the tail rotor target duty in per-mille
+void heliMotorOutputSetTail (HeliContext *heli, int32_t permille)
+{
+    heli->output.tailChannel.target = permille;
+}
+
+
+// *******************************************************
+// heliMotorOutputSoftStart: Sets both targets and ramps the rotors gently up
+//                      to them. Later, higher targets use the normal slew
+//                      rate.
+void heliMotorOutputSoftStart (HeliContext *heli, int32_t mainPermille,
+                               int32_t tailPermille)
+{
+    motorOutput_t *output = &heli->output;
+
+    output->mainChannel.target = output->mainChannel.softStartTo = mainPermille;
+    output->tailChannel.target = output->tailChannel.softStartTo = tailPermille;
+}
+
+
+// *******************************************************
+// heliMotorOutputApply: Steps both channels and commits them together if
+//                      either changed
+void heliMotorOutputApply (HeliContext *heli, uint32_t elapsedMs)
+{
+    motorOutput_t *output = &heli->output;
+    bool changed = motorChannelStep(&output->mainChannel, elapsedMs);
+
+    changed |= motorChannelStep(&output->tailChannel, elapsedMs);
+    if (changed)
+    {
+        heliSetBothPWMPermille(heli, output->mainChannel.current,
+                               output->tailChannel.current);
+    }
+}
+
+
+// *******************************************************
+// heliMotorOutputGetMain: RETURNS the main rotor duty last committed
+int32_t heliMotorOutputGetMain (const HeliContext *heli)
+{
+    return heli->output.mainChannel.current;
+}
+
+
+// *******************************************************
+// heliMotorOutputGetTail: RETURNS the tail rotor duty last committed
+int32_t heliMotorOutputGetTail (const HeliContext *heli)
+{
+    return heli->output.tailChannel.current;
+}
+
+
+// *******************************************************
+// heliMotorOutputStop: Turns both rotors off at once, without slewing
+void heliMotorOutputStop (HeliContext *heli)
+{
+    motorOutput_t *output = &heli->output;
+
+    output->mainChannel.target = output->mainChannel.current = 0;
+    output->tailChannel.target = output->tailChannel.current = 0;
+    output->mainChannel.softStartTo = output->tailChannel.softStartTo = 0;
+    heliSetBothPWMPermille(heli, 0, 0);
+}
+
+
+// *******************************************************
+// The global API, on g_heli
+
+void initMotorOutput (void)
+{
+    heliInitMotorOutput(&g_heli);
+}
+
+void motorOutputSetMain (int32_t permille)
+{
+    heliMotorOutputSetMain(&g_heli, permille);
+}
+
+void motorOutputSetTail (int32_t permille)
+{
+    heliMotorOutputSetTail(&g_heli, permille);
+}
+
+void motorOutputSoftStart (int32_t mainPermille, int32_t tailPermille)
+{
+    heliMotorOutputSoftStart(&g_heli, mainPermille, tailPermille);
+}
+
+void motorOutputApply (uint32_t elapsedMs)
+{
+    heliMotorOutputApply(&g_heli, elapsedMs);
+}
+
+int32_t motorOutputGetMain (void)
+{
+    return heliMotorOutputGetMain(&g_heli);
+}
+
+int32_t motorOutputGetTail (void)
+{
+    return heliMotorOutputGetTail(&g_heli);
+}
+
+void motorOutputStop (void)
+{
+    heliMotorOutputStop(&g_heli);
+}
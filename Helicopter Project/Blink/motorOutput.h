@@ -0,0 +1,111 @@
+#ifndef MOTOROUTPUT_H_
+#define MOTOROUTPUT_H_
+
+//*****************************************************************************
+//
+// motorOutput - Output stage between the controllers and the PWM hardware.
+//               The controllers set targets for both rotors; each control
+//               cycle the targets are slew limited (with a gentler soft start
+//               ramp after take off is commanded) and both rotors are then
+//               committed together. The slew core has no hardware access so
+//               it can be run on the host. The channels are kept in the
+//               helicopter context; the global API below runs on g_heli.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants, duty in per-mille and rates in per-mille per second
+//*****************************************************************************
+#define MAIN_SLEW_UP        500     // Main rotor spin up
+#define MAIN_SLEW_DOWN      1000    // Main rotor spin down
+#define TAIL_SLEW_UP        1000    // Tail rotor spin up
+#define TAIL_SLEW_DOWN      1000    // Tail rotor spin down
+#define SOFT_START_SLEW     200     // Spin up of both rotors from rest
+
+// *******************************************************
+// One output channel
+typedef struct {
+    int32_t current;        // Duty last committed
+    int32_t target;         // Duty asked for by the controller
+    int32_t slewUp;         // Rate limits
+    int32_t slewDown;
+    int32_t softStartTo;    // Duty below which spin up is at SOFT_START_SLEW
+} motorChannel_t;
+
+// *******************************************************
+// Both of one helicopter's rotors, see heliContext.h
+typedef struct {
+    motorChannel_t mainChannel;
+    motorChannel_t tailChannel;
+} motorOutput_t;
+
+
+// *******************************************************
+// motorChannelInit:    Sets a channel to rest with the given slew rates
+void
+motorChannelInit (motorChannel_t *channel, int32_t slewUp, int32_t slewDown);
+
+
+// *******************************************************
+// motorChannelStep:    Moves the channel's duty towards its target, limited
+//                      by its slew rate, or by the soft start rate while
+//                      below the soft start duty.
+// TAKES:               channel, the channel to step
+//                      elapsedMs, time since the last step
+// RETURNS:             true if the duty changed
+bool
+motorChannelStep (motorChannel_t *channel, uint32_t elapsedMs);
+
+
+// *******************************************************
+// initMotorOutput:     Sets both rotors to rest
+void
+initMotorOutput (void);
+
+
+// *******************************************************
+// motorOutputSetMain:  Sets the main rotor target duty in per-mille
+void
+motorOutputSetMain (int32_t permille);
+
+
+// *******************************************************
+// motorOutputSetTail:  Sets the tail rotor target duty in per-mille
+void
+motorOutputSetTail (int32_t permille);
+
+
+// *******************************************************
+// motorOutputSoftStart: Sets both targets and ramps the rotors gently up to
+//                      them. Later, higher targets use the normal slew rate.
+// TAKES:               mainPermille, tailPermille, the starting duties
+void
+motorOutputSoftStart (int32_t mainPermille, int32_t tailPermille);
+
+
+// *******************************************************
+// motorOutputApply:    Steps both channels and commits them to the PWM
+//                      hardware together if either changed
+// TAKES:               elapsedMs, time since the last apply
+void
+motorOutputApply (uint32_t elapsedMs);
+
+
+// *******************************************************
+// motorOutputGetMain:  RETURNS the main rotor duty last committed, per-mille
+int32_t
+motorOutputGetMain (void);
+
+// *******************************************************
+// motorOutputGetTail:  RETURNS the tail rotor duty last committed, per-mille
+int32_t
+motorOutputGetTail (void);
+
+// *******************************************************
+// motorOutputStop:     Turns both rotors off at once, without slewing
+void
+motorOutputStop (void);
+
+#endif /* MOTOROUTPUT_H_ */
@@ -0,0 +1,68 @@
+//*****************************************************************************
+//
+// perf - Cycle accurate timing with the Cortex-M4 DWT cycle counter, which
+//        TivaWare has no driver for, and min/mean/max statistics for a few
+//        timed points in the ISRs and control loop.
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include <stdbool.h>
+
+#include "inc/hw_types.h"
+#include "driverlib/cpu.h"
+
+#include "perf.h"
+
+static perfStat_t stats[NUM_PERF_POINTS];
+
+
+// *******************************************************
+// initPerf:            Starts the cycle counter from zero
+void initPerf (void)
+{
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+
+// *******************************************************
+// perfRecord:          Adds one timing to a point
+void perfRecord (uint8_t point, uint32_t cycles)
+{
+    perfStat_t *stat = &stats[point];
+    uint32_t ui32Mask = CPUcpsid();
+
+    if (stat->count == 0 || cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    stat->count++;
+    stat->total += cycles;
+    if (!ui32Mask)
+    {
+        CPUcpsie();
+    }
+}
+
+
+// *******************************************************
+// perfTake:            Copies a point's statistics and starts it again
+void perfTake (uint8_t point, perfStat_t *stat)
+{
+    uint32_t ui32Mask = CPUcpsid();
+
+    *stat = stats[point];
+    stats[point].count = 0;
+    stats[point].total = 0;
+    stats[point].max = 0;
+    if (!ui32Mask)
+    {
+        CPUcpsie();
+    }
+}
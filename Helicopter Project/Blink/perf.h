@@ -0,0 +1,73 @@
+#ifndef PERF_H_
+#define PERF_H_
+
+//*****************************************************************************
+//
+// perf - Cycle accurate timing with the Cortex-M4 DWT cycle counter, which
+//        TivaWare has no driver for, and min/mean/max statistics for a few
+//        timed points in the ISRs and control loop. The counter wraps every 53 s at 80 MHz,
+//        so only differences of shorter intervals are meaningful.
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "inc/hw_types.h"
+
+#include "FreeRTOSConfig.h"
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define DEMCR               0xE000EDFC
+#define DEMCR_TRCENA        0x01000000
+#define DWT_CTRL            0xE0001000
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DWT_CYCCNT          0xE0001004
+
+#define PERF_CYCLES_PER_US  (configCPU_CLOCK_HZ / 1000000)
+#define PERF_CYCLES_PER_MS  (configCPU_CLOCK_HZ / 1000)
+
+// *******************************************************
+// PERF_CYCLES:         The cycle counter now
+#define PERF_CYCLES()       (HWREG(DWT_CYCCNT))
+
+// *******************************************************
+// PERF_US:             Microseconds in a cycle count
+#define PERF_US(cycles)     ((cycles) / PERF_CYCLES_PER_US)
+
+
+// Timed code, each with its own statistics
+enum perfPoints {PERF_YAW_ISR = 0, PERF_ADC_ISR, PERF_CONTROL, PERF_REF_ISR,
+                 PERF_DEFER_LATENCY, PERF_PWM, NUM_PERF_POINTS};
+
+// *******************************************************
+// Cycle counts of one timed point since it was last taken
+typedef struct {
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+} perfStat_t;
+
+
+// *******************************************************
+// initPerf:            Starts the cycle counter from zero
+void
+initPerf (void);
+
+
+// *******************************************************
+// perfRecord:          Adds one timing to a point. Safe from ISRs of any
+//                      priority.
+// TAKES:               point, one of perfPoints
+//                      cycles, the time taken
+void
+perfRecord (uint8_t point, uint32_t cycles);
+
+
+// *******************************************************
+// perfTake:            Copies a point's statistics and starts it again
+void
+perfTake (uint8_t point, perfStat_t *stat);
+
+#endif /* PERF_H_ */
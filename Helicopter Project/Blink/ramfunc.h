@@ -0,0 +1,40 @@
+#ifndef RAMFUNC_H_
+#define RAMFUNC_H_
+
+//*****************************************************************************
+//
+// ramfunc - Places hot functions in SRAM. At 80 MHz the flash needs wait
+//           states that the prefetch buffer only partly hides on branchy
+//           code; SRAM runs with none. RAMFUNC functions are linked into
+//           .ramfunc, which the linker loads in flash and runs in SRAM, and
+//           ResetISR copies them across before the C runtime starts. The
+//           linker adds trampolines for calls between flash and SRAM.
+//
+//           Off until measured: SRAM is on the system bus, so code run
+//           from it shares the bus with its own data, and every call back
+//           into flash goes through a trampoline. Build with
+//           RAMFUNC_ENABLE=1 for both the compiler and the linker
+//           (--define=RAMFUNC_ENABLE=1 in both tools' CCS options) and
+//           check Blink.map before trusting it:
+//             - .ramfunc runs at 0x2000xxxx, loads in flash, and lists the
+//               RAMFUNC functions, portasm.obj, xPortSysTickHandler,
+//               vTaskSwitchContext and xTaskIncrementTick
+//             - __ramfunc_size equals the length of .ramfunc
+//             - the FAR CALL TRAMPOLINES list shows what each SRAM
+//               function pays to reach flash
+//           Then fly both builds on the rig for a minute each and compare
+//           the "ISR cyc" and "Ctrl cyc" lines the display task prints,
+//           which are tagged SRAM or flash.
+//*****************************************************************************
+
+#ifndef RAMFUNC_ENABLE
+#define RAMFUNC_ENABLE      0
+#endif
+
+#if RAMFUNC_ENABLE && defined(__TI_COMPILER_VERSION__)
+#define RAMFUNC             __attribute__((section(".ramfunc")))
+#else
+#define RAMFUNC
+#endif
+
+#endif /* RAMFUNC_H_ */
@@ -0,0 +1,260 @@
+//*****************************************************************************
+//
+// stateMachine - Table driven hierarchical state machine fed by a single
+//                event queue. ISRs, timers and tasks post events; only the
+//                task that owns the machine dispatches them, so the state is
+//                never changed from two contexts. A state with no row for an
+//                event passes it to its parent state. Every transition is
+//                logged with the time it happened and the time since its
+//                event was posted.
+//
+//                The queue is held in the machine, the caller gives the
+//                time and the owner guards the queue, so a machine needs no
+//                RTOS objects and there can be one per helicopter context.
+//                Every state function, guard and action is passed the
+//                machine's owner.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stateMachine.h"
+
+
+// *******************************************************
+// smInit:              Empties the event queue and enters the initial state
+void smInit (stateMachine_t *sm, const smState_t *states, const smTransition_t *table,
+             uint8_t numTransitions, uint8_t initial, void *owner,
+             void (*onTransition)(void *owner, const smLogEntry_t *entry))
+{
+    sm->states = states;
+    sm->table = table;
+    sm->numTransitions = numTransitions;
+    sm->current = initial;
+    sm->owner = owner;
+    sm->onTransition = onTransition;
+    sm->lock = NULL;
+    sm->unlock = NULL;
+    sm->numPosted = 0;
+    sm->numTaken = 0;
+    sm->numLogged = 0;
+    sm->maxLatency = 0;
+
+    if (states[initial].entry != NULL)
+    {
+        states[initial].entry(owner);
+    }
+}
+
+
+// *******************************************************
+// smSetLock:           Sets how the queue is guarded
+void smSetLock (stateMachine_t *sm, void (*lock)(void *owner),
+                void (*unlock)(void *owner))
+{
+    sm->lock = lock;
+    sm->unlock = unlock;
+}
+
+
+// *******************************************************
+// lockQueue, unlockQueue: Guard the queue, if the owner gave a lock
+static void lockQueue (stateMachine_t *sm)
+{
+    if (sm->lock != NULL)
+    {
+        sm->lock(sm->owner);
+    }
+}
+
+static void unlockQueue (stateMachine_t *sm)
+{
+    if (sm->unlock != NULL)
+    {
+        sm->unlock(sm->owner);
+    }
+}
+
+
+// *******************************************************
+// queueEvent:          Adds an event to the queue. Called with the queue
+//                      guarded.
+// RETURNS:             false if the queue was full
+static bool queueEvent (stateMachine_t *sm, uint8_t event, TickType_t posted)
+{
+    smEvent_t *queued;
+
+    if (sm->numPosted - sm->numTaken >= SM_QUEUE_LENGTH)
+    {
+        return false;
+    }
+    queued = &sm->queue[sm->numPosted++ & (SM_QUEUE_LENGTH - 1)];
+    queued->event = event;
+    queued->posted = posted;
+    return true;
+}
+
+
+// *******************************************************
+// smPost:              Queues an event from a task or timer callback
+// RETURNS:             false if the queue was full
+bool smPost (stateMachine_t *sm, uint8_t event, TickType_t posted)
+{
+    bool queued;
+
+    lockQueue(sm);
+    queued = queueEvent(sm, event, posted);
+    unlockQueue(sm);
+    return queued;
+}
+
+
+// *******************************************************
+// smPostFromISR:       Queues an event from an interrupt handler
+// RETURNS:             false if the queue was full
+bool smPostFromISR (stateMachine_t *sm, uint8_t event, TickType_t posted)
+{
+    UBaseType_t mask;
+    bool queued;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    queued = queueEvent(sm, event, posted);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return queued;
+}
+
+
+// *******************************************************
+// takeEvent:           Removes the oldest event from the queue
+// RETURNS:             false if the queue was empty
+static bool takeEvent (stateMachine_t *sm, smEvent_t *event)
+{
+    bool taken = false;
+
+    lockQueue(sm);
+    if (sm->numTaken != sm->numPosted)
+    {
+        *event = sm->queue[sm->numTaken++ & (SM_QUEUE_LENGTH - 1)];
+        taken = true;
+    }
+    unlockQueue(sm);
+    return taken;
+}
+
+
+// *******************************************************
+// dispatch:            Takes the first matching transition of the current
+//                      state, or failing that of its nearest parent
+static void dispatch (stateMachine_t *sm, uint8_t event, TickType_t posted,
+                      TickType_t now)
+{
+    const smTransition_t *row;
+    smLogEntry_t *entry;
+    uint8_t state, i;
+
+    for (state = sm->current; state != SM_NO_PARENT; state = sm->states[state].parent)
+    {
+        for (i = 0; i < sm->numTransitions; i++)
+        {
+            row = &sm->table[i];
+            if (row->state != state || row->event != event ||
+                (row->guard != NULL && !row->guard(sm->owner)))
+            {
+                continue;
+            }
+
+            if (row->action != NULL)
+            {
+                row->action(sm->owner);
+            }
+            entry = &sm->log[sm->numLogged++ & (SM_LOG_LENGTH - 1)];
+            entry->time = now;
+            entry->from = sm->current;
+            entry->to = row->next;
+            entry->event = event;
+            entry->latency = (now - posted) * portTICK_PERIOD_MS;
+            if (entry->latency > sm->maxLatency)
+            {
+                sm->maxLatency = entry->latency;
+            }
+
+            sm->current = row->next;
+            if (sm->states[row->next].entry != NULL)
+            {
+                sm->states[row->next].entry(sm->owner);
+            }
+            if (sm->onTransition != NULL)
+            {
+                sm->onTransition(sm->owner, entry);
+            }
+            return;
+        }
+    }
+}
+
+
+// *******************************************************
+// smRun:               Dispatches every queued event, oldest first. Only the
+//                      owning task may call this.
+void smRun (stateMachine_t *sm, TickType_t now)
+{
+    smEvent_t queued;
+
+    while (takeEvent(sm, &queued))
+    {
+        dispatch(sm, queued.event, queued.posted, now);
+    }
+}
+
+
+// *******************************************************
+// smTick:              Runs the during function of the current state and
+//                      its parents, then dispatches SM_EV_TICK so guarded
+//                      transitions are tried
+void smTick (stateMachine_t *sm, TickType_t now)
+{
+    uint8_t state;
+
+    for (state = sm->current; state != SM_NO_PARENT; state = sm->states[state].parent)
+    {
+        if (sm->states[state].during != NULL)
+        {
+            sm->states[state].during(sm->owner);
+        }
+    }
+    dispatch(sm, SM_EV_TICK, now, now);
+}
+
+
+// *******************************************************
+// smIn:                RETURNS true if the machine is in state, or in a
+//                      state nested inside it
+bool smIn (const stateMachine_t *sm, uint8_t state)
+{
+    uint8_t s;
+
+    for (s = sm->current; s != SM_NO_PARENT; s = sm->states[s].parent)
+    {
+        if (s == state)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// *******************************************************
+// smLogEntry:          RETURNS the n'th most recent transition (0 is the
+//                      latest), or NULL if there is none
+const smLogEntry_t *smLogEntry (const stateMachine_t *sm, uint32_t n)
+{
+    if (n >= sm->numLogged || n >= SM_LOG_LENGTH)
+    {
+        return NULL;
+    }
+    return &sm->log[(sm->numLogged - 1 - n) & (SM_LOG_LENGTH - 1)];
+}
@@ -0,0 +1,162 @@
+#ifndef STATEMACHINE_H_
+#define STATEMACHINE_H_
+
+//*****************************************************************************
+//
+// stateMachine - Table driven hierarchical state machine fed by a single
+//                event queue. ISRs, timers and tasks post events; only the
+//                task that owns the machine dispatches them, so the state is
+//                never changed from two contexts. A state with no row for an
+//                event passes it to its parent state. Every transition is
+//                logged with the time it happened and the time since its
+//                event was posted.
+//
+//                The queue is held in the machine, the caller gives the
+//                time and the owner guards the queue, so a machine needs no
+//                RTOS objects and there can be one per helicopter context.
+//                Every state function, guard and action is passed the
+//                machine's owner.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+//*****************************************************************************
+// Constants
+//*****************************************************************************
+#define SM_EV_TICK          0       // Dispatched by smTick, never queued
+#define SM_NO_PARENT        0xFF
+#define SM_LOG_LENGTH       16      // Transitions kept, must be a power of 2
+#define SM_QUEUE_LENGTH     4       // Events that can wait, must be a power of 2
+
+// *******************************************************
+// A state. during runs on every SM_EV_TICK before its transitions are tried.
+typedef struct {
+    const char *name;
+    uint8_t parent;
+    void (*entry)(void *owner);
+    void (*during)(void *owner);
+} smState_t;
+
+// *******************************************************
+// One row of the transition table. The first row whose state, event and
+// guard match is taken; guard and action may be NULL.
+typedef struct {
+    uint8_t state;
+    uint8_t event;
+    bool (*guard)(void *owner);
+    void (*action)(void *owner);
+    uint8_t next;
+} smTransition_t;
+
+// *******************************************************
+// A queued event, stamped when it is posted
+typedef struct {
+    uint8_t event;
+    TickType_t posted;
+} smEvent_t;
+
+// *******************************************************
+// One logged transition. latency is in ms from posting to the transition.
+typedef struct {
+    TickType_t time;
+    uint8_t from;
+    uint8_t to;
+    uint8_t event;
+    uint16_t latency;
+} smLogEntry_t;
+
+typedef struct {
+    const smState_t *states;
+    const smTransition_t *table;
+    uint8_t numTransitions;
+    uint8_t current;
+    void *owner;
+    void (*onTransition)(void *owner, const smLogEntry_t *entry);
+    void (*lock)(void *owner);          // Guard the queue, NULL if only
+    void (*unlock)(void *owner);        // one thread posts and runs
+    smEvent_t queue[SM_QUEUE_LENGTH];
+    uint32_t numPosted;                 // Events posted and taken, since init
+    uint32_t numTaken;
+    smLogEntry_t log[SM_LOG_LENGTH];
+    uint32_t numLogged;
+    uint16_t maxLatency;
+} stateMachine_t;
+
+
+// *******************************************************
+// smInit:              Empties the event queue and enters the initial state
+// TAKES:               sm, the machine
+//                      states, table, numTransitions, the state and
+//                      transition tables
+//                      initial, the starting state
+//                      owner, passed to every state function, guard, action
+//                      and onTransition
+//                      onTransition, called after each transition, or NULL
+void
+smInit (stateMachine_t *sm, const smState_t *states, const smTransition_t *table,
+        uint8_t numTransitions, uint8_t initial, void *owner,
+        void (*onTransition)(void *owner, const smLogEntry_t *entry));
+
+
+// *******************************************************
+// smSetLock:           Sets how the queue is guarded against posts from the
+//                      owner's other tasks, timers and interrupts. A machine
+//                      starts with none, for one only a single thread posts
+//                      to and runs.
+// TAKES:               lock, unlock, called with the owner around each use
+//                      of the queue, not nested
+void
+smSetLock (stateMachine_t *sm, void (*lock)(void *owner),
+           void (*unlock)(void *owner));
+
+// *******************************************************
+// smPost:              Queues an event from a task or timer callback
+// TAKES:               posted, the time now, for the transition latency
+// RETURNS:             false if the queue was full
+bool
+smPost (stateMachine_t *sm, uint8_t event, TickType_t posted);
+
+
+// *******************************************************
+// smPostFromISR:       Queues an event from an interrupt handler, under the
+//                      RTOS's interrupt mask rather than the machine's lock
+// TAKES:               posted, the time now, for the transition latency
+// RETURNS:             false if the queue was full
+bool
+smPostFromISR (stateMachine_t *sm, uint8_t event, TickType_t posted);
+
+
+// *******************************************************
+// smRun:               Dispatches every queued event, oldest first. Only the
+//                      owning task may call this.
+// TAKES:               now, the time, for the log
+void
+smRun (stateMachine_t *sm, TickType_t now);
+
+
+// *******************************************************
+// smTick:              Runs the during function of the current state and
+//                      its parents, then dispatches SM_EV_TICK so guarded
+//                      transitions are tried
+// TAKES:               now, the time, for the log
+void
+smTick (stateMachine_t *sm, TickType_t now);
+
+
+// *******************************************************
+// smIn:                RETURNS true if the machine is in state, or in a
+//                      state nested inside it
+bool
+smIn (const stateMachine_t *sm, uint8_t state);
+
+
+// *******************************************************
+// smLogEntry:          RETURNS the n'th most recent transition (0 is the
+//                      latest), or NULL if there is none
+const smLogEntry_t *
+smLogEntry (const stateMachine_t *sm, uint32_t n);
+
+#endif /* STATEMACHINE_H_ */
@@ -35,7 +35,32 @@ SECTIONS
     .pinit  :   > FLASH
     .init_array : > FLASH
 
+    /* Only filled by IntRegister, so empty unless STATIC_VECTORS is 0     */
     .vtable :   > 0x20000000
+
+    /* Code run from SRAM: RAMFUNC functions plus the FreeRTOS tick and    */
+    /* context switch. Loaded in flash and copied across by ResetISR.      */
+    /* Off unless linked with --define=RAMFUNC_ENABLE=1, see ramfunc.h.     */
+#if defined(RAMFUNC_ENABLE) && RAMFUNC_ENABLE
+    .ramfunc : {
+        *(.ramfunc)
+        portasm.obj(.text)
+        port.obj(.text:xPortSysTickHandler)
+        tasks.obj(.text:vTaskSwitchContext)
+        tasks.obj(.text:xTaskIncrementTick)
+    } load = FLASH, run = SRAM, palign(4),
+      LOAD_START(__ramfunc_load_start),
+      RUN_START(__ramfunc_run_start),
+      SIZE(__ramfunc_size)
+#else
+    .ramfunc : {
+        *(.ramfunc)
+    } load = FLASH, run = SRAM, palign(4),
+      LOAD_START(__ramfunc_load_start),
+      RUN_START(__ramfunc_run_start),
+      SIZE(__ramfunc_size)
+#endif
+
     .data   :   > SRAM
     .bss    :   > SRAM
     .sysmem :   > SRAM
@@ -24,6 +24,9 @@
 
 #include <stdint.h>
 
+#include "vectors.h"
+#include "altitude.h"       // ADC_SEQUENCE
+
 // FreeRTOS handlers
 extern void xPortPendSVHandler(void);
 extern void vPortSVCHandler(void);
@@ -54,12 +57,43 @@ extern void _c_int00(void);
 //*****************************************************************************
 extern uint32_t __STACK_TOP;
 
+//*****************************************************************************
+//
+// Linker symbols for the .ramfunc section (see ramfunc.h), which is loaded in
+// flash and copied to SRAM to run.
+//
+//*****************************************************************************
+extern uint32_t __ramfunc_load_start;
+extern uint32_t __ramfunc_run_start;
+extern uint32_t __ramfunc_size;
+
 //*****************************************************************************
 //
 // External declarations for the interrupt handlers used by the application.
+// Unless STATIC_VECTORS is 0 they are wired into the table below; otherwise
+// the modules install them with IntRegister and the table keeps defaults.
 //
 //*****************************************************************************
-// To be added by user
+extern void ButtonIntHandler(void);
+extern void YawIntHandler(void);
+extern void YawRefIntHandler(void);
+extern void UARTIntHandler(void);
+extern void ADCIntHandler(void);
+extern void WatchdogIntHandler(void);
+
+#if STATIC_VECTORS
+#define VECTOR(handler)     handler
+#else
+#define VECTOR(handler)     IntDefaultHandler
+#endif
+
+#if ADC_SEQUENCE == 0
+#define ADC_SS0_VECTOR      VECTOR(ADCIntHandler)
+#define ADC_SS3_VECTOR      IntDefaultHandler
+#else
+#define ADC_SS0_VECTOR      IntDefaultHandler
+#define ADC_SS3_VECTOR      VECTOR(ADCIntHandler)
+#endif
 
 //*****************************************************************************
 //
@@ -88,12 +122,12 @@ void (* const g_pfnVectors[])(void) =
     0,                                      // Reserved
     xPortPendSVHandler,                     // The PendSV handler
     xPortSysTickHandler,                    // The SysTick handler
-    IntDefaultHandler,                      // GPIO Port A
-    IntDefaultHandler,                      // GPIO Port B
-    IntDefaultHandler,                      // GPIO Port C
-    IntDefaultHandler,                      // GPIO Port D
-    IntDefaultHandler,                      // GPIO Port E
-    IntDefaultHandler,                      // UART0 Rx and Tx
+    VECTOR(ButtonIntHandler),               // GPIO Port A
+    VECTOR(YawIntHandler),                  // GPIO Port B
+    VECTOR(YawRefIntHandler),               // GPIO Port C
+    VECTOR(ButtonIntHandler),               // GPIO Port D
+    VECTOR(ButtonIntHandler),               // GPIO Port E
+    VECTOR(UARTIntHandler),                 // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
     IntDefaultHandler,                      // I2C0 Master and Slave
@@ -102,11 +136,11 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // PWM Generator 1
     IntDefaultHandler,                      // PWM Generator 2
     IntDefaultHandler,                      // Quadrature Encoder 0
-    IntDefaultHandler,                      // ADC Sequence 0
+    ADC_SS0_VECTOR,                         // ADC Sequence 0
     IntDefaultHandler,                      // ADC Sequence 1
     IntDefaultHandler,                      // ADC Sequence 2
-    IntDefaultHandler,                      // ADC Sequence 3
-    IntDefaultHandler,                      // Watchdog timer
+    ADC_SS3_VECTOR,                         // ADC Sequence 3
+    VECTOR(WatchdogIntHandler),             // Watchdog timer
     IntDefaultHandler,                      // Timer 0 subtimer A
     IntDefaultHandler,                      // Timer 0 subtimer B
     IntDefaultHandler,                      // Timer 1 subtimer A
@@ -118,7 +152,7 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Analog Comparator 2
     IntDefaultHandler,                      // System Control (PLL, OSC, BO)
     IntDefaultHandler,                      // FLASH Control
-    IntDefaultHandler,                      // GPIO Port F
+    VECTOR(ButtonIntHandler),               // GPIO Port F
     IntDefaultHandler,                      // GPIO Port G
     IntDefaultHandler,                      // GPIO Port H
     IntDefaultHandler,                      // UART2 Rx and Tx
@@ -243,6 +277,18 @@ void (* const g_pfnVectors[])(void) =
 void
 ResetISR(void)
 {
+    uint32_t *pui32Src = &__ramfunc_load_start;
+    uint32_t *pui32Dest = &__ramfunc_run_start;
+    uint32_t ui32Words = ((uint32_t)&__ramfunc_size + 3) / 4;
+
+    //
+    // Copy the functions that run from SRAM before anything can call them.
+    //
+    while(ui32Words--)
+    {
+        *pui32Dest++ = *pui32Src++;
+    }
+
     //
     // Jump to the CCS C initialization routine.  This will enable the
     // floating-point unit as well, so that does not need to be done here.
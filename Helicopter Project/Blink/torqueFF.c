@@ -0,0 +1,141 @@
+//*****************************************************************************
+//
+// torqueFF - Main rotor to tail rotor torque feedforward. The tail duty that
+//            cancels the main rotor's reaction torque is looked up from the
+//            main duty in a table, so altitude changes no longer kick yaw.
+//            The table is refined in flight: during steady hover whatever
+//            the yaw integrator holds is moved into the table entries either
+//            side of the current main duty.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "torqueFF.h"
+#include "heliContext.h"
+
+// Starting table: reaction torque roughly proportional to main duty, through
+// the old fixed tail offset of 35% at the 45% hover duty
+static const int32_t torqueFFDefault[TORQUE_FF_POINTS] = {
+    0, 78, 156, 233, 311, 389, 467, 544, 622, 700, 778
+};
+
+
+// *******************************************************
+// findSegment:         Finds the table entry below a main duty and how far
+//                      the duty is towards the next entry
+static void findSegment(int32_t mainPermille, uint32_t *index, int32_t *frac)
+{
+    if (mainPermille < 0)
+    {
+        mainPermille = 0;
+    } else if (mainPermille > (TORQUE_FF_POINTS - 1) * TORQUE_FF_STEP) {
+        mainPermille = (TORQUE_FF_POINTS - 1) * TORQUE_FF_STEP;
+    }
+
+    *index = mainPermille / TORQUE_FF_STEP;
+    if (*index >= TORQUE_FF_POINTS - 1)
+    {
+        *index = TORQUE_FF_POINTS - 2;
+    }
+    *frac = mainPermille - *index * TORQUE_FF_STEP;
+}
+
+
+// *******************************************************
+// clampEntry:          Keeps a learnt entry within the usable tail duty
+static int32_t clampEntry(int32_t value)
+{
+    if (value < 0)
+    {
+        return 0;
+    }
+    if (value > TORQUE_FF_MAX)
+    {
+        return TORQUE_FF_MAX;
+    }
+    return value;
+}
+
+
+// *******************************************************
+// initTorqueFF:        Loads the default table of g_heli
+void initTorqueFF (void)
+{
+    torqueFFReset(&g_heli.torque);
+}
+
+
+// *******************************************************
+// torqueFFReset:       Loads the default table
+void torqueFFReset (torqueFF_t *ff)
+{
+    uint32_t i;
+
+    for (i = 0; i < TORQUE_FF_POINTS; i++)
+    {
+        ff->table[i] = torqueFFDefault[i];
+    }
+}
+
+
+// *******************************************************
+// torqueFF:            RETURNS the tail duty in per-mille that balances the
+//                      main rotor torque at the given main duty
+// TAKES:               mainPermille, the main rotor duty in per-mille
+int32_t torqueFF (const torqueFF_t *ff, int32_t mainPermille)
+{
+    uint32_t index;
+    int32_t frac;
+
+    findSegment(mainPermille, &index, &frac);
+    return ff->table[index] +
+           (ff->table[index + 1] - ff->table[index]) * frac / TORQUE_FF_STEP;
+}
+
+
+// *******************************************************
+// torqueFFLearn:       Moves part of the yaw integrator's tail duty into the
+//                      table at the given main duty. Only call during steady
+//                      hover.
+// TAKES:               mainPermille, the main rotor duty in per-mille
+//                      integralPermille, the integrator's tail duty in per-mille
+// RETURNS:             The change in torqueFF(mainPermille), which the caller
+//                      takes off its integrator so the output does not jump
+int32_t torqueFFLearn (torqueFF_t *ff, int32_t mainPermille, int32_t integralPermille)
+{
+    int32_t before = torqueFF(ff, mainPermille);
+    int32_t delta = integralPermille / (1 << TORQUE_FF_LEARN_SHIFT);
+    uint32_t index;
+    int32_t frac;
+
+    // Each neighbouring entry learns in proportion to how close it is
+    findSegment(mainPermille, &index, &frac);
+    ff->table[index] = clampEntry(ff->table[index] +
+                       delta * (TORQUE_FF_STEP - frac) / TORQUE_FF_STEP);
+    ff->table[index + 1] = clampEntry(ff->table[index + 1] +
+                           delta * frac / TORQUE_FF_STEP);
+
+    return torqueFF(ff, mainPermille) - before;
+}
+
+
+// *******************************************************
+// torqueFFEntry:       RETURNS a table entry, for reporting learnt values
+// TAKES:               index, 0 to TORQUE_FF_POINTS - 1
+int32_t torqueFFEntry (const torqueFF_t *ff, uint32_t index)
+{
+    if (index >= TORQUE_FF_POINTS)
+    {
+        return 0;
+    }
+    return ff->table[index];
+}
+
+
+// *******************************************************
+// getTorqueFFEntry:    torqueFFEntry of g_heli
+int32_t getTorqueFFEntry (uint32_t index)
+{
+    return torqueFFEntry(&g_heli.torque, index);
+}
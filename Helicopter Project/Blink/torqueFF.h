@@ -0,0 +1,78 @@
+#ifndef TORQUEFF_H_
+#define TORQUEFF_H_
+
+//*****************************************************************************
+//
+// torqueFF - Main rotor to tail rotor torque feedforward. The tail duty that
+//            cancels the main rotor's reaction torque is looked up from the
+//            main duty in a table, so altitude changes no longer kick yaw.
+//            The table is refined in flight: during steady hover whatever
+//            the yaw integrator holds is moved into the table entries either
+//            side of the current main duty. The table lives in RAM; a "TF"
+//            line on the UART has the display task send it, so learnt
+//            values can be copied into the defaults.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Constants, duties in per-mille
+//*****************************************************************************
+#define TORQUE_FF_POINTS        11      // Table entries, main duty 0 to 1000
+#define TORQUE_FF_STEP          100     // Main duty between entries
+#define TORQUE_FF_LEARN_SHIFT   3       // Learn 1/8 of the integrator per cycle
+#define TORQUE_FF_MAX           900     // Largest feedforward tail duty
+
+// *******************************************************
+// One helicopter's table, see heliContext.h
+typedef struct {
+    int32_t table[TORQUE_FF_POINTS];
+} torqueFF_t;
+
+
+// *******************************************************
+// initTorqueFF:        Loads the default table of g_heli
+void
+initTorqueFF (void);
+
+
+// *******************************************************
+// torqueFFReset:       Loads the default table
+void
+torqueFFReset (torqueFF_t *ff);
+
+
+// *******************************************************
+// torqueFF:            RETURNS the tail duty in per-mille that balances the
+//                      main rotor torque at the given main duty
+// TAKES:               mainPermille, the main rotor duty in per-mille
+int32_t
+torqueFF (const torqueFF_t *ff, int32_t mainPermille);
+
+
+// *******************************************************
+// torqueFFLearn:       Moves part of the yaw integrator's tail duty into the
+//                      table at the given main duty. Only call during steady
+//                      hover.
+// TAKES:               mainPermille, the main rotor duty in per-mille
+//                      integralPermille, the integrator's tail duty in per-mille
+// RETURNS:             The change in torqueFF(mainPermille), which the caller
+//                      takes off its integrator so the output does not jump
+int32_t
+torqueFFLearn (torqueFF_t *ff, int32_t mainPermille, int32_t integralPermille);
+
+
+// *******************************************************
+// torqueFFEntry:       RETURNS a table entry, for reporting learnt values
+// TAKES:               index, 0 to TORQUE_FF_POINTS - 1
+int32_t
+torqueFFEntry (const torqueFF_t *ff, uint32_t index);
+
+
+// *******************************************************
+// getTorqueFFEntry:    torqueFFEntry of g_heli
+int32_t
+getTorqueFFEntry (uint32_t index);
+
+#endif /* TORQUEFF_H_ */
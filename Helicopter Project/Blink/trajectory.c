@@ -0,0 +1,143 @@
+//*****************************************************************************
+//
+// trajectory - Jerk limited reference trajectories. A step in a setpoint
+//              becomes a smooth profile: acceleration ramps at no more than
+//              the jerk limit, velocity and acceleration stay within their
+//              limits, and braking starts early enough that the profile
+//              stops on the target without passing it. All in fixed point,
+//              in the units of the axis (0.01% or 0.01 degree).
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "trajectory.h"
+
+
+// *******************************************************
+// isqrt:               RETURNS the integer square root of x, rounded down
+static uint32_t isqrt(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+
+// *******************************************************
+// limit:               RETURNS x clamped to +-max
+static int32_t limit(int64_t x, int32_t max)
+{
+    if (x > max)
+    {
+        return max;
+    }
+    if (x < -max)
+    {
+        return -max;
+    }
+    return (int32_t)x;
+}
+
+
+// *******************************************************
+// trajectoryInit:      Sets the limits of an axis and puts it at rest at 0
+void trajectoryInit (trajectory_t *traj, int32_t maxVel, int32_t maxAcc,
+                     int32_t maxJerk)
+{
+    traj->maxVel = maxVel;
+    traj->maxAcc = maxAcc;
+    traj->maxJerk = maxJerk;
+    trajectoryReset(traj, 0);
+}
+
+
+// *******************************************************
+// trajectoryReset:     Puts the profile at rest at a position, which also
+//                      becomes the target
+void trajectoryReset (trajectory_t *traj, int32_t pos)
+{
+    traj->target = pos;
+    traj->pos = pos;
+    traj->vel = 0;
+    traj->acc = 0;
+}
+
+
+// *******************************************************
+// trajectorySetTarget: Sets where the profile is heading. The target can be
+//                      changed at any time, including mid move.
+void trajectorySetTarget (trajectory_t *traj, int32_t target)
+{
+    traj->target = target;
+}
+
+
+// *******************************************************
+// trajectoryStep:      Advances the profile by one control tick
+// TAKES:               elapsedMs, the length of the tick
+void trajectoryStep (trajectory_t *traj, uint32_t elapsedMs)
+{
+    int32_t error = traj->target - traj->pos;
+    int32_t dist = (error < 0) ? -error : error;
+    int32_t speed = (traj->vel < 0) ? -traj->vel : traj->vel;
+    int64_t lead, brake;
+    int32_t velWanted, accWanted, step;
+
+    if (elapsedMs == 0)
+    {
+        return;
+    }
+    if (error == 0 && traj->vel == 0)
+    {
+        traj->acc = 0;
+        return;
+    }
+
+    // Fastest speed that can still stop on the target: the distance left
+    // after the acceleration has ramped to full braking, covered at full
+    // deceleration
+    lead = (int64_t)speed * traj->maxAcc / (2 * traj->maxJerk);
+    brake = (dist > lead) ? dist - lead : 0;
+    velWanted = isqrt(2 * (uint64_t)traj->maxAcc * brake);
+    if (velWanted > traj->maxVel)
+    {
+        velWanted = traj->maxVel;
+    }
+    if (error < 0)
+    {
+        velWanted = -velWanted;
+    }
+
+    // Acceleration towards that speed, limited, reached at the jerk limit
+    accWanted = limit((int64_t)(velWanted - traj->vel) * 1000 / elapsedMs,
+                      traj->maxAcc);
+    traj->acc += limit(accWanted - traj->acc,
+                       (int64_t)traj->maxJerk * elapsedMs / 1000);
+    traj->vel = limit(traj->vel + (int64_t)traj->acc * elapsedMs / 1000,
+                      traj->maxVel);
+
+    // Stop on the target rather than pass it
+    step = (int64_t)traj->vel * elapsedMs / 1000;
+    if ((error > 0 && step >= error) || (error < 0 && step <= error))
+    {
+        trajectoryReset(traj, traj->target);
+    } else {
+        traj->pos += step;
+    }
+}
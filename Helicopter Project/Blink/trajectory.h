@@ -0,0 +1,67 @@
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+//*****************************************************************************
+//
+// trajectory - Jerk limited reference trajectories. A step in a setpoint
+//              becomes a smooth profile: acceleration ramps at no more than
+//              the jerk limit, velocity and acceleration stay within their
+//              limits, and braking starts early enough that the profile
+//              stops on the target without passing it. All in fixed point,
+//              in the units of the axis (0.01% or 0.01 degree).
+//*****************************************************************************
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Limits of the controller's reference trajectories, in 0.01% or 0.01 degree
+// per second (squared, cubed)
+//*****************************************************************************
+#define ALT_TRAJ_VEL        4000    // 40%/s
+#define ALT_TRAJ_ACC        8000
+#define ALT_TRAJ_JERK       40000
+#define YAW_TRAJ_VEL        9000    // 90 degrees/s
+#define YAW_TRAJ_ACC        18000
+#define YAW_TRAJ_JERK       90000
+
+// *******************************************************
+// One axis. Rates are in units per second (squared, cubed).
+typedef struct {
+    int32_t target;         // Where the profile is heading
+    int32_t pos;            // Reference for the controller
+    int32_t vel;            // Reference velocity, for feedforward
+    int32_t acc;
+    int32_t maxVel;
+    int32_t maxAcc;
+    int32_t maxJerk;
+} trajectory_t;
+
+
+// *******************************************************
+// trajectoryInit:      Sets the limits of an axis and puts it at rest at 0
+void
+trajectoryInit (trajectory_t *traj, int32_t maxVel, int32_t maxAcc,
+                int32_t maxJerk);
+
+
+// *******************************************************
+// trajectoryReset:     Puts the profile at rest at a position, which also
+//                      becomes the target
+void
+trajectoryReset (trajectory_t *traj, int32_t pos);
+
+
+// *******************************************************
+// trajectorySetTarget: Sets where the profile is heading. The target can be
+//                      changed at any time, including mid move.
+void
+trajectorySetTarget (trajectory_t *traj, int32_t target);
+
+
+// *******************************************************
+// trajectoryStep:      Advances the profile by one control tick
+// TAKES:               elapsedMs, the length of the tick
+void
+trajectoryStep (trajectory_t *traj, uint32_t elapsedMs);
+
+#endif /* TRAJECTORY_H_ */
@@ -8,7 +8,17 @@
 // Last modified:   16.4.2018
 //
 
+#include <string.h>
+
 #include "uart.h"
+#include "driverlib/interrupt.h"
+#include "vectors.h"
+
+static char rxLine[UART_RX_MAX + 1];
+static volatile uint32_t rxLength = 0;
+static volatile bool rxReady = false;     //A whole line is waiting to be taken
+static bool rxOverflow = false;           //Dropping the rest of a long line
+
 
 //********************************************************
 // initialiseUSB_UART - 8 bits, 1 stop bit, no parity
@@ -33,6 +43,48 @@ initialiseUSB_UART (void)
             UART_CONFIG_PAR_NONE);
     UARTFIFOEnable(UART_USB_BASE);
     UARTEnable(UART_USB_BASE);
+
+    // Received lines are assembled in the receive interrupt
+    VECTOR_REGISTER(INT_UART0, UARTIntHandler);
+    UARTIntEnable(UART_USB_BASE, UART_INT_RX | UART_INT_RT);
+}
+
+
+//********************************************************
+// UARTIntHandler - Moves received characters into the line buffer. At 9600
+// baud the FIFO would overflow between polls of a slow task.
+//********************************************************
+void
+UARTIntHandler (void)
+{
+    int32_t c;
+
+    UARTIntClear(UART_USB_BASE, UARTIntStatus(UART_USB_BASE, true));
+
+    while (UARTCharsAvail(UART_USB_BASE))
+    {
+        c = UARTCharGetNonBlocking(UART_USB_BASE);
+        if (rxReady)
+        {
+            continue;                   //Previous line not taken yet
+        }
+        if (c == '\r' || c == '\n')
+        {
+            if (rxLength > 0 && !rxOverflow)
+            {
+                rxLine[rxLength] = '\0';
+                rxReady = true;
+            } else {
+                rxLength = 0;
+            }
+            rxOverflow = false;
+        } else if (rxLength < UART_RX_MAX) {
+            rxLine[rxLength++] = c;
+        } else {
+            rxOverflow = true;
+            rxLength = 0;
+        }
+    }
 }
 
 
@@ -52,3 +104,27 @@ UARTSend (char *pucBuffer)
 }
 
 
+
+
+//********************************************************
+// UARTGetLine - Takes the last complete line received, without its line
+// ending. Lines longer than UART_RX_MAX, or than the buffer, are dropped.
+// Reception of the next line starts once this one is taken.
+//********************************************************
+bool
+UARTGetLine (char *pcBuffer, uint32_t ui32Size)
+{
+    bool fits = rxLength < ui32Size;
+
+    if (!rxReady)
+    {
+        return false;
+    }
+    if (fits)
+    {
+        memcpy(pcBuffer, rxLine, rxLength + 1);
+    }
+    rxLength = 0;
+    rxReady = false;
+    return fits;
+}
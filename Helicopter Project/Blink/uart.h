@@ -32,6 +32,7 @@
 #define SYSTICK_RATE_HZ 100
 #define SLOWTICK_RATE_HZ 4
 #define MAX_STR_LEN 50 //used to be 16
+#define UART_RX_MAX 320 //Longest line received, a manoeuvre upload
 //---USB Serial comms: UART0, Rx:PA0 , Tx:PA1
 #define BAUD_RATE 9600
 #define UART_USB_BASE           UART0_BASE
@@ -53,4 +54,20 @@ void
 UARTSend (char *pucBuffer);
 
 
+//********************************************************
+// UARTIntHandler - Receive interrupt, assembles lines for UARTGetLine
+//********************************************************
+void
+UARTIntHandler (void);
+
+
+//********************************************************
+// UARTGetLine - Takes the last complete line received, without its line
+// ending. Lines longer than UART_RX_MAX, or than the buffer, are dropped.
+// Reception of the next line starts once this one is taken.
+//********************************************************
+bool
+UARTGetLine (char *pcBuffer, uint32_t ui32Size);
+
+
 #endif /* UART_H_ */
@@ -0,0 +1,50 @@
+#ifndef VECTORS_H_
+#define VECTORS_H_
+
+//*****************************************************************************
+//
+// vectors - Interrupt handler wiring. By default the application's handlers
+//           are entries in the flash vector table g_pfnVectors, so nothing
+//           is copied to RAM or relocated at run time and registering a
+//           handler only enables its NVIC line. Build with STATIC_VECTORS=0
+//           to install them with IntRegister instead, which moves the table
+//           into the 1 KB .vtable in SRAM on first use.
+//*****************************************************************************
+
+#include <stdint.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/debug.h"
+
+#ifndef STATIC_VECTORS
+#ifdef HOST_BUILD
+#define STATIC_VECTORS      0       // The host routes interrupts through IntRegister
+#else
+#define STATIC_VECTORS      1
+#endif
+#endif
+
+// *******************************************************
+// The flash vector table, in tm4c123gh6pm_startup_ccs.c
+extern void (* const g_pfnVectors[])(void);
+
+// *******************************************************
+// VECTOR_REGISTER:     Installs handler for interrupt (an INT_ number) and
+//                      enables it. With static vectors a debug build checks
+//                      the handler is the one wired into g_pfnVectors.
+#if STATIC_VECTORS
+#define VECTOR_REGISTER(interrupt, handler)                     \
+    do {                                                        \
+        ASSERT(g_pfnVectors[interrupt] == (handler));           \
+        IntEnable(interrupt);                                   \
+    } while (0)
+#else
+#define VECTOR_REGISTER(interrupt, handler)                     \
+    do {                                                        \
+        IntRegister(interrupt, handler);                        \
+        IntEnable(interrupt);                                   \
+    } while (0)
+#endif
+
+#endif /* VECTORS_H_ */
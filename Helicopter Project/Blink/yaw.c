@@ -12,6 +12,7 @@
 #define TOTAL_ANGLE             360
 #define FIND_REF_MAIN           30 //duty cycle for finding the reference point
 #define FIND_REF_TAIL           40
+#define YAW_RECIP               FIXED_RECIP(TOTAL_ANGLE * FIXED_SCALE, NUM_SLOTS)
 
 //#include "inc/tm4c123gh6pm.h"
 #include <stdint.h>
@@ -27,6 +28,13 @@
 //#include "control.h"
 //#include "motor.h"
 #include "yaw.h"
+#include "blackBox.h"
+#include "fixedPoint.h"
+#include "perf.h"
+#include "ramfunc.h"
+#include "vectors.h"
+#include "fastIO.h"
+#include "heliContext.h"
 
 
 #include "FreeRTOS.h"
@@ -36,62 +44,141 @@
 
 // Sets quadrature encoding states A, B, C, D
 enum quad {A = 0, B = 1, C = 3, D = 2};
-enum quad State;
-enum quad nextState;
-
-//Sets the slot number, the number of slots moved around the disc.
-int32_t slot;
 
 extern int32_t degrees = 0;
 
 
 // *******************************************************
-// getYaw:          Uses the current slot number on the disk to
-//                  return an angle in degrees from the original reference point.
-// RETURNS:         Angle value between -180 < Yaw < 180 degrees.
-int32_t getYaw(void) {
-    int32_t angle = 0;
-    int32_t refnum = slot;
+// heliInitYaw:     Starts the count at slot 0 in state A, zeroed there
+void heliInitYaw (HeliContext *heli)
+{
+    heli->yaw.slot = 0;
+    heli->yaw.State = A;
+    heliResetYaw(heli);
+}
+
+
+// *******************************************************
+// getYawHundredths: Uses the current slot number on the disk to
+//                  return an angle from the original reference point.
+// RETURNS:         Angle between -180 and 180 degrees, FIXED_SCALE per degree
+int32_t heliGetYawHundredths(const HeliContext *heli)
+{
+    int32_t refnum = heli->yaw.slot - heli->yaw.zeroSlot;
+
     while (refnum > (NUM_SLOTS / 2)) {
         refnum -= NUM_SLOTS;
     }
     while (refnum < (-NUM_SLOTS / 2)) {
         refnum += NUM_SLOTS;
     }
+
 //  Slots converted into an angle and returned as an angle.
-    angle = TOTAL_ANGLE * refnum / NUM_SLOTS;
-    return angle;
+    return FIXED_MUL(refnum, YAW_RECIP);
 }
 
-int32_t getYawTotal(void)
+int32_t getYawHundredths(void)
 {
-    int32_t angle = 0;
-    int32_t refnum = slot;
+    return heliGetYawHundredths(&g_heli);
+}
 
-    angle = (2* (TOTAL_ANGLE * refnum)  + NUM_SLOTS) / 2 / NUM_SLOTS;
 
-    return angle;
+// *******************************************************
+// getYawTotalHundredths: RETURNS the total angle turned from the reference
+//                  point, without wrapping, FIXED_SCALE per degree
+int32_t heliGetYawTotalHundredths(const HeliContext *heli)
+{
+    return FIXED_MUL(heli->yaw.slot - heli->yaw.zeroSlot, YAW_RECIP);
+}
+
+int32_t getYawTotalHundredths(void)
+{
+    return heliGetYawTotalHundredths(&g_heli);
+}
+
+
+// *******************************************************
+// getYaw:          RETURNS the angle in whole degrees, -180 < Yaw < 180,
+//                  truncated towards zero
+int32_t heliGetYaw(const HeliContext *heli)
+{
+    return FIXED_WHOLE(heliGetYawHundredths(heli));
+}
+
+int32_t getYaw(void) {
+    return heliGetYaw(&g_heli);
+}
+
+
+// *******************************************************
+// getYawTotal:     RETURNS the total angle in whole degrees, rounded to
+//                  the nearest degree
+int32_t heliGetYawTotal(const HeliContext *heli)
+{
+    int32_t angle = heliGetYawTotalHundredths(heli);
+
+    if (angle < 0)
+    {
+        return FIXED_WHOLE(angle - FIXED_SCALE / 2);
+    }
+    return FIXED_WHOLE(angle + FIXED_SCALE / 2);
+}
+
+int32_t getYawTotal(void)
+{
+    return heliGetYawTotal(&g_heli);
 }
 
+
 // *******************************************************
-// resetYaw:        Resets the slot number to 0
+// resetYaw:        Makes the current position the zero of yaw
+void heliResetYaw (HeliContext *heli)
+{
+    heli->yaw.zeroSlot = heli->yaw.slot;
+}
+
 void resetYaw (void) {
-    slot = 0;
+    heliResetYaw(&g_heli);
 }
 
 
 // *******************************************************
-//  YawIntHandler:  Interrupt handler for the yaw interrupt.
-//                  Measures Phasse A and Phase B.
+// resetYawAt:      Makes an earlier position, captured with yawSlot, the
+//                  zero of yaw
+void heliResetYawAt (HeliContext *heli, int32_t captured)
+{
+    heli->yaw.zeroSlot = captured;
+}
+
+void resetYawAt (int32_t captured)
+{
+    heliResetYawAt(&g_heli, captured);
+}
+
+
+// *******************************************************
+// yawSlot:         RETURNS the raw slot count, for an ISR to capture
+int32_t heliYawSlot (const HeliContext *heli)
+{
+    return heli->yaw.slot;
+}
+
+int32_t yawSlot (void)
+{
+    return heliYawSlot(&g_heli);
+}
+
+
+// *******************************************************
+//  heliYawEdge:    Decodes an edge of Phase A or Phase B.
 //                  If moving clockwise, add 1 to slot
 //                  If moving anti-clockwise, minus 1 to slot
-void YawIntHandler (void) {
-    //Clear the interrupt bits
-    GPIOIntClear(GPIO_PORTB_BASE, GPIO_INT_PIN_0 | GPIO_INT_PIN_1);
+RAMFUNC void heliYawEdge (HeliContext *heli, uint32_t pins)
+{
+    int32_t slot = heli->yaw.slot;
+    enum quad nextState = (enum quad)pins;
 
-//  Sets nextState based off status of Pin 0 & 1
-    nextState = (enum quad)GPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-    switch(State)
+    switch((enum quad)heli->yaw.State)
     {
     case A:
         //In case A, can move to B or D.
@@ -150,7 +237,24 @@ void YawIntHandler (void) {
         break;
     }
     }
-    State = nextState;
+    heli->yaw.slot = slot;
+    heli->yaw.State = nextState;
+}
+
+
+// *******************************************************
+//  YawIntHandler:  Interrupt handler for the yaw interrupt.
+//                  Measures Phasse A and Phase B.
+RAMFUNC void YawIntHandler (void) {
+    uint32_t start = PERF_CYCLES();
+
+    //Clear the interrupt bits
+    fastGPIOIntClear(GPIO_PORTB_BASE, GPIO_INT_PIN_0 | GPIO_INT_PIN_1);
+
+//  Decodes the status of Pin 0 & 1
+    heliYawEdge(&g_heli, fastGPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1));
+    blackBoxYawEdge(g_heli.yaw.slot - g_heli.yaw.zeroSlot, g_heli.yaw.State);
+    perfRecord(PERF_YAW_ISR, PERF_CYCLES() - start);
 }
 
 // *******************************************************
@@ -167,10 +271,9 @@ void initYaw (void)
     GPIOPadConfigSet(GPIO_PORTB_BASE, GPIO_PIN_0|GPIO_PIN_1, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD);
     GPIOIntTypeSet(GPIO_PORTB_BASE, GPIO_PIN_0|GPIO_PIN_1, GPIO_BOTH_EDGES); //Trigger interrupts on both edges of wave changes on PB0 and PB1
     GPIOIntEnable(GPIO_PORTB_BASE, GPIO_INT_PIN_0 | GPIO_INT_PIN_1); //Enable interrupts from PB0 and PB1
-    GPIOIntRegister(GPIO_PORTB_BASE, YawIntHandler); //If interrupt occurs, run YawIntHandler
-    IntEnable(INT_GPIOB); //Enable interrupts on B.
+    VECTOR_REGISTER(INT_GPIOB, YawIntHandler); //If interrupt occurs, run YawIntHandler
 
-    resetYaw();
+    heliInitYaw(&g_heli);
 }
 
 
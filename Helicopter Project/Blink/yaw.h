@@ -12,26 +12,68 @@
 // Last modified:   23.4.2019
 //*****************************************************************************
 
+#include <stdint.h>
 
+// *******************************************************
+// One helicopter's yaw, see heliContext.h
+typedef struct {
+    int32_t slot;           // Slots moved around the disc
+    int32_t zeroSlot;       // The slot at the reference. Only the control
+                            // task writes it, so the ISR never has to share
+                            // a read-modify-write of slot.
+    uint8_t State;          // Quadrature state at the last edge
+} yaw_t;
+
+
+
+// *******************************************************
+// getYawHundredths: Uses the current slot number on the disk to
+//                  return an angle from the original reference point.
+// RETURNS:         Angle between -180 and 180 degrees, FIXED_SCALE per degree
+int32_t
+getYawHundredths(void);
+
+
+// *******************************************************
+// getYawTotalHundredths: RETURNS the total angle turned from the reference
+//                  point, without wrapping, FIXED_SCALE per degree
+int32_t
+getYawTotalHundredths(void);
 
 
 // *******************************************************
-// getYaw:          Uses the current slot number on the disk to
-//                  return an angle in degrees from the original reference point.
-// RETURNS:         Angle value between -180 < Yaw < 180 degrees.
+// getYaw:          RETURNS the angle in whole degrees, -180 < Yaw < 180,
+//                  truncated towards zero
 int32_t
 getYaw(void);
 
 
+// *******************************************************
+// getYawTotal:     RETURNS the total angle in whole degrees, rounded to
+//                  the nearest degree
 int32_t
 getYawTotal(void);
 
+
 // *******************************************************
-// resetYaw:        Resets the slot number to 0
+// resetYaw:        Makes the current position the zero of yaw
 void
 resetYaw (void);
 
 
+// *******************************************************
+// resetYawAt:      Makes an earlier position, captured with yawSlot, the
+//                  zero of yaw. Task context only.
+void
+resetYawAt (int32_t captured);
+
+
+// *******************************************************
+// yawSlot:         RETURNS the raw slot count, for an ISR to capture
+int32_t
+yawSlot (void);
+
+
 // *******************************************************
 //  YawIntHandler:  Interrupt handler for the yaw interrupt.
 //                  Measures Phasse A and Phase B.
@@ -0,0 +1,472 @@
+//*****************************************************************************
+//
+// bench - Host micro-benchmarks of the firmware's pure logic: the circular
+//         buffer, quadrature decoding and yaw conversions, the PID step and
+//         clamp, ustdlib formatting and parsing, and OrbitOLED text
+//         rendering into the frame buffer. Each benchmark is warmed up,
+//         then timed over a number of repetitions sized to REP_NS each; the
+//         summary is of the ns per operation across repetitions.
+//
+//          Usage:  bench [-r reps] [-f filter] [-o results.json]
+//                        [-b baseline.json] [-t percent]
+//
+//          -r          repetitions per benchmark, default 20
+//          -f          only run benchmarks whose name contains filter
+//          -o          write the results as JSON
+//          -b          compare the medians with an earlier results file;
+//                      exits with status 1 if any is slower by more than
+//                      -t percent (default 10)
+//
+//          Host timings only rank changes to the C; target cycles come
+//          from the perf readout the display task sends over UART.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "utils/ustdlib.h"
+
+#include "circBufT.h"
+#include "altitude.h"
+#include "yaw.h"
+#include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
+#include "control.h"
+#include "heliContext.h"
+#include "buttons4.h"
+#include "blackBox.h"
+#include "lowPower.h"
+#include "perf.h"
+#include "deadline.h"
+#include "bootProfile.h"
+#include "uart.h"
+#include "fixedPoint.h"
+#include "OrbitOLED/OrbitOLEDInterface.h"
+#include "OrbitOLED/lib_OrbitOled/OrbitOledChar.h"
+
+#include "hostHal.h"
+#include "hostRtos.h"
+
+#define DEFAULT_REPS        20
+#define DEFAULT_THRESHOLD   10      // Percent slower than the baseline
+#define WARMUP_NS           20000000    // Per benchmark
+#define REP_NS              5000000     // Minimum length of a repetition
+#define MAX_REPS            1000
+#define MAX_LINE            256
+#define BUF_ENTRIES         10      // As the original altitude buffer
+#define FLY_CYCLES          8       // Control cycles allowed to reach Flying
+#define GROUND_SAMPLES      15      // Fills the altitude window
+#define ADC_RESULT          2000
+
+// *******************************************************
+// One benchmark. setup runs once before timing; op is one operation, given
+// its index so the inputs can vary.
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*op)(uint32_t i);
+} bench_t;
+
+// *******************************************************
+// Summary of one benchmark, ns per operation
+typedef struct {
+    uint64_t iters;                 // Operations per repetition
+    double min, median, mean, stddev, max;
+} benchStats_t;
+
+// Clockwise successor of each quadrature state, as in replay.c
+static const uint8_t cwNext[4] = {2, 0, 3, 1};
+
+static circBuf_t buffer;
+static uint8_t encState;
+static char text[MAX_STR_LEN + 1];
+static volatile int64_t sink;       // Keeps results live
+
+static const char *numbers[] = {"0", "42", "65535", "0x1F4", "4294967295", "-17"};
+static const char *reals[] = {"0", "3.14159", "-0.5", "123.25", "1e3", "-42.125"};
+static const char *lines[] = {"Alt 50% [ 55%]", "Yaw -12.34 deg", "Main 43% Tail 31",
+                              "Mode Flying"};
+#define NUM_NUMBERS         (sizeof(numbers) / sizeof(numbers[0]))
+#define NUM_REALS           (sizeof(reals) / sizeof(reals[0]))
+#define NUM_LINES           (sizeof(lines) / sizeof(lines[0]))
+
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+// *******************************************************
+// Benchmarks
+static void circBufSetup(void)
+{
+    if (buffer.data == NULL)
+    {
+        initCircBuf(&buffer, BUF_ENTRIES);
+    }
+}
+
+static void circBufWrite(uint32_t i)
+{
+    writeCircBuf(&buffer, i);
+}
+
+static void circBufRead(uint32_t i)
+{
+    (void)i;
+    sink += readCircBuf(&buffer);
+}
+
+// One encoder edge, clockwise: the new pin levels, then the ISR
+static void yawDecode(uint32_t i)
+{
+    (void)i;
+    encState = cwNext[encState];
+    halSetPins(GPIO_PORTB_BASE, GPIO_PIN_0, encState & 1);
+    halSetPins(GPIO_PORTB_BASE, GPIO_PIN_1, encState & 2);
+    YawIntHandler();
+}
+
+// The decode benchmark leaves yaw many turns out, and getYaw unwraps a turn
+// at a time, so the getters start from the zero
+static void yawSetup(void)
+{
+    resetYaw();
+}
+
+static void yawGet(uint32_t i)
+{
+    (void)i;
+    sink += getYaw();
+}
+
+static void yawGetTotal(uint32_t i)
+{
+    (void)i;
+    sink += getYawTotal();
+}
+
+// Both controllers, in Flying, with the reference changed now and then
+static void pidStep(uint32_t i)
+{
+    if (i % 1024 == 0)
+    {
+        setAltRef(i % 2048 ? 30 : 60);
+        setYawRef(i % 2048 ? 15 : -15);
+    }
+    PIDControlAlt();
+    PIDControlYaw();
+}
+
+static void clampOp(uint32_t i)
+{
+    sink += clamp((int32_t)(i % 256) - 128, -100, 100);
+}
+
+static void formatOp(uint32_t i)
+{
+    sink += usnprintf(text, sizeof(text), "Yaw " FIXED_FMT " deg",
+                      FIXED_ARGS((int32_t)(i % 72000) - 36000));
+}
+
+static void parseUlOp(uint32_t i)
+{
+    sink += ustrtoul(numbers[i % NUM_NUMBERS], NULL, 0);
+}
+
+static void parseFloatOp(uint32_t i)
+{
+    sink += (int64_t)ustrtof(reals[i % NUM_REALS], NULL);
+}
+
+// One line of the status display into the frame buffer, not sent
+static void oledSetup(void)
+{
+    static bool initialised = false;
+
+    if (!initialised)
+    {
+        OLEDInitialise();
+        OrbitOledSetCharUpdate(0);
+        initialised = true;
+    }
+}
+
+static void oledRender(uint32_t i)
+{
+    OLEDStringDraw((char *)lines[i % NUM_LINES], 0, i % NUM_LINES);
+}
+
+static const bench_t benches[] = {
+    {"circbuf.write",       circBufSetup,   circBufWrite},
+    {"circbuf.read",        circBufSetup,   circBufRead},
+    {"yaw.decode",          NULL,           yawDecode},
+    {"yaw.getYaw",          yawSetup,       yawGet},
+    {"yaw.getYawTotal",     yawSetup,       yawGetTotal},
+    {"control.pidStep",     NULL,           pidStep},
+    {"control.clamp",       NULL,           clampOp},
+    {"ustdlib.usnprintf",   NULL,           formatOp},
+    {"ustdlib.ustrtoul",    NULL,           parseUlOp},
+    {"ustdlib.ustrtof",     NULL,           parseFloatOp},
+    {"oled.render",         oledSetup,      oledRender},
+};
+#define NUM_BENCHES         (sizeof(benches) / sizeof(benches[0]))
+
+
+// *******************************************************
+// bringUp:             Initialises the modules as main() does, then steps
+//                      the mode machine to Flying so the PID step does its
+//                      full work
+// RETURNS:             false if Flying was not reached
+static bool bringUp(void)
+{
+    uint32_t cycle;
+    int i;
+
+    halReset();
+    rtosReset();
+    halSetPins(GPIO_PORTF_BASE, LEFT_BUT_PIN | RIGHT_BUT_PIN, true);
+    halSetPins(GPIO_PORTC_BASE, GPIO_PIN_4, true);
+    halSetPins(GPIO_PORTA_BASE, GPIO_PIN_6, true);
+
+    initPerf();
+    initBlackBox();
+    initLowPower();
+    bootEnablePeripherals();
+    initADC();
+    initYaw();
+    initmotor();
+    initMotorOutput();
+    initTorqueFF();
+    initialiseUSB_UART();
+    initButtons();
+    initSwitch_PC4();
+
+    // Calibrated ground, switch up, then the reference pulse and take off.
+    // The first cycle, with the switch down, clears the start up paralysis.
+    for (i = 0; i < GROUND_SAMPLES; i++)
+    {
+        updateAltitude(ADC_RESULT * ADC_SAMPLE_SCALE);
+    }
+    resetAltitude();
+    for (cycle = 1; cycle <= FLY_CYCLES && strcmp(getMode(), "Flying") != 0; cycle++)
+    {
+        rtosSetTick(cycle * DL_PERIOD_MS);
+        updateControl();
+        // Set directly since the tasks and timers that normally set the
+        // switch and take off state are not run here
+        g_heli.ctl.switchState = 1;
+        if (strcmp(getMode(), "Initialising") == 0)
+        {
+            YawRefIntHandler();
+        }
+        g_heli.ctl.stable = true;
+    }
+    return strcmp(getMode(), "Flying") == 0;
+}
+
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+// *******************************************************
+// runBench:            Warms up, sizes a repetition to REP_NS, then times
+//                      reps repetitions
+static void runBench(const bench_t *bench, int reps, benchStats_t *stats)
+{
+    double nsPerOp[MAX_REPS], sum = 0, sumSq = 0;
+    uint64_t start, iters = 1, i;
+    uint32_t op = 0;
+    int rep;
+
+    if (bench->setup != NULL)
+    {
+        bench->setup();
+    }
+
+    // Warm up, doubling the batch until one takes REP_NS
+    start = nowNs();
+    while (nowNs() - start < WARMUP_NS)
+    {
+        uint64_t batchStart = nowNs();
+        for (i = 0; i < iters; i++)
+        {
+            bench->op(op++);
+        }
+        if (nowNs() - batchStart < REP_NS)
+        {
+            iters *= 2;
+        }
+    }
+
+    for (rep = 0; rep < reps; rep++)
+    {
+        start = nowNs();
+        for (i = 0; i < iters; i++)
+        {
+            bench->op(op++);
+        }
+        nsPerOp[rep] = (double)(nowNs() - start) / iters;
+        sum += nsPerOp[rep];
+        sumSq += nsPerOp[rep] * nsPerOp[rep];
+    }
+
+    qsort(nsPerOp, reps, sizeof(double), compareDouble);
+    stats->iters = iters;
+    stats->min = nsPerOp[0];
+    stats->max = nsPerOp[reps - 1];
+    stats->median = (reps % 2) ? nsPerOp[reps / 2]
+                               : (nsPerOp[reps / 2 - 1] + nsPerOp[reps / 2]) / 2;
+    stats->mean = sum / reps;
+    stats->stddev = (reps > 1) ? sqrt(fmax(0, (sumSq - sum * sum / reps) / (reps - 1))) : 0;
+}
+
+
+// *******************************************************
+// baselineMedian:      Finds a benchmark's median in a results file
+// RETURNS:             false if it is not there
+static bool baselineMedian(FILE *file, const char *name, double *median)
+{
+    char line[MAX_LINE], key[MAX_LINE];
+    const char *field;
+
+    rewind(file);
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (strstr(line, key) != NULL && (field = strstr(line, "\"median\": ")) != NULL)
+        {
+            return sscanf(field, "\"median\": %lf", median) == 1;
+        }
+    }
+    return false;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *filter = NULL, *outName = NULL, *baseName = NULL;
+    benchStats_t stats[NUM_BENCHES];
+    bool ran[NUM_BENCHES] = {false};
+    int reps = DEFAULT_REPS, threshold = DEFAULT_THRESHOLD, regressions = 0;
+    FILE *out = NULL, *base = NULL;
+    double median, change;
+    size_t i;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        if (strcmp(argv[argi], "-r") == 0 && argi + 1 < argc) {
+            reps = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc) {
+            filter = argv[++argi];
+        } else if (strcmp(argv[argi], "-o") == 0 && argi + 1 < argc) {
+            outName = argv[++argi];
+        } else if (strcmp(argv[argi], "-b") == 0 && argi + 1 < argc) {
+            baseName = argv[++argi];
+        } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) {
+            threshold = atoi(argv[++argi]);
+        } else {
+            break;
+        }
+    }
+    if (argi != argc || reps < 1 || reps > MAX_REPS)
+    {
+        fprintf(stderr, "usage: %s [-r reps] [-f filter] [-o results.json] "
+                "[-b baseline.json] [-t percent]\n", argv[0]);
+        return 2;
+    }
+    if (baseName != NULL && (base = fopen(baseName, "r")) == NULL)
+    {
+        perror(baseName);
+        return 2;
+    }
+
+    if (!bringUp())
+    {
+        fprintf(stderr, "bench: control stuck in %s\n", getMode());
+        return 2;
+    }
+
+    printf("%-20s %10s %10s %10s %10s %10s  %s\n", "ns/op", "min", "median",
+           "mean", "stddev", "max", baseName != NULL ? "vs baseline" : "");
+    for (i = 0; i < NUM_BENCHES; i++)
+    {
+        if (filter != NULL && strstr(benches[i].name, filter) == NULL)
+        {
+            continue;
+        }
+        runBench(&benches[i], reps, &stats[i]);
+        ran[i] = true;
+
+        printf("%-20s %10.2f %10.2f %10.2f %10.2f %10.2f", benches[i].name, stats[i].min,
+               stats[i].median, stats[i].mean, stats[i].stddev, stats[i].max);
+        if (base != NULL && baselineMedian(base, benches[i].name, &median) && median > 0)
+        {
+            change = (stats[i].median - median) * 100 / median;
+            printf("  %+6.1f%%%s", change, change > threshold ? " SLOWER" : "");
+            if (change > threshold)
+            {
+                regressions++;
+            }
+        }
+        printf("\n");
+    }
+
+    // One benchmark per line, so -b can read it back without a JSON parser
+    if (outName != NULL)
+    {
+        bool first = true;
+
+        if ((out = fopen(outName, "w")) == NULL)
+        {
+            perror(outName);
+            return 2;
+        }
+        fprintf(out, "{\n  \"unit\": \"ns/op\",\n  \"reps\": %d,\n  \"results\": [", reps);
+        for (i = 0; i < NUM_BENCHES; i++)
+        {
+            if (!ran[i])
+            {
+                continue;
+            }
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"iters\": %llu, \"min\": %.3f, "
+                    "\"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, \"max\": %.3f}",
+                    first ? "" : ",", benches[i].name, (unsigned long long)stats[i].iters,
+                    stats[i].min, stats[i].median, stats[i].mean, stats[i].stddev,
+                    stats[i].max);
+            first = false;
+        }
+        fprintf(out, "\n  ]\n}\n");
+        fclose(out);
+    }
+
+    if (base != NULL)
+    {
+        fclose(base);
+        if (regressions > 0)
+        {
+            fprintf(stderr, "bench: %d benchmark(s) more than %d%% slower than %s\n",
+                    regressions, threshold, baseName);
+            return 1;
+        }
+    }
+    return 0;
+}
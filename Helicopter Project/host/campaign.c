@@ -0,0 +1,335 @@
+//*****************************************************************************
+//
+// campaign - Monte Carlo robustness campaign. Flies thousands of simulated
+//            flights (see flight.h), each with one class of sensor or
+//            actuator fault at a random severity, spread over every core,
+//            and reports per fault class how often the flight logic still
+//            flew and landed, against how often it does with no fault, the
+//            worst altitude overshoot and the time to land.
+//
+//            Usage:  campaign [-n flights] [-j jobs] [-s seed] [-t seconds]
+//                             [-f fault]...
+//
+//            -n          flights per fault class, default 500
+//            -j          worker threads, default one per online core
+//            -s          campaign seed, default 1
+//            -t          flight length, default 60 s
+//            -f          fault class to fly, may be repeated, default all:
+//                        none adc-noise adc-spike enc-drop enc-dup pwm-sat
+//                        ref-delay ref-miss. none is always flown, as the
+//                        baseline.
+//
+//            Every flight flies the spiral up in Special mode before it
+//            lands, and succeeds if it flew, landed and was back on the
+//            ground at the end, facing within LAND_HEADING of the
+//            reference. Each flight is a HeliContext of its own (see
+//            flightRunContext), so the workers share one process, each
+//            taking the next flight until none are left. The flight logic
+//            is flown without the RTOS, so deadlines are flysim's to
+//            check. Each class's success is also given less the no-fault
+//            success, and the no-fault failure rate is reported, so a
+//            fault is not blamed for failures the baseline has too. The
+//            seed of each flight depends only on the campaign seed, its
+//            class and its number, so a campaign repeats exactly whatever
+//            -j is, and the mildest failure of each class is given as the
+//            flysim line that flies it again.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "flight.h"
+
+#define DEFAULT_FLIGHTS     500
+#define DEFAULT_SECONDS     60
+#define DEFAULT_SEED        1
+#define LAND_HEADING        15.0    // deg, the landing must face the reference
+
+// *******************************************************
+// One flight, written by the worker that flew it
+typedef struct {
+    faultClass_t fault;
+    uint32_t seed;
+    bool done;
+    flightResult_t result;
+} slot_t;
+
+// *******************************************************
+// The flights the workers share, and the next one to fly
+typedef struct {
+    slot_t *slots;
+    uint32_t total;
+    uint32_t seconds;
+    uint32_t next;
+    pthread_mutex_t lock;
+} work_t;
+
+// *******************************************************
+// The flights of one fault class
+typedef struct {
+    uint32_t flights;
+    uint32_t successes;
+    uint32_t neverFlew;
+    uint32_t failed;                // Could not be flown
+    double worstOvershoot;
+    uint32_t landings;
+    uint64_t landTotalMs;
+    uint32_t worstLandMs;
+    double worstHeading;
+    bool anyFailed;
+    double failSeverity;            // Lowest severity that failed, and its
+    uint32_t failSeed;              // flight
+} classStats_t;
+
+
+// *******************************************************
+// flightSeed:          RETURNS the seed of a flight, never 0 as that is the
+//                      nominal rig
+static uint32_t flightSeed(uint32_t campaign, faultClass_t fault, uint32_t n)
+{
+    uint32_t h = campaign * 0x9E3779B1u ^ (fault << 24) ^ n;
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h ? h : 1;
+}
+
+
+// *******************************************************
+// worker:              Flies the next flight until every one has flown
+static void *worker(void *arg)
+{
+    work_t *work = arg;
+    flightConfig_t config = {work->seconds, 0, FAULT_NONE, true, false, false, NULL};
+    slot_t *slot;
+
+    for ( ;; )
+    {
+        pthread_mutex_lock(&work->lock);
+        slot = work->next < work->total ? &work->slots[work->next++] : NULL;
+        pthread_mutex_unlock(&work->lock);
+        if (slot == NULL)
+        {
+            return NULL;
+        }
+        config.seed = slot->seed;
+        config.fault = slot->fault;
+        slot->done = flightRunContext(&config, &slot->result);
+    }
+}
+
+
+// *******************************************************
+// tally:               Adds a flight to the statistics of its class
+static void tally(classStats_t *stats, const slot_t *slot)
+{
+    const flightResult_t *r = &slot->result;
+    bool success;
+
+    stats->flights++;
+    if (!slot->done)
+    {
+        stats->failed++;
+        success = false;
+    } else {
+        success = r->flew && r->landed && r->heading <= LAND_HEADING;
+        stats->neverFlew += !r->flew;
+        if (r->overshoot > stats->worstOvershoot)
+        {
+            stats->worstOvershoot = r->overshoot;
+        }
+        if (r->timeToLandMs > 0)
+        {
+            stats->landings++;
+            stats->landTotalMs += r->timeToLandMs;
+            if (r->timeToLandMs > stats->worstLandMs)
+            {
+                stats->worstLandMs = r->timeToLandMs;
+            }
+            if (r->heading > stats->worstHeading)
+            {
+                stats->worstHeading = r->heading;
+            }
+        }
+    }
+
+    if (success)
+    {
+        stats->successes++;
+    } else {
+        if (!stats->anyFailed || r->severity < stats->failSeverity)
+        {
+            stats->failSeverity = r->severity;
+            stats->failSeed = slot->seed;
+        }
+        stats->anyFailed = true;
+    }
+}
+
+
+// *******************************************************
+// successRate:         RETURNS the percentage of a class's flights that
+//                      succeeded
+static double successRate(const classStats_t *stats)
+{
+    return stats->flights ? 100.0 * stats->successes / stats->flights : 0.0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t perClass = DEFAULT_FLIGHTS, seed = DEFAULT_SEED, seconds = DEFAULT_SECONDS;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    bool chosen[NUM_FAULTS] = {false}, anyChosen = false;
+    classStats_t stats[NUM_FAULTS];
+    const classStats_t *baseline = &stats[FAULT_NONE];
+    uint32_t total, i, n;
+    struct timespec start, stop;
+    faultClass_t fault;
+    pthread_t *workers;
+    work_t work;
+    double wall;
+    long started;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc)
+        {
+            perClass = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+            jobs = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) {
+            seed = strtoul(argv[++argi], NULL, 0);
+        } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) {
+            seconds = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc &&
+                   (fault = flightFaultFind(argv[++argi])) != NUM_FAULTS) {
+            chosen[fault] = anyChosen = true;
+        } else {
+            fprintf(stderr, "usage: %s [-n flights] [-j jobs] [-s seed] [-t seconds] "
+                    "[-f fault]...\n", argv[0]);
+            return 2;
+        }
+    }
+    for (fault = 0; fault < NUM_FAULTS; fault++)
+    {
+        chosen[fault] |= !anyChosen || fault == FAULT_NONE;
+    }
+    if (jobs < 1)
+    {
+        jobs = 1;
+    }
+
+    for (fault = 0, total = 0; fault < NUM_FAULTS; fault++)
+    {
+        total += chosen[fault] ? perClass : 0;
+    }
+    work.slots = calloc(total ? total : 1, sizeof(slot_t));
+    workers = calloc(jobs, sizeof(pthread_t));
+    if (work.slots == NULL || workers == NULL)
+    {
+        fprintf(stderr, "campaign: out of memory\n");
+        return 2;
+    }
+    i = 0;
+    for (fault = 0; fault < NUM_FAULTS; fault++)
+    {
+        for (n = 0; chosen[fault] && n < perClass; n++, i++)
+        {
+            work.slots[i].fault = fault;
+            work.slots[i].seed = flightSeed(seed, fault, n);
+        }
+    }
+    work.total = total;
+    work.seconds = seconds;
+    work.next = 0;
+    pthread_mutex_init(&work.lock, NULL);
+
+    // Every worker flies until the flights run out
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (started = 0; started < jobs; started++)
+    {
+        if (pthread_create(&workers[started], NULL, worker, &work) != 0)
+        {
+            break;
+        }
+    }
+    if (started == 0)
+    {
+        fprintf(stderr, "campaign: cannot start a worker\n");
+        return 2;
+    }
+    while (started > 0)
+    {
+        pthread_join(workers[--started], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    wall = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+    memset(stats, 0, sizeof(stats));
+    for (i = 0; i < total; i++)
+    {
+        tally(&stats[work.slots[i].fault], &work.slots[i]);
+    }
+
+    printf("# campaign: %u flights of %u s, seed %u, %ld workers, %.1f s (%.0f flights/s)\n",
+           total, seconds, seed, jobs, wall, wall > 0 ? total / wall : 0.0);
+    printf("%-10s %7s %8s %8s %6s %9s %9s %9s %8s\n", "fault", "flights",
+           "success", "vs none", "nofly", "overshoot", "land avg", "land max",
+           "head deg");
+    for (fault = 0; fault < NUM_FAULTS; fault++)
+    {
+        if (!chosen[fault])
+        {
+            continue;
+        }
+        printf("%-10s %7u %7.1f%% %+7.1f%% %6u %8.1f%% %6.0f ms %6u ms %8.1f\n",
+               flightFaultName(fault), stats[fault].flights, successRate(&stats[fault]),
+               successRate(&stats[fault]) - successRate(baseline),
+               stats[fault].neverFlew, stats[fault].worstOvershoot,
+               stats[fault].landings ? (double)stats[fault].landTotalMs / stats[fault].landings : 0.0,
+               stats[fault].worstLandMs, stats[fault].worstHeading);
+    }
+
+    // The baseline, then where each class starts to fail, with that flight
+    // to fly again
+    printf("# none: %u of %u flights failed with no fault (%.1f%%)\n",
+           baseline->flights - baseline->successes, baseline->flights,
+           100.0 - successRate(baseline));
+    for (fault = 0; fault < NUM_FAULTS; fault++)
+    {
+        if (!chosen[fault] || !stats[fault].anyFailed)
+        {
+            continue;
+        }
+        if (stats[fault].failed > 0)
+        {
+            printf("# %s: %u flights could not be flown\n", flightFaultName(fault),
+                   stats[fault].failed);
+        }
+        if (fault == FAULT_NONE)
+        {
+            printf("# %s: fails: flysim -c -m -t %u -s %u\n",
+                   flightFaultName(fault), seconds, stats[fault].failSeed);
+        } else {
+            printf("# %s: fails from %.1f %s: flysim -c -m -t %u -f %s -s %u\n",
+                   flightFaultName(fault), stats[fault].failSeverity,
+                   flightFaultUnit(fault), seconds, flightFaultName(fault),
+                   stats[fault].failSeed);
+        }
+    }
+    free(workers);
+    free(work.slots);
+    return 0;
+}
@@ -0,0 +1,189 @@
+//*****************************************************************************
+//
+// debounce - Host test of the buttons4 debouncing. Scripted bounce patterns
+//            are played onto the input pins in the virtual time of hostRtos,
+//            and the debounced events buttons4 sends are checked: exactly one
+//            event per press and per release, stamped with the tick of the
+//            first edge of the bounce, and none for a glitch that returns to
+//            the level it left.
+//
+//          Usage:  debounce [-v]
+//
+//          -v          print every pattern, not only failures
+//
+//          The exit status is 0 if every pattern passes.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+
+#include "buttons4.h"
+
+#include "hostHal.h"
+#include "hostRtos.h"
+#include "hostSim.h"
+
+#define MAX_EDGES           16
+#define PATTERN_MS          1000    // Each pattern starts this long after the last
+#define RELEASE_MS          300     // Release bounce, after the press bounce
+#define EVENT_QUEUE         16
+
+// *******************************************************
+// A press and its release. Each bounce lists its edges in microseconds after
+// the first; the level alternates from the first edge, which always leaves
+// the resting level. A glitch has no release: the pin returns by itself.
+typedef struct {
+    const char *name;
+    uint8_t input;
+    uint32_t press[MAX_EDGES];
+    uint8_t numPress;
+    uint32_t release[MAX_EDGES];
+    uint8_t numRelease;
+} pattern_t;
+
+static const pattern_t patterns[] = {
+    {"clean",           UP,        {0}, 1, {0}, 1},
+    {"short bounce",    UP,        {0, 200, 450, 800, 1300}, 5,
+                                   {0, 150, 400, 900, 1500}, 5},
+    {"bounce past the debounce time", DOWN,
+                                   {0, 1000, 2500, 4000, 5500, 7000, 7400}, 7,
+                                   {0, 3000, 4800, 6600, 8200}, 5},
+    {"active low",      LEFT,      {0, 300, 900}, 3, {0, 500, 1000}, 3},
+    {"active low PF0",  RIGHT,     {0, 100, 200, 300, 400}, 5, {0, 2000, 4900}, 3},
+    {"mode switch",     SWITCH1,   {0, 50, 120, 260, 900, 3100, 3200}, 7,
+                                   {0, 700, 1500}, 3},
+    {"edge on a tick",  UP,        {1000, 1100, 1250}, 3, {999, 1001, 1003}, 3},
+    {"glitch",          UP,        {0, 1000}, 2, {0}, 0},
+    {"double glitch",   LEFT,      {0, 300, 2000, 2200}, 4, {0}, 0},
+};
+#define NUM_PATTERNS (sizeof(patterns) / sizeof(patterns[0]))
+
+static const uint32_t inputBase[NUM_INPUTS] = {UP_BUT_PORT_BASE, DOWN_BUT_PORT_BASE,
+    LEFT_BUT_PORT_BASE, RIGHT_BUT_PORT_BASE, SWITCH1_PORT_BASE, RESET_BUT_PORT_BASE};
+static const uint8_t inputPin[NUM_INPUTS] = {UP_BUT_PIN, DOWN_BUT_PIN,
+    LEFT_BUT_PIN, RIGHT_BUT_PIN, SWITCH1_PIN, RESET_BUT_PIN};
+static const bool inputNormal[NUM_INPUTS] = {UP_BUT_NORMAL, DOWN_BUT_NORMAL,
+    LEFT_BUT_NORMAL, RIGHT_BUT_NORMAL, SWITCH1_NORMAL, RESET_BUT_NORMAL};
+static const char *const stateNames[] = {"RELEASED", "PUSHED"};
+
+
+// *******************************************************
+// bounce:              Queues the edges of one bounce
+// TAKES:               startUs, the time of the first edge
+//                      fromNormal, true if the first edge leaves the resting
+//                      level
+static void bounce(uint8_t input, uint64_t startUs, const uint32_t *edges,
+                   uint8_t numEdges, bool fromNormal)
+{
+    bool level = fromNormal ? !inputNormal[input] : inputNormal[input];
+    uint8_t i;
+
+    for (i = 0; i < numEdges; i++, level = !level)
+    {
+        simSetPinsAt(startUs + edges[i], inputBase[input], inputPin[input], level);
+    }
+}
+
+
+// *******************************************************
+// expect:              Takes the next event and checks it
+// RETURNS:             true if it is the input's change to state at tick
+static bool expect(QueueHandle_t events, const pattern_t *pattern, uint8_t state,
+                   TickType_t tick)
+{
+    butEvent_t event;
+
+    if (xQueueReceive(events, &event, 0) != pdPASS)
+    {
+        printf("debounce: %s: no %s event\n", pattern->name, stateNames[state]);
+        return false;
+    }
+    if (event.input != pattern->input || event.state != state || event.time != tick)
+    {
+        printf("debounce: %s: got input %u %s at %u, expected input %u %s at %u\n",
+               pattern->name, event.input, stateNames[event.state & 1],
+               (unsigned)event.time, pattern->input, stateNames[state],
+               (unsigned)tick);
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    QueueHandle_t events;
+    const pattern_t *pattern;
+    butEvent_t extra;
+    uint64_t pressUs, releaseUs;
+    bool verbose = false, passed;
+    uint32_t i, failures = 0;
+
+    if (argc == 2 && strcmp(argv[1], "-v") == 0)
+    {
+        verbose = true;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+        return 2;
+    }
+
+    // Power on levels: every input at rest
+    halReset();
+    rtosReset();
+    for (i = 0; i < NUM_INPUTS; i++)
+    {
+        halSetPins(inputBase[i], inputPin[i], inputNormal[i]);
+    }
+    initButtons();
+    IntMasterEnable();
+    events = xQueueCreate(EVENT_QUEUE, sizeof(butEvent_t));
+    if (events == NULL || !buttonSubscribe(events, (1 << NUM_INPUTS) - 1))
+    {
+        fprintf(stderr, "debounce: cannot subscribe\n");
+        return 2;
+    }
+
+    for (i = 0; i < NUM_PATTERNS; i++)
+    {
+        pattern = &patterns[i];
+        pressUs = (uint64_t)(i + 1) * PATTERN_MS * 1000;
+        releaseUs = pressUs + RELEASE_MS * 1000;
+        bounce(pattern->input, pressUs, pattern->press, pattern->numPress, true);
+        bounce(pattern->input, releaseUs, pattern->release, pattern->numRelease, false);
+        rtosRunUntil(pressUs + PATTERN_MS * 1000);
+
+        // A glitch, an even number of edges, ends where it started
+        if (pattern->numPress % 2 == 0)
+        {
+            passed = true;
+        } else {
+            passed = expect(events, pattern, PUSHED,
+                            (pressUs + pattern->press[0]) / 1000 / portTICK_PERIOD_MS) &&
+                     expect(events, pattern, RELEASED,
+                            (releaseUs + pattern->release[0]) / 1000 / portTICK_PERIOD_MS);
+        }
+        while (xQueueReceive(events, &extra, 0) == pdPASS)
+        {
+            printf("debounce: %s: extra input %u %s at %u\n", pattern->name,
+                   extra.input, stateNames[extra.state & 1], (unsigned)extra.time);
+            passed = false;
+        }
+        if (verbose || !passed)
+        {
+            printf("%-32s %s\n", pattern->name, passed ? "ok" : "FAILED");
+        }
+        failures += !passed;
+    }
+
+    printf("# debounce: %u patterns, %u failed\n", (unsigned)NUM_PATTERNS,
+           (unsigned)failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,819 @@
+//*****************************************************************************
+//
+// flight - One flight of the whole firmware, or of a context, against a
+//          model of the rig, with optional fault injection. See flight.h.
+//          The rig reaches the whole firmware through pins queued in
+//          virtual time, and a context through its heli* API.
+//
+//          The flight: SW1 goes up at SWITCH_UP_MS and down LAND_MS before
+//          the end. In between UP and RIGHT are pressed once in Flying, or
+//          with special set SW1 is flicked down and up to enter Special and
+//          UP starts the spiral up manoeuvre.
+//
+//          A hover survey instead steps the altitude reference down from
+//          take off to SURVEY_LOW_PERCENT and then up to 100%, holding each
+//          for SURVEY_HOLD_MS, and logs "<altitude %> <main duty %>" every
+//          SURVEY_LOG_MS while the hover is steady.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+
+#include "altitude.h"
+#include "yaw.h"
+#include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
+#include "control.h"
+#include "buttons4.h"
+#include "blackBox.h"
+#include "lowPower.h"
+#include "perf.h"
+#include "deadline.h"
+#include "bootProfile.h"
+#include "uart.h"
+#include "heliContext.h"
+
+#include "hostHal.h"
+#include "hostRtos.h"
+#include "hostSim.h"
+#include "flight.h"
+
+#define TASK_STACK_DEPTH    128     // As main()
+
+#define PLANT_STEP_US       1000    // Also a context flight's step
+#define PLANT_TRACE_MS      100
+#define SWITCH_UP_MS        1000
+#define LAND_MS             15000   // Before the end
+#define PRESS_MS            200     // Button held down
+#define FLICK_MS            10000   // SW1 flicked down and up, for Special
+#define FLICK_HOLD_MS       200     // Well inside MODE_CHANGE_TIME
+#define REF_PULSE_US        100     // PC4 low at the reference
+#define BOUNCE_US           5       // Between the bounces of an encoder edge
+#define SURVEY_START_MS     15000   // Hover survey, after take off settles
+#define SURVEY_HOLD_MS      25000   // At each altitude
+#define SURVEY_LOW_PERCENT  10
+#define SURVEY_STEP_PERCENT 10      // As control.c's ALT_STEP_RATE
+#define SURVEY_TAKEOFF      50      // Altitude reference after take off
+#define SURVEY_LOG_MS       100
+#define SURVEY_STEADY_ALT   1.0     // % measured from the reference
+#define SURVEY_STEADY_VEL   0.2     // %/s
+
+#define HOVER               45.0    // Main duty %, as altScheduleTable.c
+#define TORQUE_RATIO        0.778   // Tail % per main %, as torqueFF.c
+#define ALT_GAIN            3.0     // %/s^2 per duty % off hover
+#define ALT_DRAG            1.5     // 1/s
+#define YAW_GAIN            6.0     // deg/s^2 per duty % of net torque
+#define YAW_DRAG            3.0     // 1/s
+#define START_YAW           -30.0   // deg from the reference
+#define ENC_SLOTS           448     // Edges per turn, as yaw.c
+#define GROUND_COUNTS       2000    // ADC counts on the ground
+#define COUNTS_PER_PERCENT  (1000.0 * 4095 / 3300 / 100)
+
+#define ADC_PERIOD_MS       30      // As vADCSampleTask, for a context flight
+#define SWITCH_TIMER_MS     500     // As control.c's MODE_CHANGE_TIME
+#define MAX_REFS            4       // Reference pulses a context has waiting
+#define MAX_SCRIPT          32      // SW1 changes and presses a context has queued
+
+// *******************************************************
+// The rig
+typedef struct {
+    double alt, altVel;             // %, %/s
+    double yaw, yawVel;             // deg, deg/s, from the reference
+    int32_t slot;                   // Encoder edges issued
+    uint8_t encState;               // PB1:PB0 after the last edge issued
+    uint32_t noise;                 // ADC noise generator
+    int32_t ground;                 // ADC counts on the ground
+} plant_t;
+
+// *******************************************************
+// The faults of a flight, all off by default
+typedef struct {
+    double adcNoise;                // Counts rms
+    double spikeChance;             // Per conversion
+    double spikeSize;               // Counts
+    double dropChance;              // Per encoder edge
+    double bounceChance;            // Per encoder edge
+    double mainCap, tailCap;        // Duty %
+    uint32_t refDelayUs;
+    double refMissChance;           // Per pulse
+} faults_t;
+
+typedef struct flight flight_t;
+
+// *******************************************************
+// How the rig reaches the helicopter: through the simulated pins of the
+// whole firmware, or straight into a context
+typedef struct {
+    // An encoder edge at atUs, its interrupt lost unless seen
+    void (*edge)(flight_t *f, uint64_t atUs, uint8_t changed, uint8_t levels,
+                 bool seen);
+    // A PC4 reference pulse at atUs
+    void (*ref)(flight_t *f, uint64_t atUs);
+    void (*press)(flight_t *f, uint32_t atMs, uint8_t button);
+    void (*setSwitch)(flight_t *f, uint32_t atMs, bool on);
+} rigOps_t;
+
+// *******************************************************
+// One flight: its rig, faults and results, and for a context flight the
+// context and what its owner has queued for it
+struct flight {
+    const rigOps_t *ops;
+    const flightConfig_t *cfg;
+    flightResult_t *res;
+    HeliContext *heli;              // g_heli, or ctx
+    plant_t plant;
+    faults_t faults;
+    uint32_t rng;                   // Fault generator
+    const char *lastMode;
+    uint32_t landingAtMs;
+
+    HeliContext ctx;
+    double main, tail;              // Duty % the pwm hook last set
+    uint8_t pins;                   // PB1:PB0 as the context last saw them
+    uint8_t pending;                // Buttons pressed, one bit each
+    uint32_t timerDueMs;            // Switch timer, 0 when stopped
+    uint32_t refDueMs[MAX_REFS];    // Reference pulses not yet seen
+    uint32_t numRefs;
+    struct {
+        uint32_t atMs;
+        int8_t button;              // Pressed, or -1 for SW1
+        bool on;                    // SW1's new state
+    } script[MAX_SCRIPT];
+    uint32_t numScript;
+};
+
+static const char *const faultNames[NUM_FAULTS] = {"none", "adc-noise",
+    "adc-spike", "enc-drop", "enc-dup", "pwm-sat", "ref-delay", "ref-miss"};
+static const char *const faultUnits[NUM_FAULTS] = {"", "counts rms",
+    "% of conversions", "% of edges", "% of edges", "% main duty", "ms",
+    "% of pulses"};
+
+// The whole firmware flight. hostHal's hooks take no argument, so they find
+// it here.
+static flight_t fw;
+
+// Clockwise and anticlockwise successor of each quadrature state
+static const uint8_t cwNext[4] = {2, 0, 3, 1};
+static const uint8_t ccwNext[4] = {1, 3, 0, 2};
+
+
+// *******************************************************
+// uniform:             RETURNS a draw from lo to hi
+static double uniform(flight_t *f, double lo, double hi)
+{
+    f->rng ^= f->rng << 13;
+    f->rng ^= f->rng >> 17;
+    f->rng ^= f->rng << 5;
+    return lo + (hi - lo) * (f->rng / 4294967296.0);
+}
+
+
+// *******************************************************
+// gaussian:            RETURNS a draw from the unit normal
+static double gaussian(flight_t *f)
+{
+    double u = uniform(f, 1e-12, 1.0), v = uniform(f, 0.0, 1.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+
+// *******************************************************
+// mix:                 Adds bytes to the output checksum
+static void mix(flight_t *f, const void *bytes, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        f->res->checksum ^= ((const uint8_t *)bytes)[i];
+        f->res->checksum *= 1099511628211ULL;
+    }
+}
+
+
+// *******************************************************
+// pwmWritten:          Records every compare write into the output checksum
+static void pwmWritten(uint32_t ui32Base, uint32_t ui32Width, uint32_t ui32Period)
+{
+    uint32_t words[3] = {(uint32_t)(rtosNowUs() / 1000), ui32Base, ui32Width};
+
+    (void)ui32Period;
+    mix(&fw, words, sizeof(words));
+    fw.res->writes++;
+}
+
+
+// *******************************************************
+// duty:                RETURNS the duty a PWM module drives, in percent
+static double duty(uint32_t ui32Base)
+{
+    uint32_t period = halPeriod(ui32Base);
+
+    return period ? halPulseWidth(ui32Base) * 100.0 / period : 0.0;
+}
+
+
+// *******************************************************
+// conversion:          RETURNS the model's altitude as a 12 bit result, with
+//                      a count or two of noise and any faults
+static uint32_t conversion(flight_t *f)
+{
+    int32_t counts;
+
+    f->plant.noise = f->plant.noise * 1103515245 + 12345;
+    counts = f->plant.ground - (int32_t)(f->plant.alt * COUNTS_PER_PERCENT + 0.5) +
+             (int32_t)((f->plant.noise >> 16) % 5) - 2;
+    if (f->faults.adcNoise > 0)
+    {
+        counts += (int32_t)lround(gaussian(f) * f->faults.adcNoise);
+    }
+    if (f->faults.spikeChance > 0 && uniform(f, 0, 1) < f->faults.spikeChance)
+    {
+        counts += (int32_t)(uniform(f, 0, 1) < 0.5 ? f->faults.spikeSize :
+                                                      -f->faults.spikeSize);
+    }
+    return counts < 0 ? 0 : counts > 4095 ? 4095 : counts;
+}
+
+
+// *******************************************************
+// adcSample:           The ADC source of the whole firmware flight
+static uint32_t adcSample(uint32_t ui32Step)
+{
+    (void)ui32Step;
+    return conversion(&fw);
+}
+
+
+// *******************************************************
+// issueEdges:          Gives the helicopter the encoder edges, and the
+//                      reference pulse, for each slot the yaw passed in the
+//                      last step
+// TAKES:               from, to, the yaw at the start and end of the step
+//                      start, the time of the start of the step
+static void issueEdges(flight_t *f, double from, double to, uint64_t start)
+{
+    plant_t *plant = &f->plant;
+    int32_t target = (int32_t)floor(to * ENC_SLOTS / 360.0);
+    int32_t boundary;
+    uint64_t at;
+    uint8_t next, changed;
+
+    while (plant->slot != target)
+    {
+        // The slot boundary passed, and when in the step it was passed
+        boundary = plant->slot + (target > plant->slot ? 1 : 0);
+        at = start + (uint64_t)(PLANT_STEP_US * (boundary * 360.0 / ENC_SLOTS - from) /
+                                (to - from));
+        if (target > plant->slot)
+        {
+            next = cwNext[plant->encState];
+            plant->slot++;
+        } else {
+            next = ccwNext[plant->encState];
+            plant->slot--;
+        }
+        changed = next ^ plant->encState;
+        f->ops->edge(f, at, changed, next & changed,
+                     !(f->faults.dropChance > 0 && uniform(f, 0, 1) < f->faults.dropChance));
+        if (f->faults.bounceChance > 0 && uniform(f, 0, 1) < f->faults.bounceChance)
+        {
+            f->ops->edge(f, at + BOUNCE_US, changed, plant->encState & changed, true);
+            f->ops->edge(f, at + 2 * BOUNCE_US, changed, next & changed, true);
+        }
+        plant->encState = next;
+
+        if (boundary % ENC_SLOTS == 0 &&
+            !(f->faults.refMissChance > 0 && uniform(f, 0, 1) < f->faults.refMissChance))
+        {
+            f->ops->ref(f, at + f->faults.refDelayUs);
+        }
+    }
+}
+
+
+// *******************************************************
+// modeChanged:         Notes a mode change: whether it flew, and the time and
+//                      heading of a landing
+static void modeChanged(flight_t *f, const char *mode, uint64_t now)
+{
+    uint32_t ms = now / 1000;
+    double heading;
+
+    if (f->cfg->trace)
+    {
+        printf("%u MODE %s alt %.1f%% yaw %.1f deg\n", ms, mode, f->plant.alt, f->plant.yaw);
+    }
+    if (strcmp(mode, "Flying") == 0)
+    {
+        f->res->flew = true;
+    } else if (strcmp(mode, "Landing") == 0) {
+        f->landingAtMs = ms;
+    } else if (strcmp(mode, "Landed") == 0 && f->res->flew) {
+        f->res->timeToLandMs = ms - f->landingAtMs;
+        heading = fmod(f->plant.yaw, 360.0);
+        heading = heading > 180 ? heading - 360 : heading < -180 ? heading + 360 : heading;
+        f->res->heading = fabs(heading);
+    }
+}
+
+
+// *******************************************************
+// plantMove:           Moves the model on one step under the duties the
+//                      rotors are driven at, issuing the edges it passes,
+//                      then notes how the helicopter is doing
+static void plantMove(flight_t *f, double main, double tail, uint64_t now)
+{
+    const double dt = PLANT_STEP_US * 1e-6;
+    plant_t *plant = &f->plant;
+    flightResult_t *res = f->res;
+    double yaw = plant->yaw;
+    const char *mode;
+
+    plant->altVel += (ALT_GAIN * (main - HOVER) - ALT_DRAG * plant->altVel) * dt;
+    plant->alt += plant->altVel * dt;
+    if (plant->alt <= 0)
+    {
+        plant->alt = 0;
+        plant->altVel = plant->altVel < 0 ? 0 : plant->altVel;
+    } else if (plant->alt >= 100) {
+        plant->alt = 100;
+        plant->altVel = plant->altVel > 0 ? 0 : plant->altVel;
+    }
+    if (plant->alt > res->maxAlt)
+    {
+        res->maxAlt = plant->alt;
+    }
+
+    plant->yawVel += (YAW_GAIN * (tail - TORQUE_RATIO * main) - YAW_DRAG * plant->yawVel) * dt;
+    plant->yaw += plant->yawVel * dt;
+    issueEdges(f, yaw, plant->yaw, now);
+
+    if (res->calibratedMs == 0 && heliAltitudeCalibrated(f->heli))
+    {
+        res->calibratedMs = (uint32_t)(now / 1000);
+    }
+
+    mode = heliGetMode(f->heli);
+    if (strcmp(mode, f->lastMode) != 0)
+    {
+        modeChanged(f, mode, now);
+        f->lastMode = mode;
+    }
+    if ((strcmp(mode, "Flying") == 0 || strcmp(mode, "Special") == 0) &&
+        plant->alt - heliGetAltRef(f->heli) > res->overshoot)
+    {
+        res->overshoot = plant->alt - heliGetAltRef(f->heli);
+    }
+    if (f->cfg->verbose && now % (PLANT_TRACE_MS * 1000) == 0)
+    {
+        printf("%llu PLANT main %.1f tail %.1f alt %.1f yaw %.1f\n",
+               (unsigned long long)(now / 1000), main, tail, plant->alt, plant->yaw);
+    }
+}
+
+
+// *******************************************************
+// plantStep:           Moves the model of the whole firmware flight on one
+//                      step under the duties the PWM modules are driving,
+//                      then queues the next step
+static void plantStep(void *pvParam, uint32_t ui32Arg)
+{
+    double main = fmin(duty(PWM0_BASE), fw.faults.mainCap);
+    uint64_t now = rtosNowUs();
+
+    (void)pvParam; (void)ui32Arg;
+    plantMove(&fw, main, fmin(duty(PWM1_BASE), fw.faults.tailCap), now);
+
+    if (fw.cfg->hoverLog != NULL && strcmp(fw.lastMode, "Flying") == 0 &&
+        now % (SURVEY_LOG_MS * 1000) == 0 && fw.plant.alt > 0 && fw.plant.alt < 100 &&
+        fabs(getAltHundredths() / 100.0 - GetAltRef()) < SURVEY_STEADY_ALT &&
+        fabs(fw.plant.altVel) < SURVEY_STEADY_VEL)
+    {
+        fprintf(fw.cfg->hoverLog, "%.2f %.2f\n", getAltHundredths() / 100.0, main);
+    }
+
+    rtosAt(now + PLANT_STEP_US, plantStep, NULL, 0);
+}
+
+
+// *******************************************************
+// The whole firmware's rig: pins queued in virtual time
+
+static void pinEdge(flight_t *f, uint64_t atUs, uint8_t changed, uint8_t levels, bool seen)
+{
+    if (seen)
+    {
+        simSetPinsAt(atUs, GPIO_PORTB_BASE, changed, levels);
+    } else {
+        simSetPinsSilentAt(atUs, GPIO_PORTB_BASE, changed, levels);
+    }
+}
+
+static void pinRef(flight_t *f, uint64_t atUs)
+{
+    simSetPinsAt(atUs, GPIO_PORTC_BASE, GPIO_PIN_4, false);
+    simSetPinsAt(atUs + REF_PULSE_US, GPIO_PORTC_BASE, GPIO_PIN_4, true);
+}
+
+// A button press and release
+static void pinPress(flight_t *f, uint32_t atMs, uint8_t button)
+{
+    static const struct {
+        uint32_t port;
+        uint8_t pin;
+        bool normal;
+    } buttons[NUM_BUTS] = {
+        [UP] = {UP_BUT_PORT_BASE, UP_BUT_PIN, UP_BUT_NORMAL},
+        [DOWN] = {DOWN_BUT_PORT_BASE, DOWN_BUT_PIN, DOWN_BUT_NORMAL},
+        [LEFT] = {LEFT_BUT_PORT_BASE, LEFT_BUT_PIN, LEFT_BUT_NORMAL},
+        [RIGHT] = {RIGHT_BUT_PORT_BASE, RIGHT_BUT_PIN, RIGHT_BUT_NORMAL},
+    };
+
+    simSetPinsAt((uint64_t)atMs * 1000, buttons[button].port, buttons[button].pin,
+                 !buttons[button].normal);
+    simSetPinsAt((uint64_t)(atMs + PRESS_MS) * 1000, buttons[button].port,
+                 buttons[button].pin, buttons[button].normal);
+}
+
+static void pinSwitch(flight_t *f, uint32_t atMs, bool on)
+{
+    simSetPinsAt((uint64_t)atMs * 1000, SWITCH1_PORT_BASE, SWITCH1_PIN, on);
+}
+
+static const rigOps_t pinOps = {pinEdge, pinRef, pinPress, pinSwitch};
+
+
+// *******************************************************
+// A context's rig: edges and pulses given to it as the step passes them,
+// buttons and SW1 as its script comes due
+
+static void contextEdge(flight_t *f, uint64_t atUs, uint8_t changed, uint8_t levels,
+                        bool seen)
+{
+    f->pins = (f->pins & ~changed) | levels;
+    if (seen)
+    {
+        heliYawEdge(f->heli, f->pins);
+    }
+}
+
+static void contextRef(flight_t *f, uint64_t atUs)
+{
+    if (f->numRefs < MAX_REFS)
+    {
+        f->refDueMs[f->numRefs++] = (uint32_t)((atUs + 999) / 1000);
+    }
+}
+
+static void contextPress(flight_t *f, uint32_t atMs, uint8_t button)
+{
+    if (f->numScript < MAX_SCRIPT)
+    {
+        f->script[f->numScript].atMs = atMs;
+        f->script[f->numScript].button = button;
+        f->numScript++;
+    }
+}
+
+static void contextSwitch(flight_t *f, uint32_t atMs, bool on)
+{
+    if (f->numScript < MAX_SCRIPT)
+    {
+        f->script[f->numScript].atMs = atMs;
+        f->script[f->numScript].button = -1;
+        f->script[f->numScript].on = on;
+        f->numScript++;
+    }
+}
+
+static const rigOps_t contextOps = {contextEdge, contextRef, contextPress, contextSwitch};
+
+
+// *******************************************************
+// The context's hooks, each finding its flight through the user pointer
+
+static void drivePWM(HeliContext *heli, uint32_t mainPermille, uint32_t tailPermille)
+{
+    flight_t *f = heli->user;
+    uint32_t words[3] = {f->ctx.ctl.now * portTICK_PERIOD_MS, mainPermille, tailPermille};
+
+    f->main = mainPermille / 10.0;
+    f->tail = tailPermille / 10.0;
+    mix(f, words, sizeof(words));
+    f->res->writes++;
+}
+
+static uint8_t readButton(HeliContext *heli, uint8_t button)
+{
+    flight_t *f = heli->user;
+
+    if (f->pending & (1 << button))
+    {
+        f->pending &= ~(1 << button);
+        return PUSHED;
+    }
+    return NO_CHANGE;
+}
+
+static void startSwitchTimer(HeliContext *heli, TickType_t now)
+{
+    flight_t *f = heli->user;
+
+    f->timerDueMs = now * portTICK_PERIOD_MS + SWITCH_TIMER_MS;
+}
+
+static const heliHooks_t contextHooks = {drivePWM, readButton, startSwitchTimer};
+
+
+// *******************************************************
+// contextStep:         Moves a context flight on one millisecond: the model
+//                      and its edges, then whatever the owner has due, then
+//                      a control cycle if the altitude is new
+static void contextStep(flight_t *f, uint32_t ms)
+{
+    HeliContext *heli = f->heli;
+    TickType_t now = ms / portTICK_PERIOD_MS;
+    uint32_t sample = 0, i;
+
+    plantMove(f, fmin(f->main, f->faults.mainCap), fmin(f->tail, f->faults.tailCap),
+              (uint64_t)ms * 1000);
+
+    for (i = 0; i < f->numRefs; )
+    {
+        if (f->refDueMs[i] <= ms)
+        {
+            heliRefFound(heli, heliYawSlot(heli), now);
+            f->refDueMs[i] = f->refDueMs[--f->numRefs];
+        } else {
+            i++;
+        }
+    }
+    for (i = 0; i < f->numScript; i++)
+    {
+        if (f->script[i].atMs != ms)
+        {
+            continue;
+        }
+        if (f->script[i].button < 0)
+        {
+            heliSetSwitch(heli, f->script[i].on);
+        } else {
+            f->pending |= 1 << f->script[i].button;
+        }
+    }
+    if (f->timerDueMs != 0 && ms == f->timerDueMs)
+    {
+        f->timerDueMs = 0;
+        heliSwitchTimerExpired(heli, now);
+    }
+
+    if (ms % ADC_PERIOD_MS == 0)
+    {
+        for (i = 0; i < ADC_STEPS; i++)
+        {
+            sample += conversion(f);
+        }
+        if (heliUpdateAltitude(heli, sample))
+        {
+            heliUpdateControl(heli, now);
+        }
+    }
+}
+
+
+// *******************************************************
+// survey:              Queues the reference steps of a hover survey, as many
+//                      as fit before landing at endMs - LAND_MS
+static void survey(flight_t *f, uint32_t endMs)
+{
+    uint32_t atMs = SURVEY_START_MS;
+    int32_t alt;
+
+    if (f->cfg->hoverLog != NULL)
+    {
+        fprintf(f->cfg->hoverLog, "# Hover survey, flysim -H, %u s, seed %u\n"
+                "# altitude %%  main duty %%\n", f->cfg->seconds, f->cfg->seed);
+    }
+    for (alt = SURVEY_TAKEOFF; alt > SURVEY_LOW_PERCENT &&
+         atMs + SURVEY_HOLD_MS <= endMs - LAND_MS; alt -= SURVEY_STEP_PERCENT)
+    {
+        f->ops->press(f, atMs, DOWN);
+        atMs += SURVEY_HOLD_MS;
+    }
+    for ( ; alt < 100 && atMs + SURVEY_HOLD_MS <= endMs - LAND_MS;
+         alt += SURVEY_STEP_PERCENT)
+    {
+        f->ops->press(f, atMs, UP);
+        atMs += SURVEY_HOLD_MS;
+    }
+}
+
+
+// *******************************************************
+// drawFaults:          Sets the faults of a class, their severity drawn from
+//                      the fault generator
+// RETURNS:             The severity, in the class's unit
+static double drawFaults(flight_t *f, faultClass_t fault)
+{
+    faults_t *faults = &f->faults;
+
+    memset(faults, 0, sizeof(*faults));
+    faults->mainCap = faults->tailCap = 100;
+
+    switch (fault)
+    {
+    case FAULT_ADC_NOISE:
+        faults->adcNoise = uniform(f, 5, 60);
+        return faults->adcNoise;
+    case FAULT_ADC_SPIKE:
+        faults->spikeChance = uniform(f, 0.002, 0.05);
+        faults->spikeSize = uniform(f, 300, 2000);
+        return faults->spikeChance * 100;
+    case FAULT_ENC_DROP:
+        faults->dropChance = uniform(f, 0.001, 0.05);
+        return faults->dropChance * 100;
+    case FAULT_ENC_DUP:
+        faults->bounceChance = uniform(f, 0.01, 0.2);
+        return faults->bounceChance * 100;
+    case FAULT_PWM_SAT:
+        faults->mainCap = uniform(f, 50, 80);
+        faults->tailCap = uniform(f, 30, 70);
+        return faults->mainCap;
+    case FAULT_REF_DELAY:
+        faults->refDelayUs = uniform(f, 1000, 100000);
+        return faults->refDelayUs / 1000.0;
+    case FAULT_REF_MISS:
+        faults->refMissChance = uniform(f, 0.2, 0.95);
+        return faults->refMissChance * 100;
+    default:
+        return 0;
+    }
+}
+
+
+// *******************************************************
+// flightStart:         Sets up a flight's rig, nominal for seed 0, else
+//                      started at a random heading and ground level, and
+//                      its faults
+static void flightStart(flight_t *f, const rigOps_t *ops, HeliContext *heli,
+                        const flightConfig_t *config, flightResult_t *result)
+{
+    plant_t *plant = &f->plant;
+
+    f->ops = ops;
+    f->cfg = config;
+    f->res = result;
+    f->heli = heli;
+    f->lastMode = "";
+    f->landingAtMs = 0;
+    memset(result, 0, sizeof(*result));
+    result->checksum = 1469598103934665603ULL;
+
+    f->rng = (config->seed * 2654435761u ^ 0x9E3779B9u) | 1;
+    memset(plant, 0, sizeof(*plant));
+    plant->yaw = config->seed ? uniform(f, -180, 180) : START_YAW;
+    plant->slot = (int32_t)floor(plant->yaw * ENC_SLOTS / 360.0);
+    plant->ground = config->seed ? (int32_t)uniform(f, 1900, 2100) : GROUND_COUNTS;
+    plant->noise = config->seed;
+    result->severity = drawFaults(f, config->fault);
+}
+
+
+// *******************************************************
+// flightScript:        Queues SW1 and the buttons for the whole flight
+static void flightScript(flight_t *f)
+{
+    const flightConfig_t *config = f->cfg;
+    uint32_t endMs = config->seconds * 1000;
+
+    f->ops->setSwitch(f, SWITCH_UP_MS, true);
+    if (config->hoverLog != NULL && endMs > LAND_MS)
+    {
+        survey(f, endMs);
+    } else if (config->special && endMs > LAND_MS + FLICK_MS)
+    {
+        f->ops->setSwitch(f, FLICK_MS, false);
+        f->ops->setSwitch(f, FLICK_MS + FLICK_HOLD_MS, true);
+        f->ops->press(f, FLICK_MS + 1500, UP);
+    } else if (!config->special && endMs > LAND_MS + 10000) {
+        f->ops->press(f, endMs - LAND_MS - 8000, UP);
+        f->ops->press(f, endMs - LAND_MS - 4000, RIGHT);
+    }
+    if (endMs > LAND_MS)
+    {
+        f->ops->setSwitch(f, endMs - LAND_MS, false);
+    }
+}
+
+
+bool flightRun (const flightConfig_t *config, flightResult_t *result)
+{
+    static TaskHandle_t xPIDTask = NULL;
+    uint32_t endMs = config->seconds * 1000;
+
+    flightStart(&fw, &pinOps, &g_heli, config, result);
+
+    // Power on levels: switch down, buttons released, PC4 and PA6 pulled up
+    halReset();
+    rtosReset();
+    simInit();
+    halSetPwmHook(pwmWritten);
+    halSetAdcSource(adcSample);
+    halSetPins(GPIO_PORTF_BASE, LEFT_BUT_PIN | RIGHT_BUT_PIN, true);
+    halSetPins(GPIO_PORTC_BASE, GPIO_PIN_4, true);
+    halSetPins(GPIO_PORTA_BASE, GPIO_PIN_6, true);
+
+    // Same bring up order and tasks as main()
+    initPerf();
+    initBlackBox();
+    initLowPower();
+    bootEnablePeripherals();
+    initADC();
+    initYaw();
+    initmotor();
+    initMotorOutput();
+    initTorqueFF();
+    initialiseUSB_UART();
+    resetAltitude();
+    initButtons();
+    initSwitch_PC4();
+    IntMasterEnable();
+
+    if (xTaskCreate(vADCSampleTask, "ADC Sampler", TASK_STACK_DEPTH, NULL, 2,
+                    NULL) != pdPASS ||
+        xTaskCreate(vControlTask, "Control", TASK_STACK_DEPTH, NULL, 4,
+                    &xPIDTask) != pdPASS ||
+        xTaskCreate(vADCTask, "ADC Calc", TASK_STACK_DEPTH, xPIDTask, 2,
+                    NULL) != pdPASS)
+    {
+        return false;
+    }
+
+    // The flight
+    rtosAt(0, plantStep, NULL, 0);
+    flightScript(&fw);
+    rtosRunUntil((uint64_t)endMs * 1000);
+
+    result->landed = strcmp(getMode(), "Landed") == 0 && fw.plant.alt == 0;
+    rtosGetStats(&result->rtos);
+    deadlineGetStats(&result->deadline);
+    return true;
+}
+
+
+bool flightRunContext (const flightConfig_t *config, flightResult_t *result)
+{
+    uint32_t endMs = config->seconds * 1000, ms;
+    flight_t *f;
+
+    f = calloc(1, sizeof(*f));
+    if (f == NULL)
+    {
+        return false;
+    }
+    flightStart(f, &contextOps, &f->ctx, config, result);
+    heliInit(&f->ctx, &contextHooks, f);
+    flightScript(f);
+
+    for (ms = 0; ms < endMs; ms++)
+    {
+        contextStep(f, ms);
+    }
+
+    result->landed = strcmp(heliGetMode(f->heli), "Landed") == 0 && f->plant.alt == 0;
+    free(f);
+    return true;
+}
+
+
+const char *flightFaultName (faultClass_t fault)
+{
+    return fault < NUM_FAULTS ? faultNames[fault] : "?";
+}
+
+
+const char *flightFaultUnit (faultClass_t fault)
+{
+    return fault < NUM_FAULTS ? faultUnits[fault] : "";
+}
+
+
+faultClass_t flightFaultFind (const char *name)
+{
+    uint32_t i;
+
+    for (i = 0; i < NUM_FAULTS && strcmp(name, faultNames[i]) != 0; i++);
+    return i;
+}
@@ -0,0 +1,114 @@
+#ifndef FLIGHT_H_
+#define FLIGHT_H_
+
+//*****************************************************************************
+//
+// flight - One flight of the whole firmware against a model of the rig, in
+//          the virtual time of hostRtos, with an optional class of sensor or
+//          actuator fault injected. The modules are brought up as main()
+//          does and the sampling, filter and control tasks are created with
+//          main()'s priorities; the display task is left out.
+//
+//          The model steps every millisecond. Altitude follows the main duty
+//          about the hover duty, yaw the tail duty less the main rotor's
+//          reaction torque, each through a first order drag. Each encoder
+//          edge and PC4 reference pulse is queued for the instant the model
+//          passes it, and every ADC conversion samples the model when it
+//          completes.
+//
+//          flightRun flies the whole firmware through its global API on
+//          g_heli, with its tasks, queues and timers, which are globals, so
+//          a process can fly it only once at a time. flightRunContext flies
+//          the same flight, rig and faults against the flight logic alone,
+//          on a HeliContext of its own driven through the heli* API as
+//          twin.c drives its contexts: every millisecond the model moves,
+//          its encoder edges and reference pulses are given to the context,
+//          an ADC sample is taken every 30 ms and a control cycle run on
+//          each new altitude. Any number of those can fly at once, on as
+//          many threads; campaign flies them so. It has no tasks, so no
+//          RTOS or deadline counts.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "deadline.h"
+#include "hostRtos.h"
+
+// *******************************************************
+// Injected faults. Each flight draws the fault's severity from its seed.
+typedef enum {
+    FAULT_NONE = 0,
+    FAULT_ADC_NOISE,        // Gaussian noise on every conversion
+    FAULT_ADC_SPIKE,        // Occasional conversions far off
+    FAULT_ENC_DROP,         // Encoder edges whose interrupt is lost
+    FAULT_ENC_DUP,          // Encoder edges that bounce, so are seen three times
+    FAULT_PWM_SAT,          // Rotors that give out below full duty
+    FAULT_REF_DELAY,        // PC4 pulses late
+    FAULT_REF_MISS,         // PC4 pulses missing
+    NUM_FAULTS
+} faultClass_t;
+
+// *******************************************************
+// What to fly
+typedef struct {
+    uint32_t seconds;       // Flight length
+    uint32_t seed;          // 0 for the nominal rig, else a random start
+    faultClass_t fault;
+    bool special;           // Fly a spiral up in Special mode before landing
+    bool trace;             // Print each mode change
+    bool verbose;           // Print the model every 100 ms
+    FILE *hoverLog;         // Fly a hover survey instead, logging each steady
+                            // hover as genSchedule reads it, NULL for none
+} flightConfig_t;
+
+// *******************************************************
+// How it went
+typedef struct {
+    bool flew;              // Reached Flying
+    bool landed;            // Landed and on the ground at the end
+    double severity;        // Of the fault, in its own units, see flightFaultUnit
+    double maxAlt;          // %
+    double overshoot;       // Worst altitude above the reference in flight, %
+    double heading;         // Yaw from the reference when it landed, degrees
+    uint32_t timeToLandMs;  // Switch down to Landed, 0 if it never landed
+    uint32_t calibratedMs;  // Power on to the ground calibrated, so ready to
+                            // arm, 0 if it never was
+    uint32_t writes;        // PWM compare writes
+    uint64_t checksum;      // Of every PWM compare write and its time
+    rtosStats_t rtos;
+    deadlineStats_t deadline;
+} flightResult_t;
+
+// *******************************************************
+// flightRun:           Flies the whole firmware once. Not reentrant.
+// RETURNS:             false if the tasks could not be created
+bool
+flightRun (const flightConfig_t *config, flightResult_t *result);
+
+// *******************************************************
+// flightRunContext:    Flies the flight logic once on a context of its own.
+//                      Safe from any number of threads at once. No hover
+//                      survey is logged.
+// RETURNS:             false if there was no memory for the context
+bool
+flightRunContext (const flightConfig_t *config, flightResult_t *result);
+
+// *******************************************************
+// flightFaultName:     RETURNS the short name of a fault class, e.g. "enc-drop"
+const char *
+flightFaultName (faultClass_t fault);
+
+// *******************************************************
+// flightFaultUnit:     RETURNS the unit of a fault class's severity
+const char *
+flightFaultUnit (faultClass_t fault);
+
+// *******************************************************
+// flightFaultFind:     RETURNS the fault class with the given short name, or
+//                      NUM_FAULTS if there is none
+faultClass_t
+flightFaultFind (const char *name);
+
+#endif /* FLIGHT_H_ */
@@ -0,0 +1,136 @@
+//*****************************************************************************
+//
+// flysim - Flies the firmware, tasks and all, against a model of the rig in
+//          virtual time, see flight.h. hostRtos runs it as a discrete event
+//          simulation, so only the instants where something happens are
+//          simulated and a minute of flight takes milliseconds.
+//
+//          Usage:  flysim [-v] [-m] [-c] [-H hover.log] [-t seconds] [-s seed]
+//                         [-f fault]
+//
+//          -v          trace the model every 100 ms
+//          -m          fly the spiral up in Special mode
+//          -c          fly the flight logic alone on a context, as campaign
+//                      does, rather than the whole firmware
+//          -H          fly a hover survey from 50% down to 10% and up to
+//                      100% instead, logging each steady hover for
+//                      genSchedule; the whole survey needs -t 360
+//          -t          flight length, default 60 s
+//          -s          random start and fault severity, default 0, the
+//                      nominal rig
+//          -f          fault class to inject, as campaign names them
+//
+//          Mode changes are printed as they happen. The exit status is 0
+//          if the helicopter flew and was back on the ground at the end.
+//          A flight campaign reports can be flown again with -c and its -s
+//          and -f.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flight.h"
+
+#define DEFAULT_SECONDS     60
+
+
+int main(int argc, char *argv[])
+{
+    flightConfig_t config = {DEFAULT_SECONDS, 0, FAULT_NONE, false, true, false, NULL};
+    const char *hoverName = NULL;
+    bool context = false;
+    flightResult_t result;
+    struct timespec start, stop;
+    uint32_t endMs;
+    double wall;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        if (strcmp(argv[argi], "-v") == 0)
+        {
+            config.verbose = true;
+        } else if (strcmp(argv[argi], "-m") == 0) {
+            config.special = true;
+        } else if (strcmp(argv[argi], "-c") == 0) {
+            context = true;
+        } else if (strcmp(argv[argi], "-H") == 0 && argi + 1 < argc) {
+            hoverName = argv[++argi];
+        } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) {
+            config.seconds = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) {
+            config.seed = strtoul(argv[++argi], NULL, 0);
+        } else if (strcmp(argv[argi], "-f") == 0 && argi + 1 < argc &&
+                   (config.fault = flightFaultFind(argv[++argi])) != NUM_FAULTS) {
+            continue;
+        } else {
+            fprintf(stderr, "usage: %s [-v] [-m] [-c] [-H hover.log] [-t seconds] [-s seed] "
+                    "[-f fault]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (context && hoverName != NULL)
+    {
+        fprintf(stderr, "flysim: a hover survey needs the whole firmware, not -c\n");
+        return 2;
+    }
+    if (hoverName != NULL && (config.hoverLog = fopen(hoverName, "w")) == NULL)
+    {
+        perror(hoverName);
+        return 2;
+    }
+    endMs = config.seconds * 1000;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (context ? !flightRunContext(&config, &result) : !flightRun(&config, &result))
+    {
+        fprintf(stderr, "flysim: cannot %s\n",
+                context ? "allocate the context" : "create the tasks");
+        return 2;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (config.hoverLog != NULL)
+    {
+        fclose(config.hoverLog);
+    }
+
+    wall = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+    fprintf(stderr, "flysim: %u ms simulated in %.3f ms (%.0fx real time)\n",
+            endMs, wall * 1e3, wall > 0 ? endMs / (wall * 1e3) : 0.0);
+    if (!context)
+    {
+        fprintf(stderr, "flysim: %llu events, %llu timer callbacks, %llu task switches, "
+                "%llu time jumps\n", (unsigned long long)result.rtos.events,
+                (unsigned long long)result.rtos.timers, (unsigned long long)result.rtos.switches,
+                (unsigned long long)result.rtos.jumps);
+        fprintf(stderr, "flysim: %u control cycles, %u period and %u exec misses, "
+                "%u stalls, worst period %u ms\n", result.deadline.cycles,
+                result.deadline.periodMisses, result.deadline.execMisses,
+                result.deadline.stalls, result.deadline.worstPeriodMs);
+    }
+    if (result.calibratedMs > 0)
+    {
+        fprintf(stderr, "flysim: ground calibrated, ready to arm, %u ms after power on\n",
+                result.calibratedMs);
+    }
+    if (config.fault != FAULT_NONE)
+    {
+        fprintf(stderr, "flysim: %s at %.1f %s\n", flightFaultName(config.fault),
+                result.severity, flightFaultUnit(config.fault));
+    }
+    if (result.timeToLandMs > 0)
+    {
+        fprintf(stderr, "flysim: landed in %u ms, %.1f deg off the reference, "
+                "worst overshoot %.1f%%\n", result.timeToLandMs, result.heading,
+                result.overshoot);
+    }
+    printf("# %s, highest %.1f%%, writes %u checksum %016llx\n",
+           result.flew && result.landed ? "flew and landed" :
+           result.flew ? "flew, not landed" : "never flew",
+           result.maxAlt, result.writes, (unsigned long long)result.checksum);
+    return result.flew && result.landed ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+//*****************************************************************************
+//
+// genSchedule - Generates altScheduleTable.c, the altitude dependent hover
+//               duty and PID gain table used by the altitude controller,
+//               from logged hover data.
+//
+//          Usage:  genSchedule [-r hover%] [-g kp,ki,kd] [hover.log]
+//                              > ../Blink/altScheduleTable.c
+//
+//          Each log line is "<altitude %> <main duty %>", taken while the
+//          helicopter holds a steady hover; '#' starts a comment. Samples
+//          are grouped at the nearest 10% altitude and the median duty of
+//          each group becomes the hover duty there. Altitudes with no
+//          samples are interpolated from their neighbours.
+//
+//          Thrust rises with duty squared, so the plant gain at a given
+//          altitude is roughly proportional to the hover duty there. The
+//          base gains (-g, tuned at the hover duty given by -r) are scaled
+//          by reference hover / local hover to keep the loop gain uniform.
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "altSchedule.h"
+
+#define MAX_SAMPLES         100000
+#define BIN_PERCENT         (ALT_SCHED_STEP / 100)
+#define SCALE_MIN           0.5     // Limits on the gain scaling
+#define SCALE_MAX           2.0
+
+// Defaults match the fixed values the controller used before scheduling
+#define DEFAULT_HOVER       45.0
+#define DEFAULT_KP          0.5
+#define DEFAULT_KI          0.03
+#define DEFAULT_KD          0.2
+
+static double *samples[ALT_SCHED_POINTS];
+static int numSamples[ALT_SCHED_POINTS];
+
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+// *******************************************************
+// readLog:             Groups the hover samples of a log by altitude
+static void readLog(FILE *file)
+{
+    char line[256];
+    double alt, duty;
+    int bin;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (line[0] == '#' || sscanf(line, "%lf %lf", &alt, &duty) != 2)
+        {
+            continue;
+        }
+        bin = (int)((alt + BIN_PERCENT / 2.0) / BIN_PERCENT);
+        if (alt < -BIN_PERCENT / 2.0 || bin >= ALT_SCHED_POINTS ||
+            duty <= 0.0 || duty >= 100.0 || numSamples[bin] >= MAX_SAMPLES)
+        {
+            continue;
+        }
+        if (samples[bin] == NULL)
+        {
+            samples[bin] = malloc(MAX_SAMPLES * sizeof(double));
+        }
+        samples[bin][numSamples[bin]++] = duty;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    double hover[ALT_SCHED_POINTS];
+    bool known[ALT_SCHED_POINTS];
+    double reference = DEFAULT_HOVER;
+    double kp = DEFAULT_KP, ki = DEFAULT_KI, kd = DEFAULT_KD;
+    const char *source = "no data, defaults";
+    int i, j, total = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            reference = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf,%lf,%lf", &kp, &ki, &kd) != 3)
+            {
+                fprintf(stderr, "genSchedule: -g wants kp,ki,kd\n");
+                return 1;
+            }
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: genSchedule [-r hover%%] [-g kp,ki,kd] [hover.log]\n");
+            return 1;
+        } else {
+            FILE *file = fopen(argv[i], "r");
+            if (file == NULL)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+            readLog(file);
+            fclose(file);
+            source = argv[i];
+        }
+    }
+
+    // Median duty of each altitude
+    for (i = 0; i < ALT_SCHED_POINTS; i++)
+    {
+        known[i] = numSamples[i] > 0;
+        total += numSamples[i];
+        if (known[i])
+        {
+            qsort(samples[i], numSamples[i], sizeof(double), compareDouble);
+            hover[i] = (numSamples[i] & 1) ? samples[i][numSamples[i] / 2] :
+                (samples[i][numSamples[i] / 2 - 1] + samples[i][numSamples[i] / 2]) / 2;
+        }
+    }
+
+    // Fill the gaps: interpolate between known altitudes, hold at the ends
+    for (i = 0; i < ALT_SCHED_POINTS; i++)
+    {
+        int below = -1, above = -1;
+
+        if (known[i])
+        {
+            continue;
+        }
+        for (j = i - 1; j >= 0 && below < 0; j--)
+        {
+            below = known[j] ? j : -1;
+        }
+        for (j = i + 1; j < ALT_SCHED_POINTS && above < 0; j++)
+        {
+            above = known[j] ? j : -1;
+        }
+        if (below >= 0 && above >= 0)
+        {
+            hover[i] = hover[below] + (hover[above] - hover[below]) *
+                       (i - below) / (above - below);
+        } else if (below >= 0) {
+            hover[i] = hover[below];
+        } else if (above >= 0) {
+            hover[i] = hover[above];
+        } else {
+            hover[i] = reference;
+        }
+    }
+
+    printf("//*****************************************************************************\n"
+           "//\n"
+           "// altScheduleTable - Altitude schedule used by PIDControlAlt.\n"
+           "//                    GENERATED by host/genSchedule, do not edit.\n"
+           "//\n"
+           "// Source:          %s (%d samples)\n"
+           "// Reference hover: %.1f%%, gains %.3f %.3f %.3f\n"
+           "//*****************************************************************************\n"
+           "\n"
+           "#include <stdint.h>\n"
+           "\n"
+           "#include \"altSchedule.h\"\n"
+           "\n"
+           "const altSchedulePoint_t altScheduleTable[ALT_SCHED_POINTS] = {\n"
+           "//   hover    kp        ki        kd             altitude\n",
+           source, total, reference, kp, ki, kd);
+
+    for (i = 0; i < ALT_SCHED_POINTS; i++)
+    {
+        double scale = reference / hover[i];
+
+        if (scale < SCALE_MIN)
+        {
+            scale = SCALE_MIN;
+        } else if (scale > SCALE_MAX) {
+            scale = SCALE_MAX;
+        }
+        printf("    {%4d, %.4ff, %.4ff, %.4ff},   // %3d%%%s\n",
+               (int)(hover[i] * 10 + 0.5), kp * scale, ki * scale, kd * scale,
+               i * BIN_PERCENT, (known[i] || total == 0) ? "" : " (interpolated)");
+    }
+    printf("};\n");
+
+    for (i = 0; i < ALT_SCHED_POINTS; i++)
+    {
+        free(samples[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,620 @@
+//*****************************************************************************
+//
+// hostHal - Simulated TM4C123 peripherals for the host build. Holds the pin
+//           levels, the ADC result and the PWM registers the firmware reads
+//           and writes through driverlib, and dispatches GPIO edge interrupts
+//           to the handlers the firmware registered.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hostHw.h"
+#include "hostHal.h"
+
+#define NUM_PORTS           6
+#define NUM_REGS            64
+#define HOST_CLOCK_HZ       80000000
+
+// *******************************************************
+// Simulated GPIO port
+typedef struct {
+    uint32_t base;
+    uint8_t level;          // Pin levels
+    uint8_t intEnable;      // GPIOIntEnable mask
+    uint8_t bothEdges;      // Pins interrupting on both edges
+    uint8_t risingEdge;     // Pins interrupting on a rising edge only
+    uint8_t intStatus;      // Latched interrupt flags
+    uint32_t nvicInt;
+    void (*handler)(void);
+} halPort_t;
+
+// *******************************************************
+// Register file for HWREG() accesses, looked up by address
+typedef struct {
+    uint32_t address;
+    volatile uint32_t value;
+} halReg_t;
+
+static halPort_t ports[NUM_PORTS];
+static halReg_t regs[NUM_REGS];
+static bool nvicEnabled[128];
+static bool masterEnabled;
+static uint32_t primask;
+static uint32_t adcValues[8];           // Result of each sequencer step
+static uint8_t adcSteps[4] = {1, 1, 1, 1};  // Steps up to ADC_CTL_END
+static uint8_t adcReady;                // Sequences with results to read
+static uint8_t adcIntEnable, adcIntStatus;
+static uint32_t adcAverage = 1;         // Hardware averaging per conversion
+static void (*adcHandlers[4])(void);
+static uint32_t mainWidth, mainPeriod, tailWidth, tailPeriod;
+static uint32_t mainPending, tailPending;   // Compare writes awaiting a sync
+static bool mainPendingValid, tailPendingValid;
+static bool mainSync, tailSync;             // Generator in synchronous mode
+static bool resetRequested;
+static halPwmHook_t pwmHook;
+static halUartHook_t uartHook;
+static halAdcHook_t adcHook;
+static halAdcSource_t adcSource;
+
+static const uint32_t portBases[NUM_PORTS] = {
+    GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE,
+    GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE
+};
+static const uint32_t portInts[NUM_PORTS] = {
+    INT_GPIOA, INT_GPIOB, INT_GPIOC, INT_GPIOD, INT_GPIOE, INT_GPIOF
+};
+
+
+static halPort_t *findPort(uint32_t ui32Port)
+{
+    int i;
+    for (i = 0; i < NUM_PORTS; i++)
+    {
+        if (ports[i].base == ui32Port)
+        {
+            return &ports[i];
+        }
+    }
+    return &ports[0];
+}
+
+
+// *******************************************************
+// dispatch:            Runs a port's handler while it has flags pending,
+//                      as the NVIC would
+static void dispatch(halPort_t *port)
+{
+    int guard = 8;
+
+    while (port->intStatus & port->intEnable && port->handler != NULL &&
+           nvicEnabled[port->nvicInt] && masterEnabled && !primask &&
+           guard-- > 0)
+    {
+        port->handler();
+    }
+}
+
+
+void halReset (void)
+{
+    int i;
+
+    memset(ports, 0, sizeof(ports));
+    memset((void *)regs, 0, sizeof(regs));
+    memset(nvicEnabled, 0, sizeof(nvicEnabled));
+    for (i = 0; i < NUM_PORTS; i++)
+    {
+        ports[i].base = portBases[i];
+        ports[i].nvicInt = portInts[i];
+    }
+    masterEnabled = false;
+    primask = 0;
+    memset(adcValues, 0, sizeof(adcValues));
+    memset(adcSteps, 1, sizeof(adcSteps));
+    adcReady = adcIntEnable = adcIntStatus = 0;
+    adcAverage = 1;
+    memset(adcHandlers, 0, sizeof(adcHandlers));
+    mainWidth = mainPeriod = tailWidth = tailPeriod = 0;
+    mainPending = tailPending = 0;
+    mainPendingValid = tailPendingValid = false;
+    mainSync = tailSync = false;
+    resetRequested = false;
+}
+
+
+void halSetPins (uint32_t ui32Port, uint8_t ui8Pins, bool bHigh)
+{
+    halPort_t *port = findPort(ui32Port);
+    uint8_t old = port->level;
+    uint8_t changed, rising, falling;
+
+    port->level = bHigh ? (old | ui8Pins) : (old & ~ui8Pins);
+    changed = old ^ port->level;
+    rising = changed & port->level;
+    falling = changed & ~port->level;
+
+    port->intStatus |= changed & port->bothEdges;
+    port->intStatus |= rising & port->risingEdge & ~port->bothEdges;
+    port->intStatus |= falling & ~port->risingEdge & ~port->bothEdges;
+    dispatch(port);
+}
+
+
+uint8_t halGetPins (uint32_t ui32Port)
+{
+    return findPort(ui32Port)->level;
+}
+
+
+void halSetAdc (uint32_t ui32Value)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        adcValues[i] = ui32Value;
+    }
+    adcReady = 0x0F;
+}
+
+
+void halSetAdcSum (uint32_t ui32Sum, uint32_t ui32Steps)
+{
+    uint32_t i;
+
+    // Spread the sum so the first ui32Steps results add back up to it
+    for (i = 0; i < 8; i++)
+    {
+        adcValues[i] = (ui32Sum + (i % ui32Steps)) / ui32Steps;
+    }
+    adcReady = 0x0F;
+}
+
+
+void halAdcComplete (uint32_t ui32SequenceNum)
+{
+    uint8_t seq = ui32SequenceNum & 3;
+    uint32_t i;
+
+    if (adcSource != NULL)
+    {
+        for (i = 0; i < adcSteps[seq]; i++)
+        {
+            adcValues[i] = adcSource(i);
+        }
+    }
+    adcReady |= 1 << seq;
+    adcIntStatus |= 1 << seq;
+    if (adcIntEnable & (1 << seq) && adcHandlers[seq] != NULL &&
+        nvicEnabled[INT_ADC0SS0 + seq] && masterEnabled && !primask)
+    {
+        adcHandlers[seq]();
+    }
+}
+
+
+uint32_t halPulseWidth (uint32_t ui32Base)
+{
+    return (ui32Base == PWM0_BASE) ? mainWidth : tailWidth;
+}
+
+
+uint32_t halPeriod (uint32_t ui32Base)
+{
+    return (ui32Base == PWM0_BASE) ? mainPeriod : tailPeriod;
+}
+
+
+bool halResetRequested (void)
+{
+    return resetRequested;
+}
+
+
+void halSetPwmHook (halPwmHook_t pfnHook)
+{
+    pwmHook = pfnHook;
+}
+
+
+void halSetUartHook (halUartHook_t pfnHook)
+{
+    uartHook = pfnHook;
+}
+
+
+void halSetAdcHook (halAdcHook_t pfnHook)
+{
+    adcHook = pfnHook;
+}
+
+
+void halSetAdcSource (halAdcSource_t pfnSource)
+{
+    adcSource = pfnSource;
+}
+
+
+volatile uint32_t *hostReg(uint32_t ui32Address)
+{
+    uint32_t i = (ui32Address >> 2) % NUM_REGS;
+
+    while (regs[i].address != 0 && regs[i].address != ui32Address)
+    {
+        i = (i + 1) % NUM_REGS;
+    }
+    regs[i].address = ui32Address;
+    return &regs[i].value;
+}
+
+
+//*****************************************************************************
+// driverlib/sysctl.h
+//*****************************************************************************
+void SysCtlClockSet(uint32_t ui32Config) { (void)ui32Config; }
+uint32_t SysCtlClockGet(void) { return HOST_CLOCK_HZ; }
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral) { (void)ui32Peripheral; return true; }
+void SysCtlPeripheralReset(uint32_t ui32Peripheral) { (void)ui32Peripheral; }
+void SysCtlPWMClockSet(uint32_t ui32Config) { (void)ui32Config; }
+void SysCtlReset(void) { resetRequested = true; }
+void SysCtlDelay(uint32_t ui32Count) { (void)ui32Count; }
+
+//*****************************************************************************
+// driverlib/gpio.h
+//*****************************************************************************
+void GPIODirModeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32PinIO)
+{ (void)ui32Port; (void)ui8Pins; (void)ui32PinIO; }
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength,
+                      uint32_t ui32PadType)
+{ (void)ui32Port; (void)ui8Pins; (void)ui32Strength; (void)ui32PadType; }
+void GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinTypeSSI(uint32_t ui32Port, uint8_t ui8Pins) { (void)ui32Port; (void)ui8Pins; }
+void GPIOPinConfigure(uint32_t ui32PinConfig) { (void)ui32PinConfig; }
+
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return findPort(ui32Port)->level & ui8Pins;
+}
+
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    halPort_t *port = findPort(ui32Port);
+    port->level = (port->level & ~ui8Pins) | (ui8Val & ui8Pins);
+}
+
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType)
+{
+    halPort_t *port = findPort(ui32Port);
+
+    port->bothEdges &= ~ui8Pins;
+    port->risingEdge &= ~ui8Pins;
+    if (ui32IntType == GPIO_BOTH_EDGES)
+    {
+        port->bothEdges |= ui8Pins;
+    } else if (ui32IntType == GPIO_RISING_EDGE) {
+        port->risingEdge |= ui8Pins;
+    }
+}
+
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    findPort(ui32Port)->intEnable |= ui32IntFlags;
+}
+
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    findPort(ui32Port)->intEnable &= ~ui32IntFlags;
+}
+
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    findPort(ui32Port)->intStatus &= ~ui32IntFlags;
+}
+
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked)
+{
+    halPort_t *port = findPort(ui32Port);
+    return bMasked ? (port->intStatus & port->intEnable) : port->intStatus;
+}
+
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void))
+{
+    findPort(ui32Port)->handler = pfnIntHandler;
+}
+
+//*****************************************************************************
+// driverlib/adc.h
+//*****************************************************************************
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                          uint32_t ui32Trigger, uint32_t ui32Priority)
+{ (void)ui32Base; (void)ui32SequenceNum; (void)ui32Trigger; (void)ui32Priority; }
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                              uint32_t ui32Step, uint32_t ui32Config)
+{
+    (void)ui32Base;
+    if (ui32Config & ADC_CTL_END)
+    {
+        adcSteps[ui32SequenceNum & 3] = ui32Step + 1;
+    }
+}
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{ (void)ui32Base; (void)ui32SequenceNum; }
+
+int32_t ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                           uint32_t *pui32Buffer)
+{
+    uint8_t seq = ui32SequenceNum & 3;
+
+    // An empty FIFO until the sequence completes, and emptied by the read
+    (void)ui32Base;
+    if (!(adcReady & (1 << seq)))
+    {
+        return 0;
+    }
+    adcReady &= ~(1 << seq);
+    memcpy(pui32Buffer, adcValues, adcSteps[seq] * sizeof(uint32_t));
+    return adcSteps[seq];
+}
+
+// Each conversion takes 1 us at 1 Msps, times the hardware averaging
+void ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    uint8_t seq = ui32SequenceNum & 3;
+
+    (void)ui32Base;
+    if (adcHook != NULL)
+    {
+        adcHook(seq, adcSteps[seq] * adcAverage);
+    }
+}
+void ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                    void (*pfnHandler)(void))
+{
+    (void)ui32Base;
+    adcHandlers[ui32SequenceNum & 3] = pfnHandler;
+    nvicEnabled[INT_ADC0SS0 + (ui32SequenceNum & 3)] = true;
+}
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{ (void)ui32Base; adcIntEnable |= 1 << (ui32SequenceNum & 3); }
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{ (void)ui32Base; adcIntStatus &= ~(1 << (ui32SequenceNum & 3)); }
+void ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor)
+{ (void)ui32Base; adcAverage = ui32Factor ? ui32Factor : 1; }
+
+//*****************************************************************************
+// driverlib/pwm.h
+//*****************************************************************************
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config)
+{
+    (void)ui32Gen;
+    if (ui32Base == PWM0_BASE)
+    {
+        mainSync = (ui32Config & PWM_GEN_MODE_SYNC) != 0;
+    } else {
+        tailSync = (ui32Config & PWM_GEN_MODE_SYNC) != 0;
+    }
+}
+
+// *******************************************************
+// commitWidth:         The new compare value reaches the output
+static void commitWidth(uint32_t ui32Base, uint32_t ui32Width)
+{
+    if (ui32Base == PWM0_BASE)
+    {
+        mainWidth = ui32Width;
+    } else {
+        tailWidth = ui32Width;
+    }
+    if (pwmHook != NULL)
+    {
+        pwmHook(ui32Base, ui32Width, halPeriod(ui32Base));
+    }
+}
+
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period)
+{
+    (void)ui32Gen;
+    if (ui32Base == PWM0_BASE)
+    {
+        mainPeriod = ui32Period;
+    } else {
+        tailPeriod = ui32Period;
+    }
+}
+
+uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    (void)ui32Gen;
+    return halPeriod(ui32Base);
+}
+
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen) { (void)ui32Base; (void)ui32Gen; }
+
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width)
+{
+    (void)ui32PWMOut;
+
+    // In synchronous mode the write waits for PWMSyncUpdate
+    if (ui32Base == PWM0_BASE && mainSync)
+    {
+        mainPending = ui32Width;
+        mainPendingValid = true;
+    } else if (ui32Base != PWM0_BASE && tailSync) {
+        tailPending = ui32Width;
+        tailPendingValid = true;
+    } else {
+        commitWidth(ui32Base, ui32Width);
+    }
+}
+
+uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut)
+{
+    (void)ui32PWMOut;
+    return halPulseWidth(ui32Base);
+}
+
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable)
+{ (void)ui32Base; (void)ui32PWMOutBits; (void)bEnable; }
+void PWMSyncUpdate(uint32_t ui32Base, uint32_t ui32GenBits)
+{
+    (void)ui32GenBits;
+    if (ui32Base == PWM0_BASE && mainPendingValid)
+    {
+        mainPendingValid = false;
+        commitWidth(ui32Base, mainPending);
+    } else if (ui32Base != PWM0_BASE && tailPendingValid) {
+        tailPendingValid = false;
+        commitWidth(ui32Base, tailPending);
+    }
+}
+
+//*****************************************************************************
+// driverlib/uart.h
+//*****************************************************************************
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk,
+                         uint32_t ui32Baud, uint32_t ui32Config)
+{ (void)ui32Base; (void)ui32UARTClk; (void)ui32Baud; (void)ui32Config; }
+void UARTFIFOEnable(uint32_t ui32Base) { (void)ui32Base; }
+void UARTEnable(uint32_t ui32Base) { (void)ui32Base; }
+
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+{
+    (void)ui32Base;
+    if (uartHook != NULL)
+    {
+        uartHook(ucData);
+    }
+}
+
+bool UARTCharsAvail(uint32_t ui32Base) { (void)ui32Base; return false; }
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base) { (void)ui32Base; return -1; }
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{ (void)ui32Base; (void)pfnHandler; }
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{ (void)ui32Base; (void)ui32IntFlags; }
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked)
+{ (void)ui32Base; (void)bMasked; return 0; }
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{ (void)ui32Base; (void)ui32IntFlags; }
+
+//*****************************************************************************
+// driverlib/ssi.h, driverlib/timer.h. These go through HWREG() as TivaWare's
+// do; the status register is set up ready once, so a transfer never waits.
+//*****************************************************************************
+void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk,
+                        uint32_t ui32Protocol, uint32_t ui32Mode,
+                        uint32_t ui32BitRate, uint32_t ui32DataWidth)
+{ (void)ui32Base; (void)ui32SSIClk; (void)ui32Protocol; (void)ui32Mode;
+  (void)ui32BitRate; (void)ui32DataWidth; }
+void SSIClockSourceSet(uint32_t ui32Base, uint32_t ui32Source) { (void)ui32Base; (void)ui32Source; }
+
+void SSIEnable(uint32_t ui32Base)
+{
+    HWREG(ui32Base + SSI_O_SR) = SSI_SR_TNF | SSI_SR_RNE;
+}
+
+bool SSIBusy(uint32_t ui32Base)
+{
+    return (HWREG(ui32Base + SSI_O_SR) & SSI_SR_BSY) ? true : false;
+}
+
+void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data)
+{
+    while (!(HWREG(ui32Base + SSI_O_SR) & SSI_SR_TNF));
+    HWREG(ui32Base + SSI_O_DR) = ui32Data;
+}
+
+void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data)
+{
+    while (!(HWREG(ui32Base + SSI_O_SR) & SSI_SR_RNE));
+    *pui32Data = HWREG(ui32Base + SSI_O_DR);
+}
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config) { (void)ui32Base; (void)ui32Config; }
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer) { (void)ui32Base; (void)ui32Timer; }
+
+uint32_t TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    (void)ui32Timer;
+    return HWREG(ui32Base + TIMER_O_TAV)++;
+}
+
+//*****************************************************************************
+// driverlib/watchdog.h. The watchdog never times out on the host; the
+// firmware's own monitor decides when it would stop being fed.
+//*****************************************************************************
+void WatchdogReloadSet(uint32_t ui32Base, uint32_t ui32LoadVal) { (void)ui32Base; (void)ui32LoadVal; }
+void WatchdogResetEnable(uint32_t ui32Base) { (void)ui32Base; }
+void WatchdogStallEnable(uint32_t ui32Base) { (void)ui32Base; }
+void WatchdogIntRegister(uint32_t ui32Base, void (*pfnHandler)(void)) { (void)ui32Base; (void)pfnHandler; }
+void WatchdogIntClear(uint32_t ui32Base) { (void)ui32Base; }
+void WatchdogEnable(uint32_t ui32Base) { (void)ui32Base; }
+
+//*****************************************************************************
+// driverlib/interrupt.h, driverlib/cpu.h
+//*****************************************************************************
+bool IntMasterEnable(void)
+{
+    bool wasDisabled = !masterEnabled;
+    int i;
+
+    masterEnabled = true;
+    for (i = 0; i < NUM_PORTS; i++)
+    {
+        dispatch(&ports[i]);
+    }
+    return wasDisabled;
+}
+
+bool IntMasterDisable(void)
+{
+    bool wasDisabled = !masterEnabled;
+    masterEnabled = false;
+    return wasDisabled;
+}
+
+void IntEnable(uint32_t ui32Interrupt) { nvicEnabled[ui32Interrupt & 127] = true; }
+void IntDisable(uint32_t ui32Interrupt) { nvicEnabled[ui32Interrupt & 127] = false; }
+// GPIO and ADC interrupts are routed to their peripheral, as
+// GPIOIntRegister and ADCIntRegister do. The UART and watchdog handlers are
+// driven directly by the harness.
+void IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void))
+{
+    int i;
+
+    if (ui32Interrupt >= INT_ADC0SS0 && ui32Interrupt <= INT_ADC0SS3)
+    {
+        adcHandlers[ui32Interrupt - INT_ADC0SS0] = pfnHandler;
+    }
+    for (i = 0; i < NUM_PORTS; i++)
+    {
+        if (ports[i].nvicInt == ui32Interrupt)
+        {
+            ports[i].handler = pfnHandler;
+        }
+    }
+}
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority)
+{ (void)ui32Interrupt; (void)ui8Priority; }
+
+uint32_t CPUcpsid(void)
+{
+    uint32_t old = primask;
+    primask = 1;
+    return old;
+}
+
+uint32_t CPUcpsie(void)
+{
+    uint32_t old = primask;
+    primask = 0;
+    return old;
+}
+
+void CPUwfi(void) { }
@@ -0,0 +1,96 @@
+#ifndef HOSTHAL_H_
+#define HOSTHAL_H_
+
+//*****************************************************************************
+//
+// hostHal - Simulated TM4C123 peripherals for the host build. Holds the pin
+//           levels, the ADC result and the PWM registers the firmware reads
+//           and writes through driverlib, and dispatches GPIO edge and ADC
+//           interrupts to the handlers the firmware registered.
+//
+//           An ADC sequence has results to read only once it completes:
+//           straight away for halSetAdc and halSetAdcSum, or when the
+//           harness calls halAdcComplete for a conversion it was told of
+//           through the ADC hook.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Called whenever the firmware writes a PWM compare value
+typedef void (*halPwmHook_t)(uint32_t ui32Base, uint32_t ui32Width,
+                             uint32_t ui32Period);
+
+// Called for every character the firmware sends on the UART
+typedef void (*halUartHook_t)(unsigned char ucData);
+
+// Called when the firmware triggers an ADC sequence, with the time the
+// conversions take; the harness calls halAdcComplete once they are done
+typedef void (*halAdcHook_t)(uint32_t ui32SequenceNum, uint32_t ui32ConversionUs);
+
+// Gives the result of each step of a completing ADC sequence
+typedef uint32_t (*halAdcSource_t)(uint32_t ui32Step);
+
+// *******************************************************
+// halReset:            Returns every simulated register to its power on state
+void
+halReset (void);
+
+// *******************************************************
+// halSetPins:          Drives the given pins of a port high or low. Any enabled
+//                      edge interrupt is dispatched before returning.
+void
+halSetPins (uint32_t ui32Port, uint8_t ui8Pins, bool bHigh);
+
+// *******************************************************
+// halGetPins:          RETURNS the current pin levels of a port
+uint8_t
+halGetPins (uint32_t ui32Port);
+
+// *******************************************************
+// halSetAdc:           Sets the value every step of the next ADC sequence returns
+void
+halSetAdc (uint32_t ui32Value);
+
+// *******************************************************
+// halSetAdcSum:        Sets step results for the next ADC sequence that add up
+//                      to ui32Sum over the first ui32Steps steps, for replaying
+//                      oversampled sums
+void
+halSetAdcSum (uint32_t ui32Sum, uint32_t ui32Steps);
+
+// *******************************************************
+// halAdcComplete:      Completes an ADC sequence: takes its results from the
+//                      ADC source if there is one, then raises its interrupt,
+//                      running the handler if it is enabled
+void
+halAdcComplete (uint32_t ui32SequenceNum);
+
+// *******************************************************
+// halPulseWidth:       RETURNS the last compare value written to a PWM module
+uint32_t
+halPulseWidth (uint32_t ui32Base);
+
+// *******************************************************
+// halPeriod:           RETURNS the last period written to a PWM module
+uint32_t
+halPeriod (uint32_t ui32Base);
+
+// *******************************************************
+// halResetRequested:   RETURNS true if the firmware called SysCtlReset
+bool
+halResetRequested (void);
+
+void
+halSetPwmHook (halPwmHook_t pfnHook);
+
+void
+halSetUartHook (halUartHook_t pfnHook);
+
+void
+halSetAdcHook (halAdcHook_t pfnHook);
+
+void
+halSetAdcSource (halAdcSource_t pfnSource);
+
+#endif /* HOSTHAL_H_ */
@@ -0,0 +1,830 @@
+//*****************************************************************************
+//
+// hostRtos - Virtual time stand-in for the FreeRTOS calls made by the
+//            firmware modules, run as a discrete event simulation. Tasks are
+//            ucontext coroutines switched only by the kernel, so one task
+//            runs at a time and nothing needs locking. See hostRtos.h.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+#include "hostRtos.h"
+
+#define MAX_QUEUES          8
+#define MAX_TIMERS          16
+#define MAX_TASKS           8
+#define TASK_STACK_BYTES    (256 * 1024)    // The firmware's depths are for the target
+#define FOREVER             UINT64_MAX
+
+enum taskState {TASK_UNUSED = 0, TASK_READY, TASK_BLOCKED, TASK_DELETED};
+enum waitReason {WAIT_DELAY, WAIT_NOTIFY, WAIT_QUEUE};
+
+struct tskTaskControlBlock {
+    uint32_t notifyCount;
+
+    // Tasks made by xTaskCreate only
+    uint8_t state;
+    uint8_t waitReason;
+    UBaseType_t priority;
+    uint32_t readySeq;              // Order made ready, oldest runs first
+    uint64_t wakeAt;                // End of a delay or timeout, or FOREVER
+    bool timedOut;                  // The last wait ran to wakeAt
+    QueueHandle_t waitQueue;
+    TaskFunction_t code;
+    void *parameters;
+    void *stack;
+    ucontext_t context;
+};
+
+struct QueueDefinition {
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *storage;
+};
+
+struct tmrTimerControl {
+    TickType_t period;
+    uint64_t expiry;                // In ticks since rtosReset
+    bool active;
+    bool autoReload;
+    void *id;
+    TimerCallbackFunction_t callback;
+};
+
+// *******************************************************
+// An event queued by rtosAt, kept in a heap on (at, seq)
+typedef struct {
+    uint64_t at;
+    uint64_t seq;
+    rtosEventFn_t fn;
+    void *param;
+    uint32_t arg;
+} rtosEvent_t;
+
+static struct tskTaskControlBlock tasks[MAX_TASKS];
+static struct QueueDefinition queues[MAX_QUEUES];
+static struct tmrTimerControl timers[MAX_TIMERS];
+static int numQueues, numTimers;
+static uint64_t nowUs;
+
+static struct tskTaskControlBlock *current;     // Running task, NULL outside tasks
+static ucontext_t kernelContext;
+static uint32_t readySeq;
+
+static rtosEvent_t *events;
+static size_t numEvents, maxEvents;
+static uint64_t eventSeq;
+static rtosStats_t stats;
+
+
+// *******************************************************
+// notScheduled:        Only a task can wait; reaching a blocking call outside
+//                      one means a task body was called by the harness.
+static void notScheduled(const char *name)
+{
+    fprintf(stderr, "hostRtos: %s called outside a task\n", name);
+    abort();
+}
+
+
+static uint64_t nowTicks(void)
+{
+    return nowUs / RTOS_US_PER_TICK;
+}
+
+
+//*****************************************************************************
+// Event heap
+//*****************************************************************************
+static bool eventBefore(const rtosEvent_t *a, const rtosEvent_t *b)
+{
+    return a->at < b->at || (a->at == b->at && a->seq < b->seq);
+}
+
+static void swapEvents(size_t i, size_t j)
+{
+    rtosEvent_t swap = events[i];
+
+    events[i] = events[j];
+    events[j] = swap;
+}
+
+void rtosAt (uint64_t ui64TimeUs, rtosEventFn_t pfnEvent, void *pvParam,
+             uint32_t ui32Arg)
+{
+    size_t i;
+
+    if (numEvents == maxEvents)
+    {
+        maxEvents = maxEvents ? maxEvents * 2 : 64;
+        events = realloc(events, maxEvents * sizeof(rtosEvent_t));
+        if (events == NULL)
+        {
+            fprintf(stderr, "hostRtos: out of memory for events\n");
+            abort();
+        }
+    }
+    i = numEvents++;
+    events[i].at = ui64TimeUs;
+    events[i].seq = eventSeq++;
+    events[i].fn = pfnEvent;
+    events[i].param = pvParam;
+    events[i].arg = ui32Arg;
+
+    while (i > 0 && eventBefore(&events[i], &events[(i - 1) / 2]))
+    {
+        swapEvents(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+// *******************************************************
+// popEvent:            Removes the earliest event from the heap
+static rtosEvent_t popEvent(void)
+{
+    rtosEvent_t first = events[0];
+    size_t i = 0, child;
+
+    events[0] = events[--numEvents];
+    for ( ;; )
+    {
+        child = 2 * i + 1;
+        if (child >= numEvents)
+        {
+            break;
+        }
+        if (child + 1 < numEvents && eventBefore(&events[child + 1], &events[child]))
+        {
+            child++;
+        }
+        if (!eventBefore(&events[child], &events[i]))
+        {
+            break;
+        }
+        swapEvents(i, child);
+        i = child;
+    }
+    return first;
+}
+
+
+//*****************************************************************************
+// Scheduler
+//*****************************************************************************
+
+// *******************************************************
+// nextReady:           RETURNS the ready task of highest priority that has
+//                      waited longest, or NULL
+static struct tskTaskControlBlock *nextReady(void)
+{
+    struct tskTaskControlBlock *best = NULL;
+    int i;
+
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        if (tasks[i].state == TASK_READY &&
+            (best == NULL || tasks[i].priority > best->priority ||
+             (tasks[i].priority == best->priority &&
+              (int32_t)(tasks[i].readySeq - best->readySeq) < 0)))
+        {
+            best = &tasks[i];
+        }
+    }
+    return best;
+}
+
+// *******************************************************
+// runTasks:            Runs the ready tasks until every one has blocked
+static void runTasks(void)
+{
+    struct tskTaskControlBlock *task;
+
+    while ((task = nextReady()) != NULL)
+    {
+        current = task;
+        stats.switches++;
+        swapcontext(&kernelContext, &task->context);
+        current = NULL;
+    }
+}
+
+static void taskEntry(int index)
+{
+    struct tskTaskControlBlock *task = &tasks[index];
+
+    task->code(task->parameters);
+    task->state = TASK_DELETED;     // Back to the kernel through uc_link
+}
+
+// *******************************************************
+// blockCurrent:        Blocks the running task until it is woken or the
+//                      time wakeAt, then returns in it
+// RETURNS:             true if it was woken before wakeAt
+static bool blockCurrent(uint8_t reason, QueueHandle_t queue, uint64_t wakeAt)
+{
+    struct tskTaskControlBlock *task = current;
+
+    task->state = TASK_BLOCKED;
+    task->waitReason = reason;
+    task->waitQueue = queue;
+    task->wakeAt = wakeAt;
+    swapcontext(&task->context, &kernelContext);
+    return !task->timedOut;
+}
+
+// *******************************************************
+// timeout:             RETURNS the end of a wait of xTicks from now
+static uint64_t timeout(TickType_t xTicks)
+{
+    if (xTicks == portMAX_DELAY)
+    {
+        return FOREVER;
+    }
+    return (nowTicks() + xTicks) * RTOS_US_PER_TICK;
+}
+
+// *******************************************************
+// wake:                Makes a blocked task ready. From a task, a woken task
+//                      of higher priority runs at once, as it would on
+//                      target.
+// TAKES:               timedOut, true if its wait ran out
+//                      fromISR, true if called by an interrupt handler
+// RETURNS:             true if the woken task outranks the running one
+static bool wake(struct tskTaskControlBlock *task, bool timedOut, bool fromISR)
+{
+    bool higher;
+
+    task->state = TASK_READY;
+    task->readySeq = ++readySeq;
+    task->waitQueue = NULL;
+    task->timedOut = timedOut;
+    higher = current != NULL && task->priority > current->priority;
+    if (higher && !fromISR)
+    {
+        swapcontext(&current->context, &kernelContext);
+    }
+    return higher;
+}
+
+// *******************************************************
+// wakeReceiver:        Wakes the highest priority task waiting on a queue
+static bool wakeReceiver(QueueHandle_t xQueue, bool fromISR)
+{
+    struct tskTaskControlBlock *best = NULL;
+    int i;
+
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        if (tasks[i].state == TASK_BLOCKED && tasks[i].waitReason == WAIT_QUEUE &&
+            tasks[i].waitQueue == xQueue &&
+            (best == NULL || tasks[i].priority > best->priority))
+        {
+            best = &tasks[i];
+        }
+    }
+    return best != NULL && wake(best, false, fromISR);
+}
+
+// *******************************************************
+// nextTimer:           RETURNS the active timer expiring first, lowest index
+//                      on a tie, or NULL
+static struct tmrTimerControl *nextTimer(void)
+{
+    struct tmrTimerControl *next = NULL;
+    int i;
+
+    for (i = 0; i < numTimers; i++)
+    {
+        if (timers[i].active && (next == NULL || timers[i].expiry < next->expiry))
+        {
+            next = &timers[i];
+        }
+    }
+    return next;
+}
+
+// *******************************************************
+// nextEvent:           Finds the time of the next queued event, timer
+//                      expiry or end of a wait
+// RETURNS:             false if nothing is left to happen
+static bool nextEvent(uint64_t *at)
+{
+    struct tmrTimerControl *timer = nextTimer();
+    uint64_t next = FOREVER;
+    int i;
+
+    if (numEvents > 0)
+    {
+        next = events[0].at;
+    }
+    if (timer != NULL && timer->expiry * RTOS_US_PER_TICK < next)
+    {
+        next = timer->expiry * RTOS_US_PER_TICK;
+    }
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        if (tasks[i].state == TASK_BLOCKED && tasks[i].wakeAt < next)
+        {
+            next = tasks[i].wakeAt;
+        }
+    }
+    *at = next;
+    return next != FOREVER;
+}
+
+// *******************************************************
+// runDue:              Runs everything due by now: the queued events, then
+//                      the timers in expiry order, then ends the waits
+static void runDue(void)
+{
+    struct tmrTimerControl *timer;
+    rtosEvent_t event;
+    int i;
+
+    while (numEvents > 0 && events[0].at <= nowUs)
+    {
+        event = popEvent();
+        event.fn(event.param, event.arg);
+        stats.events++;
+    }
+
+    while ((timer = nextTimer()) != NULL && timer->expiry * RTOS_US_PER_TICK <= nowUs)
+    {
+        if (timer->autoReload)
+        {
+            timer->expiry += timer->period;
+        } else {
+            timer->active = false;
+        }
+        timer->callback(timer);
+        stats.timers++;
+    }
+
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        if (tasks[i].state == TASK_BLOCKED && tasks[i].wakeAt <= nowUs)
+        {
+            wake(&tasks[i], true, true);
+        }
+    }
+}
+
+
+void rtosReset (void)
+{
+    int i;
+
+    for (i = 0; i < numQueues; i++)
+    {
+        free(queues[i].storage);
+    }
+    for (i = 0; i < MAX_TASKS; i++)
+    {
+        free(tasks[i].stack);
+    }
+    memset(tasks, 0, sizeof(tasks));
+    memset(queues, 0, sizeof(queues));
+    memset(timers, 0, sizeof(timers));
+    numQueues = 0;
+    numTimers = 0;
+    nowUs = 0;
+    current = NULL;
+    readySeq = 0;
+    numEvents = 0;
+    eventSeq = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+
+void rtosRunUntil (uint64_t ui64TimeUs)
+{
+    uint64_t next;
+
+    for ( ;; )
+    {
+        runTasks();
+        if (!nextEvent(&next) || next > ui64TimeUs)
+        {
+            break;
+        }
+        if (next > nowUs)
+        {
+            nowUs = next;
+            stats.jumps++;
+        }
+        runDue();
+    }
+    if (ui64TimeUs > nowUs)
+    {
+        nowUs = ui64TimeUs;
+    }
+}
+
+
+void rtosSetTick (TickType_t xTick)
+{
+    rtosRunUntil((uint64_t)xTick * RTOS_US_PER_TICK);
+}
+
+
+uint64_t rtosNowUs (void)
+{
+    return nowUs;
+}
+
+
+void rtosGetStats (rtosStats_t *psStats)
+{
+    *psStats = stats;
+}
+
+
+uint32_t rtosNotifyCount (TaskHandle_t xTask)
+{
+    return xTask->notifyCount;
+}
+
+
+TaskHandle_t rtosTaskHandle (uint32_t ui32Index)
+{
+    return &tasks[ui32Index % MAX_TASKS];
+}
+
+
+//*****************************************************************************
+// Kernel
+//*****************************************************************************
+void vPortYield( void ) { }
+void vPortEnterCritical( void ) { }
+void vPortExitCritical( void ) { }
+
+TickType_t xTaskGetTickCount( void )
+{
+    return (TickType_t)nowTicks();
+}
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+    return (TickType_t)nowTicks();
+}
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName,
+                        const configSTACK_DEPTH_TYPE usStackDepth,
+                        void * const pvParameters, UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask )
+{
+    struct tskTaskControlBlock *task;
+    int i;
+
+    (void)pcName; (void)usStackDepth;
+    for (i = 0; i < MAX_TASKS && tasks[i].state != TASK_UNUSED; i++);
+    if (i == MAX_TASKS)
+    {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    task = &tasks[i];
+    task->stack = malloc(TASK_STACK_BYTES);
+    if (task->stack == NULL)
+    {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    task->code = pxTaskCode;
+    task->parameters = pvParameters;
+    task->priority = uxPriority;
+    task->state = TASK_READY;
+    task->readySeq = ++readySeq;
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = TASK_STACK_BYTES;
+    task->context.uc_link = &kernelContext;
+    makecontext(&task->context, (void (*)(void))taskEntry, 1, i);
+
+    if (pxCreatedTask != NULL)
+    {
+        *pxCreatedTask = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+    if (current == NULL)
+    {
+        notScheduled("vTaskDelay");
+    }
+    if (xTicksToDelay == 0)
+    {
+        wake(current, false, false);    // Yields to others of its priority
+        swapcontext(&current->context, &kernelContext);
+        return;
+    }
+    blockCurrent(WAIT_DELAY, NULL, timeout(xTicksToDelay));
+}
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
+                      const TickType_t xTimeIncrement )
+{
+    TickType_t wakeTime = *pxPreviousWakeTime + xTimeIncrement;
+    int32_t ahead = (int32_t)(wakeTime - xTaskGetTickCount());
+
+    if (current == NULL)
+    {
+        notScheduled("vTaskDelayUntil");
+    }
+    *pxPreviousWakeTime = wakeTime;
+    if (ahead > 0)
+    {
+        blockCurrent(WAIT_DELAY, NULL, timeout(ahead));
+    }
+}
+
+void vTaskStartScheduler( void )
+{
+    rtosRunUntil(FOREVER);
+}
+
+// *******************************************************
+// notify:              Updates a notification value, waking its task if it
+//                      is waiting for one
+static BaseType_t notify( TaskHandle_t xTaskToNotify, uint32_t ulValue,
+                          eNotifyAction eAction,
+                          uint32_t *pulPreviousNotificationValue,
+                          bool fromISR, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    bool higher = false;
+
+    if (pulPreviousNotificationValue != NULL)
+    {
+        *pulPreviousNotificationValue = xTaskToNotify->notifyCount;
+    }
+    if (eAction == eIncrement)
+    {
+        xTaskToNotify->notifyCount++;
+    } else if (eAction == eSetValueWithOverwrite ||
+               eAction == eSetValueWithoutOverwrite) {
+        xTaskToNotify->notifyCount = ulValue;
+    } else if (eAction == eSetBits) {
+        xTaskToNotify->notifyCount |= ulValue;
+    }
+    if (xTaskToNotify->state == TASK_BLOCKED &&
+        xTaskToNotify->waitReason == WAIT_NOTIFY && xTaskToNotify->notifyCount != 0)
+    {
+        higher = wake(xTaskToNotify, false, fromISR);
+    }
+    if (pxHigherPriorityTaskWoken != NULL)
+    {
+        *pxHigherPriorityTaskWoken = higher ? pdTRUE : pdFALSE;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue,
+                               eNotifyAction eAction,
+                               uint32_t *pulPreviousNotificationValue )
+{
+    return notify(xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue,
+                  false, NULL);
+}
+
+BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify,
+                                      uint32_t ulValue, eNotifyAction eAction,
+                                      uint32_t *pulPreviousNotificationValue,
+                                      BaseType_t *pxHigherPriorityTaskWoken )
+{
+    return notify(xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue,
+                  true, pxHigherPriorityTaskWoken);
+}
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify,
+                             BaseType_t *pxHigherPriorityTaskWoken )
+{
+    xTaskGenericNotifyFromISR(xTaskToNotify, 0, eIncrement, NULL,
+                              pxHigherPriorityTaskWoken);
+}
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit,
+                           TickType_t xTicksToWait )
+{
+    uint64_t wakeAt = timeout(xTicksToWait);
+    uint32_t value;
+
+    if (current == NULL)
+    {
+        notScheduled("ulTaskNotifyTake");
+    }
+    if (current->notifyCount == 0 && xTicksToWait > 0)
+    {
+        blockCurrent(WAIT_NOTIFY, NULL, wakeAt);
+    }
+    value = current->notifyCount;
+    if (value != 0)
+    {
+        current->notifyCount = xClearCountOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+//*****************************************************************************
+// Queues
+//*****************************************************************************
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength,
+                                   const UBaseType_t uxItemSize,
+                                   const uint8_t ucQueueType )
+{
+    struct QueueDefinition *queue;
+
+    (void)ucQueueType;
+    if (numQueues >= MAX_QUEUES)
+    {
+        return NULL;
+    }
+    queue = &queues[numQueues++];
+    queue->length = uxQueueLength;
+    queue->itemSize = uxItemSize;
+    queue->head = 0;
+    queue->count = 0;
+    queue->storage = calloc(uxQueueLength, uxItemSize);
+    return queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t xQueue, const void *pvItem,
+                            BaseType_t xCopyPosition)
+{
+    UBaseType_t index;
+
+    if (xQueue->count >= xQueue->length)
+    {
+        if (xCopyPosition != queueOVERWRITE)
+        {
+            return errQUEUE_FULL;
+        }
+        xQueue->count = 0;
+    }
+    if (xCopyPosition == queueSEND_TO_FRONT)
+    {
+        xQueue->head = (xQueue->head + xQueue->length - 1) % xQueue->length;
+        index = xQueue->head;
+    } else {
+        index = (xQueue->head + xQueue->count) % xQueue->length;
+    }
+    memcpy(xQueue->storage + index * xQueue->itemSize, pvItem, xQueue->itemSize);
+    xQueue->count++;
+    return pdPASS;
+}
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
+                              const void * const pvItemToQueue,
+                              TickType_t xTicksToWait,
+                              const BaseType_t xCopyPosition )
+{
+    BaseType_t sent;
+
+    (void)xTicksToWait;
+    sent = queueSend(xQueue, pvItemToQueue, xCopyPosition);
+    if (sent == pdPASS)
+    {
+        wakeReceiver(xQueue, false);
+    }
+    return sent;
+}
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue,
+                                     const void * const pvItemToQueue,
+                                     BaseType_t * const pxHigherPriorityTaskWoken,
+                                     const BaseType_t xCopyPosition )
+{
+    BaseType_t sent;
+    bool higher = false;
+
+    sent = queueSend(xQueue, pvItemToQueue, xCopyPosition);
+    if (sent == pdPASS)
+    {
+        higher = wakeReceiver(xQueue, true);
+    }
+    if (pxHigherPriorityTaskWoken != NULL)
+    {
+        *pxHigherPriorityTaskWoken = higher ? pdTRUE : pdFALSE;
+    }
+    return sent;
+}
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer,
+                          TickType_t xTicksToWait )
+{
+    uint64_t wakeAt = timeout(xTicksToWait);
+
+    // Outside a task, as from the harness or an ISR, it never waits
+    while (xQueue->count == 0)
+    {
+        if (current == NULL || xTicksToWait == 0 ||
+            !blockCurrent(WAIT_QUEUE, xQueue, wakeAt))
+        {
+            return pdFALSE;
+        }
+    }
+    memcpy(pvBuffer, xQueue->storage + xQueue->head * xQueue->itemSize,
+           xQueue->itemSize);
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer,
+                                 BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    (void)pxHigherPriorityTaskWoken;
+    return xQueueReceive(xQueue, pvBuffer, 0);
+}
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+    return xQueue->count;
+}
+
+//*****************************************************************************
+// Software timers
+//*****************************************************************************
+TimerHandle_t xTimerCreate( const char * const pcTimerName,
+                            const TickType_t xTimerPeriodInTicks,
+                            const UBaseType_t uxAutoReload,
+                            void * const pvTimerID,
+                            TimerCallbackFunction_t pxCallbackFunction )
+{
+    struct tmrTimerControl *timer;
+
+    (void)pcTimerName;
+    if (numTimers >= MAX_TIMERS)
+    {
+        return NULL;
+    }
+    timer = &timers[numTimers++];
+    timer->period = xTimerPeriodInTicks;
+    timer->autoReload = uxAutoReload != pdFALSE;
+    timer->id = pvTimerID;
+    timer->callback = pxCallbackFunction;
+    timer->active = false;
+    return timer;
+}
+
+BaseType_t xTimerGenericCommand( TimerHandle_t xTimer,
+                                 const BaseType_t xCommandID,
+                                 const TickType_t xOptionalValue,
+                                 BaseType_t * const pxHigherPriorityTaskWoken,
+                                 const TickType_t xTicksToWait )
+{
+    (void)pxHigherPriorityTaskWoken; (void)xTicksToWait;
+
+    switch (xCommandID)
+    {
+    case tmrCOMMAND_START:
+    case tmrCOMMAND_RESET:
+    case tmrCOMMAND_START_FROM_ISR:
+    case tmrCOMMAND_RESET_FROM_ISR:
+    case tmrCOMMAND_START_DONT_TRACE:
+        // Counted from the tick given, a little before now if it was
+        // queued from a task that has since been held up
+        xTimer->expiry = nowTicks() - (int32_t)(xTaskGetTickCount() - xOptionalValue)
+                         + xTimer->period;
+        xTimer->active = true;
+        break;
+    case tmrCOMMAND_STOP:
+    case tmrCOMMAND_STOP_FROM_ISR:
+        xTimer->active = false;
+        break;
+    case tmrCOMMAND_CHANGE_PERIOD:
+    case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR:
+        xTimer->period = xOptionalValue;
+        xTimer->expiry = nowTicks() + xOptionalValue;
+        xTimer->active = true;
+        break;
+    case tmrCOMMAND_DELETE:
+        xTimer->active = false;
+        break;
+    default:
+        break;
+    }
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID( const TimerHandle_t xTimer )
+{
+    return xTimer->id;
+}
+
+BaseType_t xTimerIsTimerActive( TimerHandle_t xTimer )
+{
+    return xTimer->active ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,99 @@
+#ifndef HOSTRTOS_H_
+#define HOSTRTOS_H_
+
+//*****************************************************************************
+//
+// hostRtos - Virtual time stand-in for the FreeRTOS calls made by the
+//            firmware modules, run as a discrete event simulation. Nothing
+//            waits in real time: when every task is blocked, time jumps
+//            straight to the next event, be it a task delay ending, a
+//            software timer expiring or an event a peripheral model queued
+//            with rtosAt (an ADC conversion completing, an encoder edge).
+//
+//            Tasks made with xTaskCreate run as coroutines on their own
+//            stacks, highest priority first, and run until they block; they
+//            take no virtual time. At any instant the queued events (the
+//            interrupts) run first, then the software timers, as the timer
+//            daemon outranks every task, then the tasks.
+//
+//            A harness can instead call the firmware step functions itself
+//            and move time on with rtosSetTick, as replay does; with no
+//            tasks created only the timers and queued events run.
+//            Queues, notifications and software timers behave as on
+//            target, except that sends to a full queue never block.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define RTOS_US_PER_TICK    (1000000 / configTICK_RATE_HZ)
+
+// Run at its time by rtosRunUntil, in interrupt context
+typedef void (*rtosEventFn_t)(void *pvParam, uint32_t ui32Arg);
+
+// *******************************************************
+// What the kernel has done since rtosReset
+typedef struct {
+    uint64_t events;        // Events queued with rtosAt that have run
+    uint64_t timers;        // Software timer callbacks
+    uint64_t switches;      // Times a task was switched in
+    uint64_t jumps;         // Times time moved on to the next event
+} rtosStats_t;
+
+// *******************************************************
+// rtosReset:           Frees every task, queue, timer and queued event and
+//                      sets the time to 0
+void
+rtosReset (void);
+
+// *******************************************************
+// rtosSetTick:         Moves virtual time on to the start of the given tick,
+//                      as rtosRunUntil
+void
+rtosSetTick (TickType_t xTick);
+
+// *******************************************************
+// rtosRunUntil:        Runs the simulation up to the given time. The ready
+//                      tasks run, then time jumps to the next event and
+//                      everything due then runs, until the next event is
+//                      after ui64TimeUs. Time is then ui64TimeUs.
+// TAKES:               ui64TimeUs, microseconds since rtosReset
+void
+rtosRunUntil (uint64_t ui64TimeUs);
+
+// *******************************************************
+// rtosNowUs:           RETURNS the virtual time in microseconds
+uint64_t
+rtosNowUs (void);
+
+// *******************************************************
+// rtosAt:              Queues pfnEvent to run at a time, after any event
+//                      already queued for that time. A time already passed
+//                      runs at the next step of the simulation.
+// TAKES:               ui64TimeUs, when to run it
+//                      pfnEvent, pvParam, ui32Arg, the event and its arguments
+void
+rtosAt (uint64_t ui64TimeUs, rtosEventFn_t pfnEvent, void *pvParam,
+        uint32_t ui32Arg);
+
+// *******************************************************
+// rtosGetStats:        Copies out what the kernel has done since rtosReset
+void
+rtosGetStats (rtosStats_t *psStats);
+
+// *******************************************************
+// rtosNotifyCount:     RETURNS the pending notification count of a task handle
+uint32_t
+rtosNotifyCount (TaskHandle_t xTask);
+
+// *******************************************************
+// rtosTaskHandle:      RETURNS a distinct handle the harness can hand to the
+//                      firmware where it expects a task to notify. Not for
+//                      use alongside xTaskCreate, which takes the same slots.
+TaskHandle_t
+rtosTaskHandle (uint32_t ui32Index);
+
+#endif /* HOSTRTOS_H_ */
@@ -0,0 +1,71 @@
+//*****************************************************************************
+//
+// hostSim - Runs the simulated peripherals of hostHal in the virtual time of
+//           hostRtos. See hostSim.h.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+
+#include "hostHal.h"
+#include "hostRtos.h"
+#include "hostSim.h"
+
+#define PIN_HIGH            0x100   // Event arguments, above the pin mask
+#define PIN_SILENT          0x200
+
+
+static void adcDone(void *pvParam, uint32_t ui32Arg)
+{
+    (void)pvParam;
+    halAdcComplete(ui32Arg);
+}
+
+
+static void adcTriggered(uint32_t ui32SequenceNum, uint32_t ui32ConversionUs)
+{
+    rtosAt(rtosNowUs() + ui32ConversionUs, adcDone, NULL, ui32SequenceNum);
+}
+
+
+static void pinsChanged(void *pvParam, uint32_t ui32Arg)
+{
+    uint32_t port = (uint32_t)(uintptr_t)pvParam;
+    uint8_t pins = ui32Arg & 0xFF;
+
+    if (ui32Arg & PIN_SILENT)
+    {
+        // The flag is raised and cleared with the interrupt masked, so the
+        // handler never sees this edge
+        GPIOIntDisable(port, pins);
+        halSetPins(port, pins, ui32Arg & PIN_HIGH);
+        GPIOIntClear(port, pins);
+        GPIOIntEnable(port, pins);
+    } else {
+        halSetPins(port, pins, ui32Arg & PIN_HIGH);
+    }
+}
+
+
+void simInit (void)
+{
+    halSetAdcHook(adcTriggered);
+}
+
+
+void simSetPinsAt (uint64_t ui64TimeUs, uint32_t ui32Port, uint8_t ui8Pins, bool bHigh)
+{
+    rtosAt(ui64TimeUs, pinsChanged, (void *)(uintptr_t)ui32Port,
+           ui8Pins | (bHigh ? PIN_HIGH : 0));
+}
+
+
+void simSetPinsSilentAt (uint64_t ui64TimeUs, uint32_t ui32Port, uint8_t ui8Pins,
+                         bool bHigh)
+{
+    rtosAt(ui64TimeUs, pinsChanged, (void *)(uintptr_t)ui32Port,
+           ui8Pins | (bHigh ? PIN_HIGH : 0) | PIN_SILENT);
+}
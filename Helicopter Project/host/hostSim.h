@@ -0,0 +1,37 @@
+#ifndef HOSTSIM_H_
+#define HOSTSIM_H_
+
+//*****************************************************************************
+//
+// hostSim - Runs the simulated peripherals of hostHal in the virtual time of
+//           hostRtos. A triggered ADC sequence completes, and interrupts,
+//           after its conversion time; pin changes can be queued for any
+//           time, so a plant model can place each encoder edge and
+//           reference pulse at the instant it happens.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// *******************************************************
+// simInit:             Times ADC conversions with hostRtos. Call after
+//                      halReset and rtosReset.
+void
+simInit (void);
+
+// *******************************************************
+// simSetPinsAt:        Queues halSetPins for a time, so any edge interrupt
+//                      runs then
+// TAKES:               ui64TimeUs, when, in microseconds since rtosReset
+//                      ui32Port, ui8Pins, bHigh, as halSetPins
+void
+simSetPinsAt (uint64_t ui64TimeUs, uint32_t ui32Port, uint8_t ui8Pins, bool bHigh);
+
+// *******************************************************
+// simSetPinsSilentAt:  As simSetPinsAt, but the edge interrupt is lost, as
+//                      if the edge came while the handler was held off
+void
+simSetPinsSilentAt (uint64_t ui64TimeUs, uint32_t ui32Port, uint8_t ui8Pins,
+                    bool bHigh);
+
+#endif /* HOSTSIM_H_ */
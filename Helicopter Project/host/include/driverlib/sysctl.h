@@ -0,0 +1,2 @@
+// Host build: see hostHw.h
+#include "hostHw.h"
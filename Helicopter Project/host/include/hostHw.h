@@ -0,0 +1,290 @@
+#ifndef HOSTHW_H_
+#define HOSTHW_H_
+
+//*****************************************************************************
+//
+// hostHw - Host stand-in for the TivaWare driverlib, inc and utils headers.
+//          Every driverlib/, inc/ and utils/ header under host/include pulls
+//          in this file so the firmware sources compile unchanged on a PC.
+//          The functions are implemented by hostHal.c against a simulated
+//          set of pins, ADC and PWM compare registers.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//*****************************************************************************
+// inc/hw_memmap.h
+//*****************************************************************************
+#define WATCHDOG0_BASE          0x40000000
+#define GPIO_PORTA_BASE         0x40004000
+#define GPIO_PORTB_BASE         0x40005000
+#define GPIO_PORTC_BASE         0x40006000
+#define GPIO_PORTD_BASE         0x40007000
+#define SSI0_BASE               0x40008000
+#define SSI3_BASE               0x4000B000
+#define UART0_BASE              0x4000C000
+#define GPIO_PORTE_BASE         0x40024000
+#define GPIO_PORTF_BASE         0x40025000
+#define PWM0_BASE               0x40028000
+#define PWM1_BASE               0x40029000
+#define TIMER0_BASE             0x40030000
+#define TIMER1_BASE             0x40031000
+#define WTIMER0_BASE            0x40036000
+#define ADC0_BASE               0x40038000
+
+//*****************************************************************************
+// inc/hw_types.h, inc/hw_ints.h
+//*****************************************************************************
+#define HWREG(x)                (*hostReg(x))
+
+#define INT_GPIOA               16
+#define INT_GPIOB               17
+#define INT_GPIOC               18
+#define INT_GPIOD               19
+#define INT_GPIOE               20
+#define INT_UART0               21
+#define INT_ADC0SS0             30
+#define INT_ADC0SS3             33
+#define INT_WATCHDOG            34
+#define INT_TIMER0A             35
+#define INT_TIMER1A             37
+#define INT_GPIOF               46
+#define INT_WTIMER0A            110
+
+//*****************************************************************************
+// inc/tm4c123gh6pm.h
+//*****************************************************************************
+#define GPIO_LOCK_M             0xFFFFFFFF
+#define GPIO_LOCK_KEY           0x4C4F434B
+#define GPIO_PORTF_LOCK_R       (*hostReg(GPIO_PORTF_BASE + 0x520))
+#define GPIO_PORTF_CR_R         (*hostReg(GPIO_PORTF_BASE + 0x524))
+
+//*****************************************************************************
+// inc/hw_gpio.h, inc/hw_ssi.h, inc/hw_timer.h
+//*****************************************************************************
+#define GPIO_O_LOCK             0x520
+#define GPIO_O_CR               0x524
+#define SSI_O_DR                0x008
+#define SSI_O_SR                0x00C
+#define SSI_SR_BSY              0x010
+#define SSI_SR_RNE              0x004
+#define SSI_SR_TNF              0x002
+#define TIMER_O_TAV             0x050
+
+//*****************************************************************************
+// driverlib/sysctl.h
+//*****************************************************************************
+#define SYSCTL_PERIPH_WDOG0     0xf0000000
+#define SYSCTL_PERIPH_TIMER0    0xf0000400
+#define SYSCTL_PERIPH_TIMER1    0xf0000401
+#define SYSCTL_PERIPH_GPIOA     0xf0000800
+#define SYSCTL_PERIPH_GPIOB     0xf0000801
+#define SYSCTL_PERIPH_GPIOC     0xf0000802
+#define SYSCTL_PERIPH_GPIOD     0xf0000803
+#define SYSCTL_PERIPH_GPIOE     0xf0000804
+#define SYSCTL_PERIPH_GPIOF     0xf0000805
+#define SYSCTL_PERIPH_SSI0      0xf0001c00
+#define SYSCTL_PERIPH_SSI3      0xf0001c03
+#define SYSCTL_PERIPH_UART0     0xf0001800
+#define SYSCTL_PERIPH_ADC0      0xf0003800
+#define SYSCTL_PERIPH_PWM0      0xf0004000
+#define SYSCTL_PERIPH_PWM1      0xf0004001
+#define SYSCTL_PERIPH_WTIMER0   0xf0005c00
+
+#define SYSCTL_SYSDIV_2_5       0xC1000000
+#define SYSCTL_USE_PLL          0x00000000
+#define SYSCTL_OSC_MAIN         0x00000000
+#define SYSCTL_XTAL_16MHZ       0x00000540
+#define SYSCTL_PWMDIV_16        0x00160000
+
+void SysCtlClockSet(uint32_t ui32Config);
+uint32_t SysCtlClockGet(void);
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral);
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral);
+void SysCtlPeripheralReset(uint32_t ui32Peripheral);
+void SysCtlPWMClockSet(uint32_t ui32Config);
+void SysCtlReset(void);
+void SysCtlDelay(uint32_t ui32Count);
+
+//*****************************************************************************
+// driverlib/gpio.h, driverlib/pin_map.h
+//*****************************************************************************
+#define GPIO_PIN_0              0x00000001
+#define GPIO_PIN_1              0x00000002
+#define GPIO_PIN_2              0x00000004
+#define GPIO_PIN_3              0x00000008
+#define GPIO_PIN_4              0x00000010
+#define GPIO_PIN_5              0x00000020
+#define GPIO_PIN_6              0x00000040
+#define GPIO_PIN_7              0x00000080
+
+#define GPIO_INT_PIN_0          0x00000001
+#define GPIO_INT_PIN_1          0x00000002
+#define GPIO_INT_PIN_2          0x00000004
+#define GPIO_INT_PIN_3          0x00000008
+#define GPIO_INT_PIN_4          0x00000010
+#define GPIO_INT_PIN_5          0x00000020
+#define GPIO_INT_PIN_6          0x00000040
+#define GPIO_INT_PIN_7          0x00000080
+
+#define GPIO_DIR_MODE_IN        0x00000000
+#define GPIO_DIR_MODE_OUT       0x00000001
+#define GPIO_FALLING_EDGE       0x00000000
+#define GPIO_RISING_EDGE        0x00000004
+#define GPIO_BOTH_EDGES         0x00000001
+#define GPIO_STRENGTH_2MA       0x00000001
+#define GPIO_PIN_TYPE_STD       0x00000008
+#define GPIO_PIN_TYPE_STD_WPU   0x0000000A
+#define GPIO_PIN_TYPE_STD_WPD   0x0000000C
+
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PC5_M0PWM7         0x00021404
+#define GPIO_PF1_M1PWM5         0x00050405
+
+void GPIODirModeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32PinIO);
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength,
+                      uint32_t ui32PadType);
+void GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeSSI(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinConfigure(uint32_t ui32PinConfig);
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val);
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType);
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags);
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags);
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags);
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked);
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void));
+
+//*****************************************************************************
+// driverlib/adc.h
+//*****************************************************************************
+#define ADC_TRIGGER_PROCESSOR   0x00000000
+#define ADC_CTL_CH9             0x00000009
+#define ADC_CTL_IE              0x00000040
+#define ADC_CTL_END             0x00000020
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                          uint32_t ui32Trigger, uint32_t ui32Priority);
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                              uint32_t ui32Step, uint32_t ui32Config);
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+int32_t ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                           uint32_t *pui32Buffer);
+void ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                    void (*pfnHandler)(void));
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor);
+
+//*****************************************************************************
+// driverlib/pwm.h
+//*****************************************************************************
+#define PWM_GEN_2               0x000000C0
+#define PWM_GEN_3               0x00000100
+#define PWM_OUT_5               0x000000C3
+#define PWM_OUT_7               0x00000103
+#define PWM_OUT_5_BIT           0x00000020
+#define PWM_OUT_7_BIT           0x00000080
+#define PWM_GEN_2_BIT           0x00000004
+#define PWM_GEN_3_BIT           0x00000008
+#define PWM_GEN_MODE_DOWN       0x00000000
+#define PWM_GEN_MODE_UP_DOWN    0x00000002
+#define PWM_GEN_MODE_SYNC       0x00000038
+#define PWM_GEN_MODE_NO_SYNC    0x00000000
+#define PWM_GEN_MODE_DBG_RUN    0x00000004
+
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config);
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period);
+uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen);
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen);
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut,
+                      uint32_t ui32Width);
+uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut);
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable);
+void PWMSyncUpdate(uint32_t ui32Base, uint32_t ui32GenBits);
+
+//*****************************************************************************
+// driverlib/uart.h
+//*****************************************************************************
+#define UART_CONFIG_WLEN_8      0x00000060
+#define UART_CONFIG_STOP_ONE    0x00000000
+#define UART_CONFIG_PAR_NONE    0x00000000
+#define UART_INT_RT             0x040
+#define UART_INT_RX             0x010
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk,
+                         uint32_t ui32Baud, uint32_t ui32Config);
+void UARTFIFOEnable(uint32_t ui32Base);
+void UARTEnable(uint32_t ui32Base);
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData);
+bool UARTCharsAvail(uint32_t ui32Base);
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base);
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked);
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+//*****************************************************************************
+// driverlib/ssi.h, driverlib/timer.h. The simulated SSI is always ready and
+// the timer advances one count per read.
+//*****************************************************************************
+#define SSI_CLOCK_SYSTEM        0x00000000
+#define SSI_FRF_MOTO_MODE_0     0x00000000
+#define SSI_MODE_MASTER         0x00000000
+#define TIMER_CFG_PERIODIC_UP   0x00000032
+#define TIMER_A                 0x000000FF
+
+void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk,
+                        uint32_t ui32Protocol, uint32_t ui32Mode,
+                        uint32_t ui32BitRate, uint32_t ui32DataWidth);
+void SSIClockSourceSet(uint32_t ui32Base, uint32_t ui32Source);
+void SSIEnable(uint32_t ui32Base);
+bool SSIBusy(uint32_t ui32Base);
+void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data);
+void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data);
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+uint32_t TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer);
+
+//*****************************************************************************
+// driverlib/watchdog.h
+//*****************************************************************************
+void WatchdogReloadSet(uint32_t ui32Base, uint32_t ui32LoadVal);
+void WatchdogResetEnable(uint32_t ui32Base);
+void WatchdogStallEnable(uint32_t ui32Base);
+void WatchdogIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+void WatchdogIntClear(uint32_t ui32Base);
+void WatchdogEnable(uint32_t ui32Base);
+
+//*****************************************************************************
+// driverlib/interrupt.h, driverlib/cpu.h
+//*****************************************************************************
+bool IntMasterEnable(void);
+bool IntMasterDisable(void);
+void IntEnable(uint32_t ui32Interrupt);
+void IntDisable(uint32_t ui32Interrupt);
+void IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void));
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority);
+uint32_t CPUcpsid(void);
+uint32_t CPUcpsie(void);
+void CPUwfi(void);
+
+//*****************************************************************************
+// driverlib/debug.h
+//*****************************************************************************
+#define ASSERT(expr)
+
+//*****************************************************************************
+// Host only: register file backing HWREG() and the named registers above
+//*****************************************************************************
+volatile uint32_t *hostReg(uint32_t ui32Address);
+
+#endif /* HOSTHW_H_ */
@@ -0,0 +1,2 @@
+// Host build: the firmware carries its own copy of ustdlib
+#include <ustdlib.h>
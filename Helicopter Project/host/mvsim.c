@@ -0,0 +1,351 @@
+//*****************************************************************************
+//
+// mvsim - Flies a manoeuvre program on the host before it is flown on the
+//         rig. The firmware interpreter (manoeuvre.c) and reference
+//         trajectories (trajectory.c) run unchanged, once per control cycle,
+//         against a plant model: each axis follows its trajectory through a
+//         critically damped second order lag standing in for the closed
+//         loop. The program is validated, its run time and the time spent in
+//         each WAIT are reported, and it can be printed as an upload line.
+//
+//          Usage:  mvsim [-v] [-c cycle_ms] [-t tau_ms] [-a alt%] [-y yaw]
+//                        [-u slot] up|down|left|right|script.mv
+//
+//          -v          trace every control cycle
+//          -c          control cycle, default 150 ms
+//          -t          plant time constant, default 250 ms
+//          -a, -y      references when the manoeuvre starts, default 50% 0
+//          -u          print the program as an upload line for the slot
+//
+//          A script has one instruction per line, '#' starts a comment:
+//              ALT <percent>           ALT_BY <percent>
+//              YAW_BY <degrees>        FACE <heading>
+//              TOL ALT|YAW <units>     TIMEOUT <ms>
+//              WAIT <dwell ms>         DELAY <ms>
+//              REPEAT <count>          NEXT
+//              END
+//          Tolerances take two decimals, e.g. "TOL YAW 2.5". A missing END
+//          is added.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "manoeuvre.h"
+#include "trajectory.h"
+#include "fixedPoint.h"
+
+#define DEFAULT_CYCLE       150     // ms, one new altitude per control cycle
+#define DEFAULT_TAU         250     // ms
+#define DEFAULT_ALT         50
+#define DEFAULT_YAW         0
+#define SIM_LIMIT           600000  // ms, gives up on a program without timeouts
+#define MAX_LINE            128
+
+static const char *opNames[MV_NUM_OPS] = {"END", "ALT", "ALT_BY", "YAW_BY",
+    "FACE", "TOL", "TIMEOUT", "WAIT", "DELAY", "REPEAT", "NEXT"};
+static const char *builtInNames[MV_NUM_SLOTS] = {"up", "down", "left", "right"};
+
+// One axis of the plant, in 0.01 units
+typedef struct {
+    trajectory_t traj;
+    double pos;
+    double vel;
+} axis_t;
+
+// Time spent in each WAIT or DELAY
+typedef struct {
+    uint32_t count;
+    uint32_t total;
+    uint32_t longest;
+} waitStats_t;
+
+
+// *******************************************************
+// assemble:            Reads a script into a program
+// RETURNS:             The number of instructions, or -1 on an error
+static int assemble(FILE *file, const char *name, mvInstr_t *program)
+{
+    char line[MAX_LINE], op[16], axis[16];
+    int length = 0, lineNum = 0, i, n;
+    double value;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNum++;
+        line[strcspn(line, "#")] = '\0';
+        n = sscanf(line, "%15s %lf", op, &value);
+        if (n < 1)
+        {
+            continue;
+        }
+        for (i = 0; i < MV_NUM_OPS && strcasecmp(op, opNames[i]) != 0; i++)
+        {
+        }
+        if (length == MV_MAX_LENGTH)
+        {
+            fprintf(stderr, "%s:%d: longer than %d instructions\n", name, lineNum,
+                    MV_MAX_LENGTH);
+            return -1;
+        }
+        program[length].op = i;
+        program[length].arg = 0;
+        program[length].value = 0;
+
+        if (i == MV_TOL)
+        {
+            if (sscanf(line, "%*s %15s %lf", axis, &value) != 2 ||
+                (strcasecmp(axis, "ALT") != 0 && strcasecmp(axis, "YAW") != 0))
+            {
+                fprintf(stderr, "%s:%d: TOL wants ALT or YAW and a value\n",
+                        name, lineNum);
+                return -1;
+            }
+            program[length].arg = (strcasecmp(axis, "ALT") == 0) ? MV_AXIS_ALT
+                                                                : MV_AXIS_YAW;
+            value *= FIXED_SCALE;
+        } else if (i == MV_NUM_OPS) {
+            fprintf(stderr, "%s:%d: unknown instruction %s\n", name, lineNum, op);
+            return -1;
+        } else if (i != MV_END && i != MV_NEXT && n != 2) {
+            fprintf(stderr, "%s:%d: %s wants a value\n", name, lineNum, op);
+            return -1;
+        }
+        if (value < INT16_MIN || value > INT16_MAX)
+        {
+            fprintf(stderr, "%s:%d: value out of range\n", name, lineNum);
+            return -1;
+        }
+        if (i != MV_END && i != MV_NEXT)
+        {
+            program[length].value = (int16_t)(value + (value < 0 ? -0.5 : 0.5));
+        }
+        if (program[length++].op == MV_END)
+        {
+            break;
+        }
+    }
+
+    if (length == 0 || program[length - 1].op != MV_END)
+    {
+        if (length == MV_MAX_LENGTH)
+        {
+            fprintf(stderr, "%s: no room for END\n", name);
+            return -1;
+        }
+        program[length].op = MV_END;
+        program[length].arg = 0;
+        program[length].value = 0;
+        length++;
+    }
+    return length;
+}
+
+
+// *******************************************************
+// printUpload:         Prints a program in the form manoeuvreParseUpload takes
+static void printUpload(const mvInstr_t *program, int length, int slot)
+{
+    uint8_t sum = 0;
+    uint16_t value;
+    int i;
+
+    printf("MV %d", slot);
+    for (i = 0; i < length; i++)
+    {
+        value = (uint16_t)program[i].value;
+        printf(" %02X%02X%04X", program[i].op, program[i].arg, value);
+        sum += program[i].op + program[i].arg + (value >> 8) + (value & 0xFF);
+    }
+    printf(" *%02X\n", sum);
+}
+
+
+// *******************************************************
+// axisInit:            Puts an axis of the plant at rest
+static void axisInit(axis_t *axis, int32_t pos, int32_t maxVel, int32_t maxAcc,
+                     int32_t maxJerk)
+{
+    trajectoryInit(&axis->traj, maxVel, maxAcc, maxJerk);
+    trajectoryReset(&axis->traj, pos);
+    axis->pos = pos;
+    axis->vel = 0;
+}
+
+
+// *******************************************************
+// axisStep:            Moves an axis on by one control cycle towards a
+//                      reference, in 1 ms steps
+static void axisStep(axis_t *axis, int32_t ref, uint32_t cycleMs, double tau)
+{
+    uint32_t i;
+
+    trajectorySetTarget(&axis->traj, ref * FIXED_SCALE);
+    trajectoryStep(&axis->traj, cycleMs);
+    for (i = 0; i < cycleMs; i++)
+    {
+        axis->vel += ((axis->traj.pos - axis->pos) / (tau * tau) -
+                      2 * axis->vel / tau) * 1e-3;
+        axis->pos += axis->vel * 1e-3;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    mvInstr_t program[MV_MAX_LENGTH];
+    waitStats_t stats[MV_MAX_LENGTH] = {{0}};
+    uint32_t cycle = DEFAULT_CYCLE, now = 0, waitStart = 0;
+    int32_t altRef = DEFAULT_ALT, yawRef = DEFAULT_YAW, valid;
+    double tau = DEFAULT_TAU * 1e-3, worstAlt = 0, worstYaw = 0;
+    int length, slot = -1, argi, i;
+    bool verbose = false;
+    manoeuvre_t mv;
+    axis_t alt, yaw;
+    mvStatus_t status;
+    uint8_t pc;
+    FILE *file;
+
+    for (argi = 1; argi < argc - 1; argi++)
+    {
+        if (strcmp(argv[argi], "-v") == 0)
+        {
+            verbose = true;
+        } else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc - 1) {
+            cycle = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc - 1) {
+            tau = atoi(argv[++argi]) * 1e-3;
+        } else if (strcmp(argv[argi], "-a") == 0 && argi + 1 < argc - 1) {
+            altRef = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-y") == 0 && argi + 1 < argc - 1) {
+            yawRef = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-u") == 0 && argi + 1 < argc - 1) {
+            slot = atoi(argv[++argi]);
+        } else {
+            break;
+        }
+    }
+    if (argi != argc - 1 || cycle == 0 || tau <= 0 || slot >= MV_NUM_SLOTS)
+    {
+        fprintf(stderr, "usage: %s [-v] [-c cycle_ms] [-t tau_ms] [-a alt%%] "
+                "[-y yaw] [-u slot] up|down|left|right|script.mv\n", argv[0]);
+        return 2;
+    }
+
+    // A built in program by name, otherwise a script
+    for (i = 0; i < MV_NUM_SLOTS && strcmp(argv[argi], builtInNames[i]) != 0; i++)
+    {
+    }
+    if (i < MV_NUM_SLOTS)
+    {
+        length = manoeuvreValidate(manoeuvreBuiltIn[i]);
+        memcpy(program, manoeuvreBuiltIn[i],
+               (length > 0 ? length : MV_MAX_LENGTH) * sizeof(mvInstr_t));
+    } else {
+        file = fopen(argv[argi], "r");
+        if (file == NULL)
+        {
+            perror(argv[argi]);
+            return 2;
+        }
+        length = assemble(file, argv[argi], program);
+        fclose(file);
+        if (length < 0)
+        {
+            return 1;
+        }
+    }
+
+    valid = manoeuvreValidate(program);
+    if (valid < 0)
+    {
+        fprintf(stderr, "mvsim: invalid instruction %d (%s %d)\n", -1 - valid,
+                program[-1 - valid].op < MV_NUM_OPS ? opNames[program[-1 - valid].op]
+                                                    : "?",
+                program[-1 - valid].value);
+        return 1;
+    }
+    if (slot >= 0)
+    {
+        printUpload(program, length, slot);
+        return 0;
+    }
+
+    axisInit(&alt, altRef * FIXED_SCALE, ALT_TRAJ_VEL, ALT_TRAJ_ACC, ALT_TRAJ_JERK);
+    axisInit(&yaw, yawRef * FIXED_SCALE, YAW_TRAJ_VEL, YAW_TRAJ_ACC, YAW_TRAJ_JERK);
+    manoeuvreStart(&mv, program, altRef, yawRef);
+
+    // One manoeuvre step per control cycle, as updateManoeuvre does, with the
+    // new references reaching the plant on the following cycle
+    if (verbose)
+    {
+        printf("#   ms  pc op        alt%%     yaw  altRef yawRef\n");
+    }
+    do
+    {
+        axisStep(&alt, altRef, cycle, tau);
+        axisStep(&yaw, yawRef, cycle, tau);
+        now += cycle;
+
+        pc = mv.pc;
+        status = manoeuvreStep(&mv, (int32_t)alt.pos, (int32_t)yaw.pos, cycle);
+        altRef = mv.altRef;
+        yawRef = mv.yawRef;
+
+        // A WAIT or DELAY ends when the pc moves on from it, or comes round
+        // to it again (the interpreter then restarts its timers)
+        if ((program[pc].op == MV_WAIT || program[pc].op == MV_DELAY) &&
+            (mv.pc != pc || mv.waited == 0 || status != MV_RUNNING))
+        {
+            stats[pc].count++;
+            stats[pc].total += now - waitStart;
+            if (now - waitStart > stats[pc].longest)
+            {
+                stats[pc].longest = now - waitStart;
+            }
+        }
+        if (mv.pc != pc || mv.waited == 0)
+        {
+            waitStart = now;
+        }
+
+        if (fabs(alt.pos - alt.traj.pos) > worstAlt)
+        {
+            worstAlt = fabs(alt.pos - alt.traj.pos);
+        }
+        if (fabs(yaw.pos - yaw.traj.pos) > worstYaw)
+        {
+            worstYaw = fabs(yaw.pos - yaw.traj.pos);
+        }
+        if (verbose)
+        {
+            printf("%6u %3u %-8s %6.2f %7.2f %5d %6d\n", now, mv.pc,
+                   opNames[program[mv.pc].op], alt.pos / FIXED_SCALE,
+                   yaw.pos / FIXED_SCALE, altRef, yawRef);
+        }
+    } while (status == MV_RUNNING && now < SIM_LIMIT);
+
+    printf("# %s: %s after %u ms (%u control cycles), pc %u\n", argv[argi],
+           status == MV_DONE ? "done" : status == MV_TIMED_OUT ? "TIMED OUT"
+                                                               : "did not finish",
+           now, now / cycle, mv.pc);
+    printf("# final alt %.2f%% yaw %.2f, worst lag behind the trajectory "
+           "%.2f%% %.2f deg\n", alt.pos / FIXED_SCALE, yaw.pos / FIXED_SCALE,
+           worstAlt / FIXED_SCALE, worstYaw / FIXED_SCALE);
+    printf("#  pc  wait  count   total ms  longest ms  share\n");
+    for (i = 0; i < length; i++)
+    {
+        if (stats[i].count > 0)
+        {
+            printf("# %3d %5d %6u %10u %11u %5.1f%%\n", i, program[i].value,
+                   stats[i].count, stats[i].total, stats[i].longest,
+                   100.0 * stats[i].total / now);
+        }
+    }
+    return (status == MV_DONE) ? 0 : 1;
+}
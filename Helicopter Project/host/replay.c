@@ -0,0 +1,415 @@
+//*****************************************************************************
+//
+// replay - Deterministic replay of a recorded sensor log through the real
+//          firmware modules on the host. ADC samples go through ADCIntHandler
+//          and the vADCTask filter, encoder states through YawIntHandler and
+//          switch/button edges through the debounced inputs, all in virtual
+//          time. Every PWM compare value the controller writes is printed, so
+//          two runs (or two controller versions) can be diffed exactly.
+//
+//          Usage:  replay [-q] [-t tail_ms] log.txt
+//
+//          Mode transitions are printed too, with their latency, but are
+//          not part of the checksum. Once the log's ADC samples run out
+//          the deadline monitor sees the control chain stall and ramps
+//          the rotors down through the tail.
+//
+//          Log lines are "<ms> <EVENT> [args]", '#' starts a comment:
+//              <ms> ADC <raw>              12 bit result of every ADC step
+//              <ms> ENC <0..3>             PB1:PB0 quadrature state
+//              <ms> SLOT <n>               Edges synthesised up to slot n
+//              <ms> REF                    PC4 reference pulse
+//              <ms> SW <0|1>               SW1 (PA7) level
+//              <ms> BTN <UP|DOWN|LEFT|RIGHT> <1=pressed|0=released>
+//              <ms> RST <1=pressed|0=released>
+//          Black box dump lines ("BB t type aux v0 v1") are also accepted;
+//          their ADC and yaw records are replayed. Black box ADC records
+//          hold the sum of ADC_STEPS results and are replayed as such.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+
+#include "altitude.h"
+#include "yaw.h"
+#include "motor.h"
+#include "motorOutput.h"
+#include "torqueFF.h"
+#include "control.h"
+#include "buttons4.h"
+#include "blackBox.h"
+#include "lowPower.h"
+#include "perf.h"
+#include "deadline.h"
+#include "bootProfile.h"
+#include "uart.h"
+
+#include "hostHal.h"
+#include "hostRtos.h"
+
+#define ADC_TASK_DELAY      20      // vTaskDelay at the end of vADCTask
+#define DEFAULT_TAIL        2000    // Time run on after the last event
+#define MAX_LINE            128
+
+enum evType {EV_ADC, EV_ADC_SUM, EV_ENC, EV_SLOT, EV_REF, EV_SW, EV_BTN, EV_RST};
+
+typedef struct {
+    uint32_t tick;
+    uint32_t seq;           // Order in the log, to keep same tick lines in order
+    uint8_t type;
+    uint8_t arg;
+    int32_t value;
+} event_t;
+
+extern QueueHandle_t xADCQueue;
+
+static event_t *events;
+static size_t numEvents, maxEvents;
+static bool quiet;
+static uint32_t currentTick;
+static uint64_t checksum = 1469598103934665603ULL;
+static uint32_t numWrites;
+static int32_t encSlot;
+
+// Clockwise and anticlockwise successor of each quadrature state
+static const uint8_t cwNext[4] = {2, 0, 3, 1};
+static const uint8_t ccwNext[4] = {1, 3, 0, 2};
+
+
+// *******************************************************
+// pwmWritten:          Records every compare write into the output checksum
+static void pwmWritten(uint32_t ui32Base, uint32_t ui32Width, uint32_t ui32Period)
+{
+    static uint32_t lastMain = UINT32_MAX, lastTail = UINT32_MAX;
+    uint32_t *last = (ui32Base == PWM0_BASE) ? &lastMain : &lastTail;
+    uint32_t words[3] = {currentTick, ui32Base, ui32Width};
+    size_t i;
+
+    for (i = 0; i < sizeof(words); i++)
+    {
+        checksum ^= ((uint8_t *)words)[i];
+        checksum *= 1099511628211ULL;
+    }
+    numWrites++;
+
+    if (!quiet && ui32Width != *last)
+    {
+        printf("%u %s %u/%u\n", currentTick,
+               (ui32Base == PWM0_BASE) ? "MAIN" : "TAIL", ui32Width, ui32Period);
+    }
+    *last = ui32Width;
+}
+
+
+// *******************************************************
+// printTransitions:    Prints the mode transitions logged since the last
+//                      call, with the time from their event to the change
+static void printTransitions(void)
+{
+    static uint32_t printed;
+    uint32_t count = getModeTransitionCount();
+    const smLogEntry_t *entry;
+
+    for ( ; printed < count; printed++)
+    {
+        entry = getModeTransition(count - 1 - printed);
+        if (!quiet && entry != NULL)
+        {
+            printf("%u MODE %u->%u event %u latency %u ms\n", (unsigned)entry->time,
+                   entry->from, entry->to, entry->event, entry->latency);
+        }
+    }
+}
+
+
+static void addEvent(uint32_t tick, uint8_t type, uint8_t arg, int32_t value)
+{
+    if (numEvents == maxEvents)
+    {
+        maxEvents = maxEvents ? maxEvents * 2 : 1024;
+        events = realloc(events, maxEvents * sizeof(event_t));
+        if (events == NULL)
+        {
+            fprintf(stderr, "replay: out of memory\n");
+            exit(1);
+        }
+    }
+    events[numEvents].tick = tick;
+    events[numEvents].seq = (uint32_t)numEvents;
+    events[numEvents].type = type;
+    events[numEvents].arg = arg;
+    events[numEvents].value = value;
+    numEvents++;
+}
+
+
+static int compareEvents(const void *a, const void *b)
+{
+    const event_t *ea = a, *eb = b;
+    if (ea->tick != eb->tick)
+    {
+        return (ea->tick < eb->tick) ? -1 : 1;
+    }
+    if (ea->seq != eb->seq)
+    {
+        return (ea->seq < eb->seq) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+// *******************************************************
+// loadLog:             Parses a log file into the event list
+static void loadLog(FILE *file)
+{
+    static const char *buttons[NUM_BUTS] = {"UP", "DOWN", "LEFT", "RIGHT"};
+    char line[MAX_LINE], name[16], arg[16];
+    uint32_t tick, bbLast = 0, bbBase = 0;
+    int lineNum = 0;
+    long value;
+    int i, type, aux, v0, v1, n;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNum++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+
+        if (sscanf(line, "BB %u %d %d %d %d", &tick, &type, &aux, &v0, &v1) == 5)
+        {
+            // Black box time stamps are the low 16 bits of the tick count
+            if (tick < bbLast)
+            {
+                bbBase += 0x10000;
+            }
+            bbLast = tick;
+            if (type == BB_ADC)
+            {
+                addEvent(bbBase + tick, EV_ADC_SUM, 0, (uint16_t)v0);
+            } else if (type == BB_YAW) {
+                addEvent(bbBase + tick, EV_SLOT, 0, v0);
+            }
+            continue;
+        }
+
+        n = sscanf(line, "%u %15s %15s %ld", &tick, name, arg, &value);
+        if (n >= 2 && strcmp(name, "REF") == 0)
+        {
+            addEvent(tick, EV_REF, 0, 0);
+        } else if (n >= 3 && strcmp(name, "ADC") == 0) {
+            addEvent(tick, EV_ADC, 0, atol(arg));
+        } else if (n >= 3 && strcmp(name, "ENC") == 0) {
+            addEvent(tick, EV_ENC, 0, atol(arg) & 3);
+        } else if (n >= 3 && strcmp(name, "SLOT") == 0) {
+            addEvent(tick, EV_SLOT, 0, atol(arg));
+        } else if (n >= 3 && strcmp(name, "SW") == 0) {
+            addEvent(tick, EV_SW, 0, atol(arg) != 0);
+        } else if (n >= 3 && strcmp(name, "RST") == 0) {
+            addEvent(tick, EV_RST, 0, atol(arg) != 0);
+        } else if (n == 4 && strcmp(name, "BTN") == 0) {
+            for (i = 0; i < NUM_BUTS && strcmp(arg, buttons[i]) != 0; i++)
+            {
+            }
+            if (i == NUM_BUTS)
+            {
+                fprintf(stderr, "replay: line %d: unknown button %s\n", lineNum, arg);
+                exit(1);
+            }
+            addEvent(tick, EV_BTN, i, value != 0);
+        } else {
+            fprintf(stderr, "replay: line %d: cannot parse: %s", lineNum, line);
+            exit(1);
+        }
+    }
+
+    qsort(events, numEvents, sizeof(event_t), compareEvents);
+}
+
+
+// *******************************************************
+// setEncoder:          Drives PB0/PB1 to a quadrature state one pin at a time,
+//                      so each change raises its own edge interrupt
+static void setEncoder(uint8_t state)
+{
+    uint8_t current = halGetPins(GPIO_PORTB_BASE) & 3;
+    uint8_t changed = current ^ state;
+
+    if (changed & GPIO_PIN_0)
+    {
+        halSetPins(GPIO_PORTB_BASE, GPIO_PIN_0, state & GPIO_PIN_0);
+    }
+    if (changed & GPIO_PIN_1)
+    {
+        halSetPins(GPIO_PORTB_BASE, GPIO_PIN_1, state & GPIO_PIN_1);
+    }
+}
+
+
+static void applyEvent(const event_t *event)
+{
+    static const uint32_t butPorts[NUM_BUTS] = {UP_BUT_PORT_BASE,
+        DOWN_BUT_PORT_BASE, LEFT_BUT_PORT_BASE, RIGHT_BUT_PORT_BASE};
+    static const uint8_t butPins[NUM_BUTS] = {UP_BUT_PIN, DOWN_BUT_PIN,
+        LEFT_BUT_PIN, RIGHT_BUT_PIN};
+    static const bool butNormal[NUM_BUTS] = {UP_BUT_NORMAL, DOWN_BUT_NORMAL,
+        LEFT_BUT_NORMAL, RIGHT_BUT_NORMAL};
+    uint8_t state;
+
+    switch (event->type)
+    {
+    case EV_ADC:
+        halSetAdc(event->value);
+        ADCIntHandler();
+        break;
+    case EV_ADC_SUM:
+        halSetAdcSum(event->value, ADC_STEPS);
+        ADCIntHandler();
+        break;
+    case EV_ENC:
+        setEncoder(event->value);
+        break;
+    case EV_SLOT:
+        while (encSlot != event->value)
+        {
+            state = halGetPins(GPIO_PORTB_BASE) & 3;
+            if (encSlot < event->value)
+            {
+                setEncoder(cwNext[state]);
+                encSlot++;
+            } else {
+                setEncoder(ccwNext[state]);
+                encSlot--;
+            }
+        }
+        break;
+    case EV_REF:
+        halSetPins(GPIO_PORTC_BASE, GPIO_PIN_4, false);
+        halSetPins(GPIO_PORTC_BASE, GPIO_PIN_4, true);
+        break;
+    case EV_SW:
+        halSetPins(GPIO_PORTA_BASE, GPIO_PIN_7, event->value);
+        break;
+    case EV_RST:
+        halSetPins(GPIO_PORTA_BASE, GPIO_PIN_6, !event->value);
+        break;
+    case EV_BTN:
+        halSetPins(butPorts[event->arg], butPins[event->arg],
+                   event->value ? !butNormal[event->arg] : butNormal[event->arg]);
+        break;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t tail = DEFAULT_TAIL, endTick, adcReadyAt = 0, sample;
+    struct timespec start, stop;
+    size_t next = 0;
+    double wall;
+    deadlineStats_t deadline;
+    FILE *file;
+    int argi;
+
+    for (argi = 1; argi < argc - 1; argi++)
+    {
+        if (strcmp(argv[argi], "-q") == 0)
+        {
+            quiet = true;
+        } else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc - 1) {
+            tail = atoi(argv[++argi]);
+        } else {
+            break;
+        }
+    }
+    if (argi != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-q] [-t tail_ms] log.txt\n", argv[0]);
+        return 2;
+    }
+    file = fopen(argv[argi], "r");
+    if (file == NULL)
+    {
+        perror(argv[argi]);
+        return 2;
+    }
+    loadLog(file);
+    fclose(file);
+    endTick = (numEvents ? events[numEvents - 1].tick : 0) + tail;
+
+    // Power on levels: switch down, buttons released, PC4 and PA6 pulled up
+    halReset();
+    rtosReset();
+    halSetPwmHook(pwmWritten);
+    halSetPins(GPIO_PORTF_BASE, LEFT_BUT_PIN | RIGHT_BUT_PIN, true);
+    halSetPins(GPIO_PORTC_BASE, GPIO_PIN_4, true);
+    halSetPins(GPIO_PORTA_BASE, GPIO_PIN_6, true);
+
+    // Same bring up order as main()
+    initPerf();
+    initBlackBox();
+    initLowPower();
+    bootEnablePeripherals();
+    initADC();
+    initYaw();
+    initmotor();
+    initMotorOutput();
+    initTorqueFF();
+    initialiseUSB_UART();
+    resetAltitude();
+    initButtons();
+    initSwitch_PC4();
+    IntMasterEnable();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (currentTick = 0; currentTick <= endTick; currentTick++)
+    {
+        rtosSetTick(currentTick);
+
+        // Interrupt sources first, in log order
+        while (next < numEvents && events[next].tick == currentTick)
+        {
+            applyEvent(&events[next++]);
+        }
+
+        // Then the tasks in priority order
+        if (currentTick >= adcReadyAt &&
+            xQueueReceive(xADCQueue, &sample, 0) == pdTRUE)
+        {
+            if (updateAltitude(sample))
+            {
+                updateControl();
+                printTransitions();
+            }
+            adcReadyAt = currentTick + ADC_TASK_DELAY;
+        }
+
+        if (halResetRequested())
+        {
+            printf("%u RESET\n", currentTick);
+            break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    wall = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+    fprintf(stderr, "replay: %zu events, %u ms simulated in %.3f ms (%.0fx real time)\n",
+            numEvents, endTick, wall * 1e3, wall > 0 ? endTick / (wall * 1e3) : 0.0);
+    deadlineGetStats(&deadline);
+    fprintf(stderr, "replay: %u control cycles, %u period and %u exec misses, "
+            "%u stalls, worst period %u ms\n", deadline.cycles, deadline.periodMisses,
+            deadline.execMisses, deadline.stalls, deadline.worstPeriodMs);
+    printf("# writes %u checksum %016llx\n", numWrites, (unsigned long long)checksum);
+    free(events);
+    return 0;
+}
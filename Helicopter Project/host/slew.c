@@ -0,0 +1,302 @@
+//*****************************************************************************
+//
+// slew - Host test of the motorOutput stage. Targets are set on a context's
+//        rotors and the output is applied every control period, recording
+//        each duty pair the pwm hook is given, and checked: spin up and spin
+//        down never beat the per-mille per second limits, a soft start ramps
+//        at SOFT_START_SLEW and stops exactly on its end duty, and both
+//        rotors are always committed together, once per apply that moved
+//        either and never otherwise.
+//
+//          Usage:  slew [-v]
+//
+//          -v          print every scenario, not only failures
+//
+//          The exit status is 0 if every scenario passes.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heliContext.h"
+
+#define PERIOD_MS           10      // As the control task
+#define MAX_COMMITS         1024
+
+// *******************************************************
+// The duty pairs the pwm hook was given since the last apply
+typedef struct {
+    uint32_t main[MAX_COMMITS], tail[MAX_COMMITS];
+    uint32_t count;
+} commits_t;
+
+// *******************************************************
+// A context with its rotors in a known state and the commits it made
+typedef struct {
+    HeliContext heli;
+    commits_t commits;
+    const char *scenario;
+    uint32_t ms;
+    bool passed;
+} rig_t;
+
+
+// *******************************************************
+// drivePWM:            The pwm hook, recording the pair
+static void drivePWM(HeliContext *heli, uint32_t mainPermille, uint32_t tailPermille)
+{
+    commits_t *commits = &((rig_t *)heli->user)->commits;
+
+    if (commits->count < MAX_COMMITS)
+    {
+        commits->main[commits->count] = mainPermille;
+        commits->tail[commits->count] = tailPermille;
+    }
+    commits->count++;
+}
+
+static const heliHooks_t hooks = {drivePWM, NULL, NULL, NULL, NULL};
+
+
+// *******************************************************
+// fail:                Records a failed check of the current scenario
+static void fail(rig_t *rig, const char *what, int32_t got, int32_t expected)
+{
+    printf("slew: %s: at %u ms %s %d, expected %d\n", rig->scenario,
+           (unsigned)rig->ms, what, (int)got, (int)expected);
+    rig->passed = false;
+}
+
+
+// *******************************************************
+// rigInit:             Puts the rig at rest at the start of a scenario
+static void rigInit(rig_t *rig, const char *scenario)
+{
+    memset(rig, 0, sizeof(*rig));
+    rig->scenario = scenario;
+    rig->passed = true;
+    heliInit(&rig->heli, &hooks, rig);
+}
+
+
+// *******************************************************
+// expect:              Checks a duty or count against what it should be
+static void expect(rig_t *rig, const char *what, int32_t got, int32_t expected)
+{
+    if (got != expected)
+    {
+        fail(rig, what, got, expected);
+    }
+}
+
+
+// *******************************************************
+// apply:               Applies the output once and checks the commit: one
+//                      pair if either rotor moved, carrying both current
+//                      duties, none if neither moved, and neither rotor
+//                      moving faster than its limit
+// TAKES:               rig, the rig
+//                      mainLimit, tailLimit, the most either may move in the
+//                      period, per-mille
+static void apply(rig_t *rig, int32_t mainLimit, int32_t tailLimit)
+{
+    HeliContext *heli = &rig->heli;
+    int32_t main = heliMotorOutputGetMain(heli), tail = heliMotorOutputGetTail(heli);
+    bool moved;
+
+    rig->commits.count = 0;
+    rig->ms += PERIOD_MS;
+    heliMotorOutputApply(heli, PERIOD_MS);
+    moved = heliMotorOutputGetMain(heli) != main || heliMotorOutputGetTail(heli) != tail;
+
+    if (rig->commits.count != (moved ? 1u : 0u))
+    {
+        fail(rig, "commits", rig->commits.count, moved ? 1 : 0);
+    } else if (moved) {
+        expect(rig, "committed main", rig->commits.main[0], heliMotorOutputGetMain(heli));
+        expect(rig, "committed tail", rig->commits.tail[0], heliMotorOutputGetTail(heli));
+    }
+    if (abs(heliMotorOutputGetMain(heli) - main) > mainLimit)
+    {
+        fail(rig, "main moved", heliMotorOutputGetMain(heli) - main, mainLimit);
+    }
+    if (abs(heliMotorOutputGetTail(heli) - tail) > tailLimit)
+    {
+        fail(rig, "tail moved", heliMotorOutputGetTail(heli) - tail, tailLimit);
+    }
+}
+
+
+// *******************************************************
+// limit:               RETURNS the most a rate moves a rotor in one period
+static int32_t limit(int32_t rate)
+{
+    return rate * PERIOD_MS / 1000;
+}
+
+
+// *******************************************************
+// Scenarios
+
+// Both rotors spin up then down at their own limits, the main rotor at half
+// the tail's rate
+static bool slewLimits(rig_t *rig)
+{
+    HeliContext *heli = &rig->heli;
+    int i;
+
+    rigInit(rig, "slew up and down");
+    heliMotorOutputSetMain(heli, 600);
+    heliMotorOutputSetTail(heli, 600);
+    for (i = 0; i < 100; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_UP), limit(TAIL_SLEW_UP));
+    }
+    expect(rig, "main after 1 s up", heliMotorOutputGetMain(heli), MAIN_SLEW_UP);
+    expect(rig, "tail after 1 s up", heliMotorOutputGetTail(heli), 600);
+    for (i = 0; i < 20; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_UP), limit(TAIL_SLEW_UP));
+    }
+    expect(rig, "main at target", heliMotorOutputGetMain(heli), 600);
+
+    heliMotorOutputSetMain(heli, 0);
+    heliMotorOutputSetTail(heli, 100);
+    for (i = 0; i < 30; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_DOWN), limit(TAIL_SLEW_DOWN));
+    }
+    expect(rig, "main after 0.3 s down", heliMotorOutputGetMain(heli),
+           600 - 3 * MAIN_SLEW_DOWN / 10);
+    expect(rig, "tail after 0.3 s down", heliMotorOutputGetTail(heli),
+           600 - 3 * TAIL_SLEW_DOWN / 10);
+    for (i = 0; i < 30; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_DOWN), limit(TAIL_SLEW_DOWN));
+    }
+    expect(rig, "main at rest", heliMotorOutputGetMain(heli), 0);
+    expect(rig, "tail at target", heliMotorOutputGetTail(heli), 100);
+    return rig->passed;
+}
+
+// A step shorter than a per-mille's worth of the rate still moves one
+static bool shortStep(rig_t *rig)
+{
+    HeliContext *heli = &rig->heli;
+
+    rigInit(rig, "short step");
+    heliMotorOutputSoftStart(heli, 100, 0);
+    heliMotorOutputApply(heli, 1);
+    expect(rig, "main after 1 ms", heliMotorOutputGetMain(heli), 1);
+    expect(rig, "tail after 1 ms", heliMotorOutputGetTail(heli), 0);
+    return rig->passed;
+}
+
+// A soft start ramps both rotors at SOFT_START_SLEW, each stopping exactly
+// on its own end duty, after which a higher target uses the normal rate
+static bool softStart(rig_t *rig)
+{
+    HeliContext *heli = &rig->heli;
+    int i;
+
+    rigInit(rig, "soft start");
+    heliMotorOutputSoftStart(heli, 405, 293);
+    for (i = 0; i < 100; i++)
+    {
+        apply(rig, limit(SOFT_START_SLEW), limit(SOFT_START_SLEW));
+    }
+    expect(rig, "main after 1 s", heliMotorOutputGetMain(heli), SOFT_START_SLEW);
+    expect(rig, "tail after 1 s", heliMotorOutputGetTail(heli), SOFT_START_SLEW);
+    for (i = 0; i < 47; i++)
+    {
+        apply(rig, limit(SOFT_START_SLEW), limit(SOFT_START_SLEW));
+    }
+    expect(rig, "tail at its end duty", heliMotorOutputGetTail(heli), 293);
+    for (i = 0; i < 60; i++)
+    {
+        apply(rig, limit(SOFT_START_SLEW), limit(SOFT_START_SLEW));
+    }
+    expect(rig, "main at its end duty", heliMotorOutputGetMain(heli), 405);
+    expect(rig, "tail held", heliMotorOutputGetTail(heli), 293);
+
+    heliMotorOutputSetMain(heli, 505);
+    for (i = 0; i < 10; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_UP), 0);
+    }
+    expect(rig, "main 0.1 s after the soft start", heliMotorOutputGetMain(heli),
+           405 + MAIN_SLEW_UP / 10);
+    return rig->passed;
+}
+
+// A stop commits both rotors at rest at once, and a target change on one
+// rotor commits the pair with the other's duty unchanged
+static bool jointCommit(rig_t *rig)
+{
+    HeliContext *heli = &rig->heli;
+    int i;
+
+    rigInit(rig, "joint commit");
+    heliMotorOutputSetMain(heli, 300);
+    heliMotorOutputSetTail(heli, 300);
+    for (i = 0; i < 60; i++)
+    {
+        apply(rig, limit(MAIN_SLEW_UP), limit(TAIL_SLEW_UP));
+    }
+    heliMotorOutputSetTail(heli, 250);
+    apply(rig, 0, limit(TAIL_SLEW_DOWN));
+    expect(rig, "main committed beside the tail", rig->commits.main[0], 300);
+    expect(rig, "tail committed", rig->commits.tail[0], 300 - limit(TAIL_SLEW_DOWN));
+    for (i = 0; i < 4; i++)
+    {
+        apply(rig, 0, limit(TAIL_SLEW_DOWN));
+    }
+    expect(rig, "tail at target", heliMotorOutputGetTail(heli), 250);
+    apply(rig, 0, 0);
+
+    rig->commits.count = 0;
+    heliMotorOutputStop(heli);
+    expect(rig, "commits on stop", rig->commits.count, 1);
+    expect(rig, "main committed on stop", rig->commits.main[0], 0);
+    expect(rig, "tail committed on stop", rig->commits.tail[0], 0);
+    apply(rig, 0, 0);
+    return rig->passed;
+}
+
+static bool (*const scenarios[])(rig_t *rig) = {
+    slewLimits, shortStep, softStart, jointCommit,
+};
+#define NUM_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+
+int main(int argc, char *argv[])
+{
+    static rig_t rig;
+    bool verbose = false, passed;
+    uint32_t i, failures = 0;
+
+    if (argc == 2 && strcmp(argv[1], "-v") == 0)
+    {
+        verbose = true;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+        return 2;
+    }
+
+    for (i = 0; i < NUM_SCENARIOS; i++)
+    {
+        passed = scenarios[i](&rig);
+        if (verbose || !passed)
+        {
+            printf("%-32s %s\n", rig.scenario, passed ? "ok" : "FAILED");
+        }
+        failures += !passed;
+    }
+
+    printf("# slew: %u scenarios, %u failed\n", (unsigned)NUM_SCENARIOS,
+           (unsigned)failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+//*****************************************************************************
+//
+// twin - Flies helicopter contexts side by side in one process, each
+//        against its own model of the rig, and checks they are independent.
+//        Each context is driven only through the heli* API and its hooks:
+//        the owner gives it ADC samples, encoder edges, the yaw reference,
+//        SW1 and its buttons, and runs its control cycle whenever it has a
+//        new altitude. Nothing of the firmware's global API, tasks or
+//        hardware is used.
+//
+//        Each flight is first flown alone, then both are flown together in
+//        the same millisecond loop, the second stepped first, then
+//        NUM_THREADS contexts, taking the flights in turn, are flown at once
+//        each on its own thread, locked by its own mutex. Every control
+//        cycle of a flight goes into a checksum, which must be the same side
+//        by side and on a thread as alone. Every flight must take off and
+//        land.
+//
+//          Usage:  twin [-v]
+//
+//          -v          print each mode change
+//
+//          The exit status is 0 if every check passes.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "buttons4.h"
+#include "heliContext.h"
+
+#define NUM_TWINS           2
+#define NUM_THREADS         8
+#define MAX_PRESSES         4
+#define FLIGHT_MS           40000
+#define ADC_PERIOD_MS       30      // As vADCSampleTask
+#define SWITCH_TIMER_MS     500     // As control.c's MODE_CHANGE_TIME
+
+#define HOVER               45.0    // Main duty %, as flight.c's rig
+#define TORQUE_RATIO        0.778
+#define ALT_GAIN            3.0
+#define ALT_DRAG            1.5
+#define YAW_GAIN            6.0
+#define YAW_DRAG            3.0
+#define ENC_SLOTS           448
+#define COUNTS_PER_PERCENT  (1000.0 * 4095 / 3300 / 100)
+
+// *******************************************************
+// One flight: when SW1 goes up and down, the buttons pressed in between,
+// and where the rig starts
+typedef struct {
+    const char *name;
+    uint32_t switchUpMs, switchDownMs;
+    struct {
+        uint32_t atMs;
+        uint8_t button;
+    } presses[MAX_PRESSES];
+    uint8_t numPresses;
+    double startYaw;                // deg from the reference
+    int32_t ground;                 // ADC counts on the ground
+    uint32_t adcPhaseMs;            // First ADC sample
+} script_t;
+
+// *******************************************************
+// A context and the rig it flies
+typedef struct {
+    HeliContext heli;
+    const script_t *script;
+    double alt, altVel;             // %, %/s
+    double yaw, yawVel;             // deg, deg/s, from the reference
+    double main, tail;              // Duty % the pwm hook last set
+    int32_t slot;                   // Encoder edges issued
+    uint8_t encState;
+    uint32_t noise;
+    uint8_t pending;                // Buttons pressed, one bit each
+    uint32_t timerDueMs;            // Switch timer, 0 when stopped
+    uint8_t nextPress;
+    const char *lastMode;
+    bool flew;
+    uint64_t checksum;
+    uint32_t cycles;
+    pthread_mutex_t mutex;          // The lock, when flown on a thread
+} twin_t;
+
+static const script_t scripts[NUM_TWINS] = {
+    {"first", 1000, 25000, {{9000, UP}, {10000, UP}, {14000, LEFT}}, 3,
+     -30.0, 2000, 0},
+    {"second", 2500, 34000, {{20000, DOWN}, {24000, RIGHT}, {25000, RIGHT}}, 3,
+     -120.0, 2300, 10},
+};
+
+// Clockwise and anticlockwise successor of each quadrature state
+static const uint8_t cwNext[4] = {2, 0, 3, 1};
+static const uint8_t ccwNext[4] = {1, 3, 0, 2};
+
+static bool verbose = false;
+
+
+// *******************************************************
+// Hooks, each finding its rig through the context's user pointer
+
+static void drivePWM(HeliContext *heli, uint32_t mainPermille, uint32_t tailPermille)
+{
+    twin_t *twin = heli->user;
+
+    twin->main = mainPermille / 10.0;
+    twin->tail = tailPermille / 10.0;
+}
+
+static uint8_t readButton(HeliContext *heli, uint8_t button)
+{
+    twin_t *twin = heli->user;
+
+    if (twin->pending & (1 << button))
+    {
+        twin->pending &= ~(1 << button);
+        return PUSHED;
+    }
+    return NO_CHANGE;
+}
+
+static void startSwitchTimer(HeliContext *heli, TickType_t now)
+{
+    twin_t *twin = heli->user;
+
+    twin->timerDueMs = now * portTICK_PERIOD_MS + SWITCH_TIMER_MS;
+}
+
+static void lockTwin(HeliContext *heli)
+{
+    twin_t *twin = heli->user;
+
+    pthread_mutex_lock(&twin->mutex);
+}
+
+static void unlockTwin(HeliContext *heli)
+{
+    twin_t *twin = heli->user;
+
+    pthread_mutex_unlock(&twin->mutex);
+}
+
+static const heliHooks_t hooks = {drivePWM, readButton, startSwitchTimer, NULL, NULL};
+
+static const heliHooks_t threadHooks = {drivePWM, readButton, startSwitchTimer, NULL, NULL,
+                                        lockTwin, unlockTwin, NULL};
+
+
+// *******************************************************
+// mix:                 Adds a word to a checksum
+static void mix(uint64_t *checksum, uint32_t word)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(word); i++)
+    {
+        *checksum ^= (word >> (8 * i)) & 0xff;
+        *checksum *= 1099511628211ULL;
+    }
+}
+
+
+// *******************************************************
+// twinInit:            Puts a rig at its start and its context at power on
+// TAKES:               hooks, the context's hooks
+static void twinInit(twin_t *twin, const script_t *script, const heliHooks_t *hooks)
+{
+    memset(twin, 0, sizeof(*twin));
+    twin->script = script;
+    twin->yaw = script->startYaw;
+    twin->slot = (int32_t)floor(script->startYaw * ENC_SLOTS / 360.0);
+    twin->lastMode = "";
+    twin->checksum = 14695981039346656037ULL;
+    pthread_mutex_init(&twin->mutex, NULL);
+    heliInit(&twin->heli, hooks, twin);
+}
+
+
+// *******************************************************
+// adcSample:           RETURNS the rig's altitude as a summed ADC sample
+static uint32_t adcSample(twin_t *twin)
+{
+    uint32_t sample = 0;
+    int32_t counts;
+    int i;
+
+    for (i = 0; i < ADC_STEPS; i++)
+    {
+        twin->noise = twin->noise * 1103515245 + 12345;
+        counts = twin->script->ground - (int32_t)(twin->alt * COUNTS_PER_PERCENT + 0.5) +
+                 (int32_t)((twin->noise >> 16) % 5) - 2;
+        sample += counts < 0 ? 0 : counts > 4095 ? 4095 : counts;
+    }
+    return sample;
+}
+
+
+// *******************************************************
+// issueEdges:          Gives the context the encoder edges, and the yaw
+//                      reference, the rig passed in the last step
+static void issueEdges(twin_t *twin, TickType_t now)
+{
+    int32_t target = (int32_t)floor(twin->yaw * ENC_SLOTS / 360.0);
+    int32_t boundary;
+
+    while (twin->slot != target)
+    {
+        boundary = twin->slot + (target > twin->slot ? 1 : 0);
+        if (target > twin->slot)
+        {
+            twin->encState = cwNext[twin->encState];
+            twin->slot++;
+        } else {
+            twin->encState = ccwNext[twin->encState];
+            twin->slot--;
+        }
+        heliYawEdge(&twin->heli, twin->encState);
+        if (boundary % ENC_SLOTS == 0)
+        {
+            heliRefFound(&twin->heli, heliYawSlot(&twin->heli), now);
+        }
+    }
+}
+
+
+// *******************************************************
+// twinStep:            Moves a rig and its context on one millisecond
+static void twinStep(twin_t *twin, uint32_t ms)
+{
+    const script_t *script = twin->script;
+    HeliContext *heli = &twin->heli;
+    TickType_t now = ms / portTICK_PERIOD_MS;
+    const double dt = 0.001;
+    const char *mode;
+
+    twin->altVel += (ALT_GAIN * (twin->main - HOVER) - ALT_DRAG * twin->altVel) * dt;
+    twin->alt += twin->altVel * dt;
+    if (twin->alt <= 0)
+    {
+        twin->alt = 0;
+        twin->altVel = twin->altVel < 0 ? 0 : twin->altVel;
+    } else if (twin->alt >= 100) {
+        twin->alt = 100;
+        twin->altVel = twin->altVel > 0 ? 0 : twin->altVel;
+    }
+    twin->yawVel += (YAW_GAIN * (twin->tail - TORQUE_RATIO * twin->main) -
+                     YAW_DRAG * twin->yawVel) * dt;
+    twin->yaw += twin->yawVel * dt;
+    issueEdges(twin, now);
+
+    if (ms == script->switchUpMs || ms == script->switchDownMs)
+    {
+        heliSetSwitch(heli, ms == script->switchUpMs);
+    }
+    if (twin->nextPress < script->numPresses &&
+        ms == script->presses[twin->nextPress].atMs)
+    {
+        twin->pending |= 1 << script->presses[twin->nextPress++].button;
+    }
+    if (twin->timerDueMs != 0 && ms == twin->timerDueMs)
+    {
+        twin->timerDueMs = 0;
+        heliSwitchTimerExpired(heli, now);
+    }
+
+    if (ms % ADC_PERIOD_MS == script->adcPhaseMs && heliUpdateAltitude(heli, adcSample(twin)))
+    {
+        heliUpdateControl(heli, now);
+        twin->cycles++;
+        mix(&twin->checksum, ms);
+        mix(&twin->checksum, heli->ctl.heliModes.current);
+        mix(&twin->checksum, heliGetAltHundredths(heli));
+        mix(&twin->checksum, heliGetYawTotalHundredths(heli));
+        mix(&twin->checksum, heliGetMainPWMPermille(heli));
+        mix(&twin->checksum, heliGetTailPWMPermille(heli));
+    }
+
+    mode = heliGetMode(heli);
+    if (strcmp(mode, twin->lastMode) != 0)
+    {
+        if (verbose)
+        {
+            printf("%s %u MODE %s alt %.1f%% yaw %.1f deg\n", script->name,
+                   (unsigned)ms, mode, twin->alt, twin->yaw);
+        }
+        twin->flew |= strcmp(mode, "Flying") == 0;
+        twin->lastMode = mode;
+    }
+}
+
+
+// *******************************************************
+// flyThread:           Flies one rig the whole flight, once every thread
+//                      has started
+static pthread_barrier_t started;
+
+static void *flyThread(void *arg)
+{
+    twin_t *twin = arg;
+    uint32_t ms;
+
+    pthread_barrier_wait(&started);
+    for (ms = 1; ms <= FLIGHT_MS; ms++)
+    {
+        twinStep(twin, ms);
+    }
+    return NULL;
+}
+
+
+// *******************************************************
+// landed:              RETURNS true if the rig flew and is back on the
+//                      ground with its rotors stopped
+static bool landed(const twin_t *twin)
+{
+    return twin->flew && strcmp(twin->lastMode, "Landed") == 0 &&
+           twin->main == 0 && twin->tail == 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static twin_t alone[NUM_TWINS], together[NUM_TWINS], threaded[NUM_THREADS];
+    pthread_t threads[NUM_THREADS];
+    uint32_t ms, failures = 0;
+    int i;
+
+    if (argc == 2 && strcmp(argv[1], "-v") == 0)
+    {
+        verbose = true;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+        return 2;
+    }
+
+    for (i = 0; i < NUM_TWINS; i++)
+    {
+        twinInit(&alone[i], &scripts[i], &hooks);
+        for (ms = 1; ms <= FLIGHT_MS; ms++)
+        {
+            twinStep(&alone[i], ms);
+        }
+    }
+
+    for (i = 0; i < NUM_TWINS; i++)
+    {
+        twinInit(&together[i], &scripts[i], &hooks);
+    }
+    for (ms = 1; ms <= FLIGHT_MS; ms++)
+    {
+        for (i = NUM_TWINS - 1; i >= 0; i--)
+        {
+            twinStep(&together[i], ms);
+        }
+    }
+
+    pthread_barrier_init(&started, NULL, NUM_THREADS);
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        twinInit(&threaded[i], &scripts[i % NUM_TWINS], &threadHooks);
+        if (pthread_create(&threads[i], NULL, flyThread, &threaded[i]) != 0)
+        {
+            fprintf(stderr, "twin: cannot start thread %d\n", i);
+            return 2;
+        }
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < NUM_TWINS; i++)
+    {
+        printf("twin: %s: %u control cycles, checksum %016llx alone, %016llx side by side\n",
+               scripts[i].name, (unsigned)together[i].cycles,
+               (unsigned long long)alone[i].checksum,
+               (unsigned long long)together[i].checksum);
+        if (!landed(&alone[i]) || !landed(&together[i]))
+        {
+            printf("twin: %s: did not fly and land\n", scripts[i].name);
+            failures++;
+        }
+        if (alone[i].checksum != together[i].checksum)
+        {
+            printf("twin: %s: flew differently beside the other\n", scripts[i].name);
+            failures++;
+        }
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        if (!landed(&threaded[i]))
+        {
+            printf("twin: thread %d: did not fly and land\n", i);
+            failures++;
+        }
+        if (threaded[i].checksum != alone[i % NUM_TWINS].checksum)
+        {
+            printf("twin: thread %d: %s flew differently on a thread, checksum %016llx\n",
+                   i, scripts[i % NUM_TWINS].name,
+                   (unsigned long long)threaded[i].checksum);
+            failures++;
+        }
+    }
+    if (alone[0].checksum == alone[1].checksum)
+    {
+        printf("twin: both flights were the same\n");
+        failures++;
+    }
+
+    printf("# twin: %d contexts, %d on threads, %u failed checks\n",
+           NUM_TWINS, NUM_THREADS, (unsigned)failures);
+    return failures ? 1 : 0;
+}